@@ -0,0 +1,184 @@
+// ---------------------------------------------------------
+//
+//  ccd_backends.h
+//
+//  The collision and intersection query implementations behind ccd_wrapper.h.  Each backend lives in its own 
+//  namespace so both can be linked in and chosen at run time.  See ccd_wrapper.h for argument conventions.
+//
+// ---------------------------------------------------------
+
+#ifndef CCD_BACKENDS_H
+#define CCD_BACKENDS_H
+
+#include "vec.h"
+
+// --------------------------------------------------------------------------------------------------
+// Cubic solver: finds coplanarity times, then runs proximity tests with a small tolerance.  Fast, not exact.
+// --------------------------------------------------------------------------------------------------
+
+namespace cubic_ccd
+{
+    // Relative tolerance on the cubic solver for coplanarity times.  Roots within this of [0,1] are accepted, and the 
+    // batched coplanarity cull in ccd_batch.cpp pads its bound by it.
+
+    const double g_cubic_solver_tol = 1e-8;
+
+    // 2D continuous collision detection
+
+    bool point_segment_collision(const Vec2d& x0, const Vec2d& xnew0, size_t index0,
+                                 const Vec2d& x1, const Vec2d& xnew1, size_t index1,
+                                 const Vec2d& x2, const Vec2d& xnew2, size_t index2);
+
+    bool point_segment_collision(const Vec2d& x0, const Vec2d& xnew0, size_t index0,
+                                 const Vec2d& x1, const Vec2d& xnew1, size_t index1,
+                                 const Vec2d& x2, const Vec2d& xnew2, size_t index2,
+                                 double& edge_alpha, Vec2d& normal, double& rel_disp);
+    
+    // 2D static intersection detection
+
+    bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                      const Vec2d& x1, size_t index1,
+                                      const Vec2d& x2, size_t index2,
+                                      const Vec2d& x3, size_t index3);
+
+    bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                      const Vec2d& x1, size_t index1,
+                                      const Vec2d& x2, size_t index2,
+                                      const Vec2d& x3, size_t index3,
+                                      double &s0, double& s2 );
+
+    // 3D continuous collision detection
+
+    bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                  const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                  const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                  const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
+    bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                  const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                  const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                  const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                                  double& bary1, double& bary2, double& bary3,
+                                  Vec3d& normal,
+                                  double& relative_normal_displacement );
+
+    bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                   const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                   const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                   const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
+    bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                   const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                   const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                   const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                                   double& bary0, double& bary2,
+                                   Vec3d& normal,
+                                   double& relative_normal_displacement );
+
+    // 3D static intersection detection
+
+    bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                       const Vec3d& x1, size_t index1,
+                                       const Vec3d& x2, size_t index2,
+                                       const Vec3d& x3, size_t index3,
+                                       const Vec3d& x4, size_t index4,
+                                       bool degenerate_counts_as_intersection,
+                                       bool verbose );
+
+    bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                       const Vec3d& x1, size_t index1,
+                                       const Vec3d& x2, size_t index2,
+                                       const Vec3d& x3, size_t index3,
+                                       const Vec3d& x4, size_t index4,
+                                       double& bary0, double& bary1, double& bary2, double& bary3, double& bary4,
+                                       bool degenerate_counts_as_intersection,
+                                       bool verbose );
+
+    bool point_tetrahedron_intersection(const Vec3d& x0, size_t index0,
+                                        const Vec3d& x1, size_t index1,
+                                        const Vec3d& x2, size_t index2,
+                                        const Vec3d& x3, size_t index3,
+                                        const Vec3d& x4, size_t index4);
+}
+
+// --------------------------------------------------------------------------------------------------
+// Root parity: exact, using interval and expansion arithmetic.  No 2D continuous queries.
+// --------------------------------------------------------------------------------------------------
+
+namespace root_parity_ccd
+{
+    // 2D static intersection detection
+
+    bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                      const Vec2d& x1, size_t index1,
+                                      const Vec2d& x2, size_t index2,
+                                      const Vec2d& x3, size_t index3);
+
+    bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                      const Vec2d& x1, size_t index1,
+                                      const Vec2d& x2, size_t index2,
+                                      const Vec2d& x3, size_t index3,
+                                      double &s0, double& s2 );
+
+    // 3D continuous collision detection
+
+    bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                  const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                  const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                  const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
+    bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                  const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                  const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                  const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                                  double& bary1, double& bary2, double& bary3,
+                                  Vec3d& normal,
+                                  double& relative_normal_displacement );
+
+    bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                   const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                   const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                   const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
+    bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                                   const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                                   const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                                   const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                                   double& bary0, double& bary2,
+                                   Vec3d& normal,
+                                   double& relative_normal_displacement );
+
+    // The 3D continuous queries first try a floating-point separating plane test, and only build a 
+    // RootParityCollisionTest if it fails.  These report how many queries were made and how many the prefilter answered,
+    // counted over all threads since the last reset.  Don't call them while queries are running.
+
+    void get_prefilter_counts( size_t& num_queries, size_t& num_culled );
+    void reset_prefilter_counts();
+
+    // 3D static intersection detection
+
+    bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                       const Vec3d& x1, size_t index1,
+                                       const Vec3d& x2, size_t index2,
+                                       const Vec3d& x3, size_t index3,
+                                       const Vec3d& x4, size_t index4,
+                                       bool degenerate_counts_as_intersection,
+                                       bool verbose );
+
+    bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                       const Vec3d& x1, size_t index1,
+                                       const Vec3d& x2, size_t index2,
+                                       const Vec3d& x3, size_t index3,
+                                       const Vec3d& x4, size_t index4,
+                                       double& bary0, double& bary1, double& bary2, double& bary3, double& bary4,
+                                       bool degenerate_counts_as_intersection,
+                                       bool verbose );
+
+    bool point_tetrahedron_intersection(const Vec3d& x0, size_t index0,
+                                        const Vec3d& x1, size_t index1,
+                                        const Vec3d& x2, size_t index2,
+                                        const Vec3d& x3, size_t index3,
+                                        const Vec3d& x4, size_t index4);
+}
+
+#endif
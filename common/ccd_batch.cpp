@@ -0,0 +1,133 @@
+// ---------------------------------------------------------
+//
+//  ccd_batch.cpp
+//
+//  Batched early-out tests for continuous collision detection candidates.
+//
+// ---------------------------------------------------------
+
+#include "ccd_batch.h"
+
+#include "ccd_backends.h"
+#include <cmath>
+
+namespace
+{
+    using cubic_ccd::g_cubic_solver_tol;
+
+    /// The cubic solver accepts roots slightly outside [0,1], so bound the coplanarity polynomial on [-pad, 1+pad]
+    ///
+    const double g_time_pad = 1e-6;
+
+    /// Rounding error allowances, relative to cubed coordinate magnitudes.  signed_volume() works on absolute coordinates,
+    /// so its error scales with their size; the cubic coefficients are formed from differences.
+    ///
+    const double g_absolute_error_factor = 1e-11;
+    const double g_relative_error_factor = 1e-12;
+
+    /// p . (q x r)
+    ///
+    inline double triple( double px, double py, double pz, double qx, double qy, double qz, double rx, double ry, double rz )
+    {
+        return px * ( qy * rz - qz * ry ) + py * ( qz * rx - qx * rz ) + pz * ( qx * ry - qy * rx );
+    }
+}
+
+
+// --------------------------------------------------------
+///
+/// The coplanarity function of the four trajectories is the cubic A*t^3 + B*t^2 + C*t + D (the same coefficients the cubic
+/// solver computes).  Expressed in the Bernstein basis over the padded time interval, the polynomial lies within the range
+/// of its four Bernstein coefficients, so if they all have the same sign and are further from zero than any tolerance or
+/// rounding error, no root exists.
+///
+/// Written branch-free over the lanes so the compiler can vectorize it.
+///
+// --------------------------------------------------------
+
+void batch_coplanarity_cull( const CCDBatch& batch, unsigned char* may_be_coplanar )
+{
+    const double a = -g_time_pad;
+    const double h = 1.0 + 2.0 * g_time_pad;
+
+    // computed as doubles so every value in the loop has the same width
+    double keep[CCD_BATCH_WIDTH];
+
+    #pragma omp simd
+    for ( unsigned int i = 0; i < CCD_BATCH_WIDTH; ++i )
+    {
+        // positions and displacements relative to vertex 3
+
+        const double x03x = batch.m_x[0][0][i] - batch.m_x[3][0][i];
+        const double x03y = batch.m_x[0][1][i] - batch.m_x[3][1][i];
+        const double x03z = batch.m_x[0][2][i] - batch.m_x[3][2][i];
+        const double x13x = batch.m_x[1][0][i] - batch.m_x[3][0][i];
+        const double x13y = batch.m_x[1][1][i] - batch.m_x[3][1][i];
+        const double x13z = batch.m_x[1][2][i] - batch.m_x[3][2][i];
+        const double x23x = batch.m_x[2][0][i] - batch.m_x[3][0][i];
+        const double x23y = batch.m_x[2][1][i] - batch.m_x[3][1][i];
+        const double x23z = batch.m_x[2][2][i] - batch.m_x[3][2][i];
+
+        const double v03x = ( batch.m_xnew[0][0][i] - batch.m_xnew[3][0][i] ) - x03x;
+        const double v03y = ( batch.m_xnew[0][1][i] - batch.m_xnew[3][1][i] ) - x03y;
+        const double v03z = ( batch.m_xnew[0][2][i] - batch.m_xnew[3][2][i] ) - x03z;
+        const double v13x = ( batch.m_xnew[1][0][i] - batch.m_xnew[3][0][i] ) - x13x;
+        const double v13y = ( batch.m_xnew[1][1][i] - batch.m_xnew[3][1][i] ) - x13y;
+        const double v13z = ( batch.m_xnew[1][2][i] - batch.m_xnew[3][2][i] ) - x13z;
+        const double v23x = ( batch.m_xnew[2][0][i] - batch.m_xnew[3][0][i] ) - x23x;
+        const double v23y = ( batch.m_xnew[2][1][i] - batch.m_xnew[3][1][i] ) - x23y;
+        const double v23z = ( batch.m_xnew[2][2][i] - batch.m_xnew[3][2][i] ) - x23z;
+
+        double max_coord = 0.0;
+        for ( unsigned int v = 0; v < 4; ++v )
+        {
+            for ( unsigned int d = 0; d < 3; ++d )
+            {
+                max_coord = std::max( max_coord, std::fabs( batch.m_x[v][d][i] ) );
+                max_coord = std::max( max_coord, std::fabs( batch.m_xnew[v][d][i] ) );
+            }
+        }
+
+        const double A = triple( v03x, v03y, v03z, v13x, v13y, v13z, v23x, v23y, v23z );
+        const double B = triple( x03x, x03y, x03z, v13x, v13y, v13z, v23x, v23y, v23z )
+                       + triple( v03x, v03y, v03z, x13x, x13y, x13z, v23x, v23y, v23z )
+                       + triple( v03x, v03y, v03z, v13x, v13y, v13z, x23x, x23y, x23z );
+        const double C = triple( x03x, x03y, x03z, x13x, x13y, x13z, v23x, v23y, v23z )
+                       + triple( x03x, x03y, x03z, v13x, v13y, v13z, x23x, x23y, x23z )
+                       + triple( v03x, v03y, v03z, x13x, x13y, x13z, x23x, x23y, x23z );
+        const double D = triple( x03x, x03y, x03z, x13x, x13y, x13z, x23x, x23y, x23z );
+
+        // reparameterize to s in [0,1] over t in [a, a+h], then convert to Bernstein coefficients
+
+        const double q3 = A * h * h * h;
+        const double q2 = h * h * ( 3.0 * A * a + B );
+        const double q1 = h * ( ( 3.0 * A * a + 2.0 * B ) * a + C );
+        const double q0 = ( ( A * a + B ) * a + C ) * a + D;
+
+        const double b0 = q0;
+        const double b1 = q0 + q1 / 3.0;
+        const double b2 = q0 + ( 2.0 * q1 + q2 ) / 3.0;
+        const double b3 = q0 + q1 + q2 + q3;
+
+        const double lo = std::min( std::min( b0, b1 ), std::min( b2, b3 ) );
+        const double hi = std::max( std::max( b0, b1 ), std::max( b2, b3 ) );
+
+        // tolerance: twice the cubic solver's, plus rounding in signed_volume() and in the coefficients
+
+        const double n0 = std::fabs(x03x) + std::fabs(x03y) + std::fabs(x03z) + std::fabs(v03x) + std::fabs(v03y) + std::fabs(v03z);
+        const double n1 = std::fabs(x13x) + std::fabs(x13y) + std::fabs(x13z) + std::fabs(v13x) + std::fabs(v13y) + std::fabs(v13z);
+        const double n2 = std::fabs(x23x) + std::fabs(x23y) + std::fabs(x23z) + std::fabs(v23x) + std::fabs(v23y) + std::fabs(v23z);
+
+        const double margin = 2.0 * g_cubic_solver_tol * ( std::fabs(A) + std::fabs(B) + std::fabs(C) + std::fabs(D) )
+                              + g_absolute_error_factor * max_coord * max_coord * max_coord
+                              + g_relative_error_factor * n0 * n1 * n2;
+
+        keep[i] = ( lo > margin || hi < -margin ) ? 0.0 : 1.0;
+    }
+
+    for ( unsigned int i = 0; i < CCD_BATCH_WIDTH; ++i )
+    {
+        may_be_coplanar[i] = ( keep[i] != 0.0 );
+    }
+}
+
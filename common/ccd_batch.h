@@ -0,0 +1,85 @@
+// ---------------------------------------------------------
+//
+//  ccd_batch.h
+//
+//  Batched early-out tests for continuous collision detection candidates.
+//
+// ---------------------------------------------------------
+
+#ifndef CCD_BATCH_H
+#define CCD_BATCH_H
+
+#include <algorithm>
+#include "vec.h"
+
+/// Number of candidates evaluated together.  Wide enough to fill an AVX-512 register of doubles.
+///
+const unsigned int CCD_BATCH_WIDTH = 8;
+
+// --------------------------------------------------------
+///
+/// Vertex trajectories for up to CCD_BATCH_WIDTH candidates, stored structure-of-arrays so that the batch kernels
+/// compile to one vector lane per candidate.  Each candidate is four vertices moving linearly from x to xnew: the point
+/// and triangle for point-triangle candidates, or the two edges for edge-edge candidates.
+///
+// --------------------------------------------------------
+
+struct CCDBatch
+{
+    CCDBatch() : m_size(0)
+    {
+        // keep unused lanes finite
+        std::fill( &m_x[0][0][0], &m_x[0][0][0] + 12*CCD_BATCH_WIDTH, 0.0 );
+        std::fill( &m_xnew[0][0][0], &m_xnew[0][0][0] + 12*CCD_BATCH_WIDTH, 0.0 );
+    }
+
+    /// Append a candidate
+    ///
+    inline void push_back( const Vec3d& x0, const Vec3d& xnew0,
+                           const Vec3d& x1, const Vec3d& xnew1,
+                           const Vec3d& x2, const Vec3d& xnew2,
+                           const Vec3d& x3, const Vec3d& xnew3 );
+
+    inline void clear() { m_size = 0; }
+
+    double m_x[4][3][CCD_BATCH_WIDTH];
+    double m_xnew[4][3][CCD_BATCH_WIDTH];
+    unsigned int m_size;
+};
+
+// --------------------------------------------------------
+///
+/// For each candidate in the batch, set may_be_coplanar[i] to 0 if its four vertices can be shown to never become coplanar
+/// during the step, and 1 otherwise.  Coplanarity is necessary for a collision, so a candidate with 0 cannot collide
+/// under either the cubic solver or root parity tests.  The bound includes the cubic solver's root tolerance and a margin
+/// for rounding error, so a candidate is only rejected if the scalar tests would reject it too.
+///
+/// Always evaluates all CCD_BATCH_WIDTH lanes; results past m_size are meaningless.
+///
+// --------------------------------------------------------
+
+void batch_coplanarity_cull( const CCDBatch& batch, unsigned char* may_be_coplanar );
+
+
+// --------------------------------------------------------
+
+inline void CCDBatch::push_back( const Vec3d& x0, const Vec3d& xnew0,
+                                 const Vec3d& x1, const Vec3d& xnew1,
+                                 const Vec3d& x2, const Vec3d& xnew2,
+                                 const Vec3d& x3, const Vec3d& xnew3 )
+{
+    assert( m_size < CCD_BATCH_WIDTH );
+    const Vec3d* xs[4] = { &x0, &x1, &x2, &x3 };
+    const Vec3d* xnews[4] = { &xnew0, &xnew1, &xnew2, &xnew3 };
+    for ( unsigned int v = 0; v < 4; ++v )
+    {
+        for ( unsigned int d = 0; d < 3; ++d )
+        {
+            m_x[v][d][m_size] = (*xs[v])[d];
+            m_xnew[v][d][m_size] = (*xnews[v])[d];
+        }
+    }
+    ++m_size;
+}
+
+#endif
@@ -3,7 +3,8 @@
 #define CCD_DEFS_H
 
 //
-// Uncomment one of the following to select the continuous collision detection method.
+// Uncomment one of the following to select the default continuous collision detection method.
+// Both methods are always compiled in; see CCDBackendType in ccd_wrapper.h for choosing one at run time.
 //
 
 #define USE_CUBIC_SOLVER_CCD
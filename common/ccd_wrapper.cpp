@@ -0,0 +1,428 @@
+// ---------------------------------------------------------
+//
+//  ccd_wrapper.cpp
+//
+//  Dispatch of collision and intersection queries to the selected backend.
+//
+// ---------------------------------------------------------
+
+
+#include "ccd_wrapper.h"
+#include "ccd_backends.h"
+
+
+void get_root_parity_prefilter_counts( size_t& num_queries, size_t& num_culled )
+{
+    root_parity_ccd::get_prefilter_counts( num_queries, num_culled );
+}
+
+void reset_root_parity_prefilter_counts()
+{
+    root_parity_ccd::reset_prefilter_counts();
+}
+
+
+// --------------------------------------------------------------------------------------------------
+// 2D continuous collision detection
+// --------------------------------------------------------------------------------------------------
+
+bool point_segment_collision(const Vec2d& x0, const Vec2d& xnew0, size_t index0,
+                             const Vec2d& x1, const Vec2d& xnew1, size_t index1,
+                             const Vec2d& x2, const Vec2d& xnew2, size_t index2)
+{
+    return cubic_ccd::point_segment_collision( x0, xnew0, index0, x1, xnew1, index1, x2, xnew2, index2 );
+}
+
+bool point_segment_collision(const Vec2d& x0, const Vec2d& xnew0, size_t index0,
+                             const Vec2d& x1, const Vec2d& xnew1, size_t index1,
+                             const Vec2d& x2, const Vec2d& xnew2, size_t index2,
+                             double& edge_alpha, Vec2d& normal, double& rel_disp)
+{
+    return cubic_ccd::point_segment_collision( x0, xnew0, index0, x1, xnew1, index1, x2, xnew2, index2, 
+                                               edge_alpha, normal, rel_disp );
+}
+
+// --------------------------------------------------------------------------------------------------
+// 2D static intersection detection
+// --------------------------------------------------------------------------------------------------
+
+bool segment_segment_intersection(CCDBackendType backend,
+                                  const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3)
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_segment_intersection( x0, index0,
+                                                              x1, index1,
+                                                              x2, index2,
+                                                              x3, index3 );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_segment_intersection( x0, index0,
+                                                        x1, index1,
+                                                        x2, index2,
+                                                        x3, index3 );
+    }
+}
+
+bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3)
+{
+    return segment_segment_intersection( default_ccd_backend(), x0, index0,
+                                                                x1, index1,
+                                                                x2, index2,
+                                                                x3, index3 );
+}
+
+bool segment_segment_intersection(CCDBackendType backend,
+                                  const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3,
+                                  double &s0, double& s2 )
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_segment_intersection( x0, index0,
+                                                              x1, index1,
+                                                              x2, index2,
+                                                              x3, index3,
+                                                              s0, s2 );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_segment_intersection( x0, index0,
+                                                        x1, index1,
+                                                        x2, index2,
+                                                        x3, index3,
+                                                        s0, s2 );
+    }
+}
+
+bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3,
+                                  double &s0, double& s2 )
+{
+    return segment_segment_intersection( default_ccd_backend(), x0, index0,
+                                                                x1, index1,
+                                                                x2, index2,
+                                                                x3, index3,
+                                                                s0, s2 );
+}
+
+// --------------------------------------------------------------------------------------------------
+// 3D continuous collision detection
+// --------------------------------------------------------------------------------------------------
+
+bool point_triangle_collision(CCDBackendType backend,
+                              const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3)
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::point_triangle_collision( x0, xnew0, index0,
+                                                          x1, xnew1, index1,
+                                                          x2, xnew2, index2,
+                                                          x3, xnew3, index3 );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::point_triangle_collision( x0, xnew0, index0,
+                                                    x1, xnew1, index1,
+                                                    x2, xnew2, index2,
+                                                    x3, xnew3, index3 );
+    }
+}
+
+bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3)
+{
+    return point_triangle_collision( default_ccd_backend(), x0, xnew0, index0,
+                                                            x1, xnew1, index1,
+                                                            x2, xnew2, index2,
+                                                            x3, xnew3, index3 );
+}
+
+bool point_triangle_collision(CCDBackendType backend,
+                              const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                              double& bary1, double& bary2, double& bary3,
+                              Vec3d& normal,
+                              double& relative_normal_displacement )
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::point_triangle_collision( x0, xnew0, index0,
+                                                          x1, xnew1, index1,
+                                                          x2, xnew2, index2,
+                                                          x3, xnew3, index3,
+                                                          bary1, bary2, bary3,
+                                                          normal,
+                                                          relative_normal_displacement );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::point_triangle_collision( x0, xnew0, index0,
+                                                    x1, xnew1, index1,
+                                                    x2, xnew2, index2,
+                                                    x3, xnew3, index3,
+                                                    bary1, bary2, bary3,
+                                                    normal,
+                                                    relative_normal_displacement );
+    }
+}
+
+bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                              double& bary1, double& bary2, double& bary3,
+                              Vec3d& normal,
+                              double& relative_normal_displacement )
+{
+    return point_triangle_collision( default_ccd_backend(), x0, xnew0, index0,
+                                                            x1, xnew1, index1,
+                                                            x2, xnew2, index2,
+                                                            x3, xnew3, index3,
+                                                            bary1, bary2, bary3,
+                                                            normal,
+                                                            relative_normal_displacement );
+}
+
+bool segment_segment_collision(CCDBackendType backend,
+                               const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3)
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_segment_collision( x0, xnew0, index0,
+                                                           x1, xnew1, index1,
+                                                           x2, xnew2, index2,
+                                                           x3, xnew3, index3 );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_segment_collision( x0, xnew0, index0,
+                                                     x1, xnew1, index1,
+                                                     x2, xnew2, index2,
+                                                     x3, xnew3, index3 );
+    }
+}
+
+bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3)
+{
+    return segment_segment_collision( default_ccd_backend(), x0, xnew0, index0,
+                                                             x1, xnew1, index1,
+                                                             x2, xnew2, index2,
+                                                             x3, xnew3, index3 );
+}
+
+bool segment_segment_collision(CCDBackendType backend,
+                               const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                               double& bary0, double& bary2,
+                               Vec3d& normal,
+                               double& relative_normal_displacement )
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_segment_collision( x0, xnew0, index0,
+                                                           x1, xnew1, index1,
+                                                           x2, xnew2, index2,
+                                                           x3, xnew3, index3,
+                                                           bary0, bary2,
+                                                           normal,
+                                                           relative_normal_displacement );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_segment_collision( x0, xnew0, index0,
+                                                     x1, xnew1, index1,
+                                                     x2, xnew2, index2,
+                                                     x3, xnew3, index3,
+                                                     bary0, bary2,
+                                                     normal,
+                                                     relative_normal_displacement );
+    }
+}
+
+bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                               double& bary0, double& bary2,
+                               Vec3d& normal,
+                               double& relative_normal_displacement )
+{
+    return segment_segment_collision( default_ccd_backend(), x0, xnew0, index0,
+                                                             x1, xnew1, index1,
+                                                             x2, xnew2, index2,
+                                                             x3, xnew3, index3,
+                                                             bary0, bary2,
+                                                             normal,
+                                                             relative_normal_displacement );
+}
+
+// --------------------------------------------------------------------------------------------------
+// 3D static intersection detection
+// --------------------------------------------------------------------------------------------------
+
+bool segment_triangle_intersection(CCDBackendType backend,
+                                   const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose )
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_triangle_intersection( x0, index0,
+                                                               x1, index1,
+                                                               x2, index2,
+                                                               x3, index3,
+                                                               x4, index4,
+                                                               degenerate_counts_as_intersection,
+                                                               verbose );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_triangle_intersection( x0, index0,
+                                                         x1, index1,
+                                                         x2, index2,
+                                                         x3, index3,
+                                                         x4, index4,
+                                                         degenerate_counts_as_intersection,
+                                                         verbose );
+    }
+}
+
+bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose )
+{
+    return segment_triangle_intersection( default_ccd_backend(), x0, index0,
+                                                                 x1, index1,
+                                                                 x2, index2,
+                                                                 x3, index3,
+                                                                 x4, index4,
+                                                                 degenerate_counts_as_intersection,
+                                                                 verbose );
+}
+
+bool segment_triangle_intersection(CCDBackendType backend,
+                                   const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   double& bary0, double& bary1, double& bary2, double& bary3, double& bary4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose )
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::segment_triangle_intersection( x0, index0,
+                                                               x1, index1,
+                                                               x2, index2,
+                                                               x3, index3,
+                                                               x4, index4,
+                                                               bary0, bary1, bary2, bary3, bary4,
+                                                               degenerate_counts_as_intersection,
+                                                               verbose );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::segment_triangle_intersection( x0, index0,
+                                                         x1, index1,
+                                                         x2, index2,
+                                                         x3, index3,
+                                                         x4, index4,
+                                                         bary0, bary1, bary2, bary3, bary4,
+                                                         degenerate_counts_as_intersection,
+                                                         verbose );
+    }
+}
+
+bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   double& bary0, double& bary1, double& bary2, double& bary3, double& bary4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose )
+{
+    return segment_triangle_intersection( default_ccd_backend(), x0, index0,
+                                                                 x1, index1,
+                                                                 x2, index2,
+                                                                 x3, index3,
+                                                                 x4, index4,
+                                                                 bary0, bary1, bary2, bary3, bary4,
+                                                                 degenerate_counts_as_intersection,
+                                                                 verbose );
+}
+
+bool point_tetrahedron_intersection(CCDBackendType backend,
+                                    const Vec3d& x0, size_t index0,
+                                    const Vec3d& x1, size_t index1,
+                                    const Vec3d& x2, size_t index2,
+                                    const Vec3d& x3, size_t index3,
+                                    const Vec3d& x4, size_t index4)
+{
+    switch ( backend )
+    {
+    case CCD_BACKEND_ROOT_PARITY:
+        return root_parity_ccd::point_tetrahedron_intersection( x0, index0,
+                                                                x1, index1,
+                                                                x2, index2,
+                                                                x3, index3,
+                                                                x4, index4 );
+    case CCD_BACKEND_CUBIC_SOLVER:
+    default:
+        return cubic_ccd::point_tetrahedron_intersection( x0, index0,
+                                                          x1, index1,
+                                                          x2, index2,
+                                                          x3, index3,
+                                                          x4, index4 );
+    }
+}
+
+bool point_tetrahedron_intersection(const Vec3d& x0, size_t index0,
+                                    const Vec3d& x1, size_t index1,
+                                    const Vec3d& x2, size_t index2,
+                                    const Vec3d& x3, size_t index3,
+                                    const Vec3d& x4, size_t index4)
+{
+    return point_tetrahedron_intersection( default_ccd_backend(), x0, index0,
+                                                                  x1, index1,
+                                                                  x2, index2,
+                                                                  x3, index3,
+                                                                  x4, index4 );
+}
+
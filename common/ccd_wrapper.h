@@ -12,14 +12,46 @@
 #ifndef CCD_WRAPPER_H
 #define CCD_WRAPPER_H
 
+#include "ccd_defs.h"
 #include "vec.h"
 
 
+// --------------------------------------------------------------------------------------------------
+// Backend selection
+// --------------------------------------------------------------------------------------------------
+
+// Both query implementations are always built.  The overloads taking a CCDBackendType use the given one, the rest 
+// use default_ccd_backend().
+
+enum CCDBackendType
+{
+    CCD_BACKEND_CUBIC_SOLVER,    // cubic_ccd_wrapper.cpp: coplanarity times plus proximity tolerance; fast
+    CCD_BACKEND_ROOT_PARITY      // root_parity_ccd_wrapper.cpp: exact root parity and simplex intersection tests
+};
+
+// The backend selected in ccd_defs.h
+inline CCDBackendType default_ccd_backend()
+{
+#ifdef USE_ROOT_PARITY_CCD
+    return CCD_BACKEND_ROOT_PARITY;
+#else
+    return CCD_BACKEND_CUBIC_SOLVER;
+#endif
+}
+
+// How many 3D continuous queries the root parity backend has received, and how many its floating-point prefilter 
+// answered without running the exact test.  Counted over all threads since the last reset; don't call these while 
+// queries are running.
+void get_root_parity_prefilter_counts( size_t& num_queries, size_t& num_culled );
+void reset_root_parity_prefilter_counts();
+
+
 // --------------------------------------------------------------------------------------------------
 // 2D continuous collision detection
 // --------------------------------------------------------------------------------------------------
 
 // x0 is the point, x1-x2 is the segment. Take care to specify x1,x2 in sorted order of index!
+// Only the cubic solver implements these, so they ignore default_ccd_backend().
 bool point_segment_collision(const Vec2d& x0, const Vec2d& xnew0, size_t index0,
                              const Vec2d& x1, const Vec2d& xnew1, size_t index1,
                              const Vec2d& x2, const Vec2d& xnew2, size_t index2);
@@ -38,12 +70,25 @@ bool segment_segment_intersection(const Vec2d& x0, size_t index0,
                                   const Vec2d& x2, size_t index2,
                                   const Vec2d& x3, size_t index3);
 
+bool segment_segment_intersection(CCDBackendType backend,
+                                  const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3);
+
 bool segment_segment_intersection(const Vec2d& x0, size_t index0, 
                                   const Vec2d& x1, size_t index1,
                                   const Vec2d& x2, size_t index2,
                                   const Vec2d& x3, size_t index3,
                                   double &s0, double& s2 );
 
+bool segment_segment_intersection(CCDBackendType backend,
+                                  const Vec2d& x0, size_t index0, 
+                                  const Vec2d& x1, size_t index1,
+                                  const Vec2d& x2, size_t index2,
+                                  const Vec2d& x3, size_t index3,
+                                  double &s0, double& s2 );
+
 // --------------------------------------------------------------------------------------------------
 // 3D continuous collision detection
 // --------------------------------------------------------------------------------------------------
@@ -54,6 +99,12 @@ bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0
                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
                               const Vec3d& x3, const Vec3d& xnew3, size_t index3);
 
+bool point_triangle_collision(CCDBackendType backend,
+                              const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
 // x0 is the point, x1-x2-x3 is the triangle. Take care to specify x1,x2,x3 in sorted order of index!
 // If there is a collision, returns true and sets bary1, bary2, bary3 to the barycentric coordinates of
 // the collision point, sets normal to the collision point, t to the collision time, and the relative
@@ -66,12 +117,27 @@ bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0
                               Vec3d& normal,
                               double& relative_normal_displacement );
 
+bool point_triangle_collision(CCDBackendType backend,
+                              const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                              const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                              const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                              const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                              double& bary1, double& bary2, double& bary3,
+                              Vec3d& normal,
+                              double& relative_normal_displacement );
+
 // x0-x1 and x2-x3 are the segments. Take care to specify x0,x1 and x2,x3 in sorted order of index!
 bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index0,
                                const Vec3d& x1, const Vec3d& xnew1, size_t index1,
                                const Vec3d& x2, const Vec3d& xnew2, size_t index2,
                                const Vec3d& x3, const Vec3d& xnew3, size_t index3);
 
+bool segment_segment_collision(CCDBackendType backend,
+                               const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3);
+
 // x0-x1 and x2-x3 are the segments. Take care to specify x0,x1 and x2,x3 in sorted order of index!
 // If there is a collision, returns true and sets bary0 and bary2 to parts of the barycentric coordinates of
 // the collision point, sets normal to the collision point, t to the collision time, and the relative
@@ -84,6 +150,15 @@ bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t index
                                Vec3d& normal,
                                double& relative_normal_displacement );
 
+bool segment_segment_collision(CCDBackendType backend,
+                               const Vec3d& x0, const Vec3d& xnew0, size_t index0,
+                               const Vec3d& x1, const Vec3d& xnew1, size_t index1,
+                               const Vec3d& x2, const Vec3d& xnew2, size_t index2,
+                               const Vec3d& x3, const Vec3d& xnew3, size_t index3,
+                               double& bary0, double& bary2,
+                               Vec3d& normal,
+                               double& relative_normal_displacement );
+
 
 // --------------------------------------------------------------------------------------------------
 // 3D static intersection detection
@@ -98,6 +173,15 @@ bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
                                    bool degenerate_counts_as_intersection,
                                    bool verbose = false );
 
+bool segment_triangle_intersection(CCDBackendType backend,
+                                   const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose = false );
+
 bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
                                    const Vec3d& x1, size_t index1,
                                    const Vec3d& x2, size_t index2,
@@ -107,6 +191,16 @@ bool segment_triangle_intersection(const Vec3d& x0, size_t index0,
                                    bool degenerate_counts_as_intersection,
                                    bool verbose = false );
 
+bool segment_triangle_intersection(CCDBackendType backend,
+                                   const Vec3d& x0, size_t index0,
+                                   const Vec3d& x1, size_t index1,
+                                   const Vec3d& x2, size_t index2,
+                                   const Vec3d& x3, size_t index3,
+                                   const Vec3d& x4, size_t index4,
+                                   double& bary0, double& bary1, double& bary2, double& bary3, double& bary4,
+                                   bool degenerate_counts_as_intersection,
+                                   bool verbose = false );
+
 
 // x0 is the point and x1-x2-x3-x4 is the tetrahedron. Order is irrelevant.
 bool point_tetrahedron_intersection(const Vec3d& x0, size_t index0,
@@ -115,6 +209,13 @@ bool point_tetrahedron_intersection(const Vec3d& x0, size_t index0,
                                     const Vec3d& x3, size_t index3,
                                     const Vec3d& x4, size_t index4);
 
+bool point_tetrahedron_intersection(CCDBackendType backend,
+                                    const Vec3d& x0, size_t index0,
+                                    const Vec3d& x1, size_t index1,
+                                    const Vec3d& x2, size_t index2,
+                                    const Vec3d& x3, size_t index3,
+                                    const Vec3d& x4, size_t index4);
+
 
 #endif
 
@@ -9,13 +9,10 @@
 // ---------------------------------------------------------
 
 
-#include "ccd_defs.h"
-#include "ccd_wrapper.h"
+#include "ccd_backends.h"
 
 bool simplex_verbose = false;
 
-#ifdef USE_CUBIC_SOLVER_CCD
-
 #include "collisionqueries.h"
 
 namespace
@@ -25,8 +22,7 @@ namespace
     // Local function declarations
     //
     
-    /// Tolerance on the cubic solver for coplanarity time
-    const double g_cubic_solver_tol = 1e-8;
+    using cubic_ccd::g_cubic_solver_tol;
     
     /// Tolerance for trusting computed collision normal
     const double g_degen_normal_epsilon = 1e-6;
@@ -886,6 +882,9 @@ namespace
 } // namespace
 
 
+namespace cubic_ccd
+{
+
 // --------------------------------------------------------------------------------------------------
 // 2D Continuous collision detection
 // --------------------------------------------------------------------------------------------------
@@ -1076,7 +1075,5 @@ bool point_tetrahedron_intersection(const Vec3d& x0, size_t ,
     return vertex_is_in_tetrahedron(x0,x1,x2,x3,x4,g_collision_epsilon);
 }
 
-#endif
-
-
+} // namespace cubic_ccd
 
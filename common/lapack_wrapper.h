@@ -24,6 +24,7 @@ namespace LAPACK{
     int solve_general_system(int &n, int &nrhs, float *a, int lda, int *ipiv, float *b, int ldb, int &info);
     int solve_general_system(int n, int nrhs, double *a, int lda, int *ipiv, double *b, int ldb, int &info);
     int factor_general_matrix(int m, int n, double *a, int lda, int *ipiv, int &info);
+    int solve_positive_definite_system(int n, int nrhs, double *a, int lda, double *b, int ldb, int &info);
     void invert_general_matrix(int n, double *a, int lda, int *ipiv, double *work, int lwork, int &info);
     void get_eigen_decomposition( int *n, double *a, int* /*lda*/, double *eigenvalues, double *work, int *lwork, int *info );
     int svd( int* m, int* n, double* a, int* lda, double *s, double *u, int* ldu, double* vt, int *ldvt, double *work, int* lwork, int* iwork, int* info );
@@ -139,6 +140,12 @@ namespace LAPACK{
     inline int factor_general_matrix(int m, int n, double *a, int lda, int *ipiv, int &info)
     { return dgetrf_( (__CLPK_integer*)&m, (__CLPK_integer*)&n, a, (__CLPK_integer*)&lda, (__CLPK_integer*)ipiv, (__CLPK_integer*)&info); }
     
+    inline int solve_positive_definite_system(int n, int nrhs, double *a, int lda, double *b, int ldb, int &info)
+    { 
+        char char_l = 'L';
+        return dposv_( &char_l, (__CLPK_integer*)&n, (__CLPK_integer*)&nrhs, a, (__CLPK_integer*)&lda, b, (__CLPK_integer*)&ldb, (__CLPK_integer*)&info); 
+    }
+    
     
     inline void invert_general_matrix(int n, double *a, int lda, int *ipiv, double *work, int lwork, int &info)
     {
@@ -193,6 +200,7 @@ extern "C" {
     void 	dbdsqr_ (char *uplo, int *n, int *ncvt, int *nru, int *ncc, double *d, double *e, double *vt, int *ldvt, double *u, int *ldu, double *c, int *ldc, double *work, int *info);
     void 	dgetrs_ (char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
     void 	dpotrf_ (char *uplo, int *n, double *a, int *lda, int *info);
+    void 	dposv_ (char *uplo, int *n, int *nrhs, double *a, int *lda, double *b, int *ldb, int *info);
     void 	dgeqpf_ (int *m, int *n, double *a, int *lda, int *jpvt, double *tau, double *work, int *info);   
     int dgesdd_( char* jobz, int* m, int* n, double* a, int* lda, double *s, double *u, int* ldu, double* vt, int *ldvt, double *work, int* lwork, int* iwork, int* info );
 }
@@ -213,6 +221,13 @@ namespace LAPACK
     inline int factor_general_matrix(int m, int n, double *a, int lda, int *ipiv, int &info)
     { return dgetrf_(&m, &n, a, &lda, ipiv, &info); }
     
+    inline int solve_positive_definite_system(int n, int nrhs, double *a, int lda, double *b, int ldb, int &info)
+    { 
+        char char_l = 'L';
+        dposv_(&char_l, &n, &nrhs, a, &lda, b, &ldb, &info); 
+        return info;
+    }
+    
     inline void invert_general_matrix(int n, double *a, int lda, int *ipiv, double *work, int lwork, int &info)
     {
         factor_general_matrix(n, n, a, lda, ipiv, info);
@@ -85,7 +85,7 @@ solve(const LinearOperator &A, const double *rhs, double *result,
     if(residual_norm==0) return status=KRYLOV_CONVERGED;
     // set up CR
     double rho;
-    if(preconditioner) preconditioner->apply(r, z); else BLAS::copy(r, s);
+    if(preconditioner) preconditioner->apply(r, s); else BLAS::copy(r, s);
     A.apply(s, t);
     rho=BLAS::dot(r, t);
     if(rho==0 || rho!=rho) return status=KRYLOV_BREAKDOWN;
@@ -98,18 +98,18 @@ solve(const LinearOperator &A, const double *rhs, double *result,
         BLAS::add_scaled(n, alpha, &s[0], result);
         BLAS::add_scaled(-alpha, t, r);
         residual_norm=BLAS::abs_max(r);
-        if(residual_norm<=tol) return KRYLOV_CONVERGED;
+        if(residual_norm<=tol) return status=KRYLOV_CONVERGED;
         if(preconditioner) preconditioner->apply(r, z);
         else               BLAS::copy(r, z);
         A.apply(z, q);
         double rho_new=BLAS::dot(r, q);
-        if(rho_new==0 || rho_new!=rho_new) return KRYLOV_BREAKDOWN;
+        if(rho_new==0 || rho_new!=rho_new) return status=KRYLOV_BREAKDOWN;
         double beta=rho_new/rho;
         BLAS::add_scaled(beta, s, z); s.swap(z); // s=beta*s+z
         BLAS::add_scaled(beta, t, q); t.swap(q); // t=beta*t+q
         rho=rho_new;
     }
-    return KRYLOV_EXCEEDED_MAX_ITERATIONS;
+    return status=KRYLOV_EXCEEDED_MAX_ITERATIONS;
 }
 
 //============================================================================
@@ -119,7 +119,7 @@ solve(const LinearOperator &A, const double *rhs, double *result,
 {
     const int m=A.m, n=A.n;
     assert(preconditioner==0 || (preconditioner->m==n && preconditioner->n==n));
-    if((int)s.size()!=n){
+    if((int)s.size()!=n || (int)u.size()!=m){
         r.resize(n);
         z.resize(n);
         s.resize(n);
@@ -9,6 +9,10 @@ enum KrylovSolverStatus{
     KRYLOV_BREAKDOWN
 };
 
+// All the solvers keep their work vectors between calls, so reusing one solver
+// object for a sequence of systems of the same size doesn't reallocate. For
+// preconditioners see preconditioners.h.
+
 //============================================================================
 // Only guaranteed for symmetric positive definite systems.
 // Singular systems may be solved, but round-off error may cause problems,
@@ -0,0 +1,100 @@
+#include "preconditioners.h"
+#include <cmath>
+
+//============================================================================
+void JacobiPreconditioner::
+build(const SparseMatrixStaticCSR &A)
+{
+    assert(A.m==A.n);
+    m=n=A.m;
+    inverse_diagonal.resize(n);
+    for(int i=0; i<n; ++i){
+        double d=A(i,i);
+        inverse_diagonal[i]=(d>0 ? 1/d : 1);
+    }
+}
+
+void JacobiPreconditioner::
+apply(const double *x, double *y) const
+{
+    assert(x && y);
+    for(int i=0; i<n; ++i) y[i]=inverse_diagonal[i]*x[i];
+}
+
+void JacobiPreconditioner::
+apply_and_subtract(const double *x, const double *y, double *z) const
+{
+    assert(x && y && z);
+    for(int i=0; i<n; ++i) z[i]=y[i]-inverse_diagonal[i]*x[i];
+}
+
+//============================================================================
+bool IncompleteCholeskyPreconditioner::
+build(const SparseMatrixStaticCSR &A)
+{
+    assert(A.m==A.n);
+    m=n=A.m;
+    rowstart.resize(n+1);
+    colindex.clear();
+    value.clear();
+    work.assign(n, 0);
+    applied.resize(n);
+    rowstart[0]=0;
+    for(int i=0; i<n; ++i){
+        // copy the strictly lower part of row i of A into L, and its values into work
+        double diagonal=0;
+        for(int k=A.rowstart[i]; k<A.rowstart[i+1]; ++k){
+            int j=A.colindex[k];
+            if(j<i){
+                colindex.push_back(j);
+                value.push_back(0);
+                work[j]=A.value[k];
+            }else if(j==i) diagonal=A.value[k];
+        }
+        // eliminate in increasing column order; work holds L(i,0:j-1) once column j is reached
+        int row_begin=rowstart[i], row_end=(int)colindex.size();
+        for(int p=row_begin; p<row_end; ++p){
+            int j=colindex[p];
+            double sum=work[j];
+            for(int q=rowstart[j]; q<rowstart[j+1]-1; ++q) sum-=value[q]*work[colindex[q]];
+            double lij=sum/value[rowstart[j+1]-1];
+            work[j]=lij;
+            value[p]=lij;
+            diagonal-=lij*lij;
+        }
+        // entries of row i outside its sparsity were never set, so only the pattern needs resetting
+        for(int p=row_begin; p<row_end; ++p) work[colindex[p]]=0;
+        if(!(diagonal>0)) return false;
+        colindex.push_back(i);
+        value.push_back(std::sqrt(diagonal));
+        rowstart[i+1]=(int)colindex.size();
+    }
+    return true;
+}
+
+void IncompleteCholeskyPreconditioner::
+apply(const double *x, double *y) const
+{
+    assert(x && y);
+    // solve L*w=x, then L^T*y=w, in place in y
+    for(int i=0; i<n; ++i){
+        double d=x[i];
+        int diag=rowstart[i+1]-1;
+        for(int k=rowstart[i]; k<diag; ++k) d-=value[k]*y[colindex[k]];
+        y[i]=d/value[diag];
+    }
+    for(int i=n-1; i>=0; --i){
+        int diag=rowstart[i+1]-1;
+        y[i]/=value[diag];
+        for(int k=rowstart[i]; k<diag; ++k) y[colindex[k]]-=value[k]*y[i];
+    }
+}
+
+void IncompleteCholeskyPreconditioner::
+apply_and_subtract(const double *x, const double *y, double *z) const
+{
+    assert(x && y && z);
+    assert((int)applied.size()==n);
+    apply(x, &applied[0]);
+    for(int i=0; i<n; ++i) z[i]=y[i]-applied[i];
+}
@@ -0,0 +1,59 @@
+#ifndef PRECONDITIONERS_H
+#define PRECONDITIONERS_H
+
+// Preconditioners for symmetric positive definite sparse matrices, for use with
+// the Krylov solvers. Each one is a LinearOperator approximating the inverse of
+// the matrix it was built from, and can be rebuilt for a new matrix without
+// reallocating its storage if the size and sparsity don't grow.
+
+#include "sparse_matrix.h"
+
+//============================================================================
+// Inverse of the diagonal. Rows with a nonpositive diagonal are left unscaled.
+struct JacobiPreconditioner: public LinearOperator
+{
+    std::vector<double> inverse_diagonal;
+
+    JacobiPreconditioner(void) : LinearOperator(0), inverse_diagonal(0) {}
+    void build(const SparseMatrixStaticCSR &A);
+    using LinearOperator::apply;
+    using LinearOperator::apply_and_subtract;
+    using LinearOperator::apply_transpose;
+    using LinearOperator::apply_transpose_and_subtract;
+    virtual void apply(const double *x, double *y) const;
+    virtual void apply_and_subtract(const double *x, const double *y, double *z) const;
+    virtual void apply_transpose(const double *x, double *y) const { apply(x, y); }
+    virtual void apply_transpose_and_subtract(const double *x, const double *y, double *z) const { apply_and_subtract(x, y, z); }
+};
+
+//============================================================================
+// Incomplete Cholesky factorization with no fill-in, IC(0): L*L^T ~= A, where
+// L has the sparsity of the lower triangle of A. A must be symmetric with
+// sorted column indices in each row. The factorization can fail on matrices
+// which aren't sufficiently diagonally dominant (or are singular), in which
+// case build() returns false and the preconditioner shouldn't be used.
+struct IncompleteCholeskyPreconditioner: public LinearOperator
+{
+    // L in compressed sparse row format, with the diagonal entry last in each row
+    std::vector<int> rowstart;
+    std::vector<int> colindex;
+    std::vector<double> value;
+
+    IncompleteCholeskyPreconditioner(void) : LinearOperator(0), rowstart(1, 0), colindex(0), value(0), work(0), applied(0) {}
+    bool build(const SparseMatrixStaticCSR &A);
+    using LinearOperator::apply;
+    using LinearOperator::apply_and_subtract;
+    using LinearOperator::apply_transpose;
+    using LinearOperator::apply_transpose_and_subtract;
+    virtual void apply(const double *x, double *y) const;
+    virtual void apply_and_subtract(const double *x, const double *y, double *z) const;
+    virtual void apply_transpose(const double *x, double *y) const { apply(x, y); }
+    virtual void apply_transpose_and_subtract(const double *x, const double *y, double *z) const { apply_and_subtract(x, y, z); }
+
+private:
+    std::vector<double> work; // dense copy of the row being factored
+    mutable std::vector<double> applied; // result of apply() inside apply_and_subtract(), sized by build(); makes
+                                         // apply_and_subtract() unsafe to call from several threads at once
+};
+
+#endif
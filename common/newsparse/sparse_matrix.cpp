@@ -200,7 +200,7 @@ operator()(int i, int j) const
 {
     assert(i>=0 && i<m && j>=0 && j<n);
     // linear search for now - could be accelerated if needed!
-    for(int k=rowstart[i]; k<rowstart[k+1]; ++k){
+    for(int k=rowstart[i]; k<rowstart[i+1]; ++k){
         if(colindex[k]==j) return value[k];
         else if(colindex[k]>j) break;
     }
@@ -9,22 +9,24 @@
 // ---------------------------------------------------------
 
 
-#include "ccd_defs.h"
-
-
-#ifdef USE_ROOT_PARITY_CCD
-
-#include "ccd_wrapper.h"
+#include "ccd_backends.h"
 #include "collisionqueries.h"
 #include "rootparitycollisiontest.h"
 #include "tunicate.h"
 
+#include <cfloat>
+
 namespace 
 {
     /// Tolerance for trusting computed collision normal
     ///
     const double g_degen_normal_epsilon = 1e-6;
 
+    /// Number of 3D continuous queries made, and how many of those the prefilter rejected
+    ///
+    size_t g_num_prefilter_queries = 0;
+    size_t g_num_prefilter_culled = 0;
+
     //
     // Local function declarations
     //
@@ -44,6 +46,10 @@ namespace
                                                 const Vec3d &xnew0, const Vec3d &xnew1, const Vec3d &xnew2, const Vec3d &xnew3,
                                                 double &s0, double &s2, Vec3d& normal );
 
+    bool prefilter_culls(const Vec3d &x0, const Vec3d &x1, const Vec3d &x2, const Vec3d &x3,
+                         const Vec3d &xnew0, const Vec3d &xnew1, const Vec3d &xnew2, const Vec3d &xnew3,
+                         bool is_edge_edge );
+
     
     //
     // Local function definitions
@@ -186,9 +192,126 @@ namespace
         assert( mag(normal) > 0.0 );        
     }
     
+    // --------------------------------------------------------
+    ///
+    /// Cheap floating-point test, run before building a RootParityCollisionTest.  Returns true only if there is certainly
+    /// no collision.
+    ///
+    /// The collision function F maps the domain (t,u,v) to the vector between the two closest features, and is multilinear,
+    /// so its image lies in the convex hull of its values at the domain corners.  Those are plain differences of input 
+    /// positions: x_a(t) - x_b(t) for t in {0,1}.  If a plane through the origin has every corner value strictly on one 
+    /// side, F has no root.  We try the 13 plane normals with entries in {-1,0,1}; the coordinate axes amount to a swept 
+    /// AABB test, and the rest include the planes RootParityCollisionTest::fixed_plane_culling() uses.
+    ///
+    /// Each projection is a difference and at most two additions, so its rounding error is under 4 ulps of the sum of the
+    /// input magnitudes.  Corners must clear twice that to count.
+    ///
+    // --------------------------------------------------------
+    
+    bool prefilter_culls(const Vec3d &x0, const Vec3d &x1, const Vec3d &x2, const Vec3d &x3,
+                         const Vec3d &xnew0, const Vec3d &xnew1, const Vec3d &xnew2, const Vec3d &xnew3,
+                         bool is_edge_edge )
+    {
+        static const int normals[13][3] = { {1,0,0}, {0,1,0}, {0,0,1}, 
+                                            {1,1,0}, {1,-1,0}, {1,0,1}, {1,0,-1}, {0,1,1}, {0,1,-1},
+                                            {1,1,1}, {1,1,-1}, {1,-1,1}, {1,-1,-1} };
+        
+        // corner values of F, as pairs of positions to subtract
+        
+        const Vec3d* a[8];
+        const Vec3d* b[8];
+        unsigned int num_corners;
+        
+        if ( is_edge_edge )
+        {
+            // (1-u) x0 + u x1 - ( (1-v) x2 + v x3 )
+            const Vec3d* first[4] = { &x0, &x1, &xnew0, &xnew1 };
+            const Vec3d* second[4] = { &x2, &x3, &xnew2, &xnew3 };
+            for ( unsigned int i = 0; i < 8; ++i )
+            {
+                const unsigned int t = i / 4, u = ( i / 2 ) % 2, v = i % 2;
+                a[i] = first[2*t + u];
+                b[i] = second[2*t + v];
+            }
+            num_corners = 8;
+        }
+        else
+        {
+            // x0 - ( (1-u-v) x1 + u x2 + v x3 )
+            const Vec3d* tri[6] = { &x1, &x2, &x3, &xnew1, &xnew2, &xnew3 };
+            for ( unsigned int i = 0; i < 6; ++i )
+            {
+                a[i] = ( i < 3 ) ? &x0 : &xnew0;
+                b[i] = tri[i];
+            }
+            num_corners = 6;
+        }
+        
+        double cx[8], cy[8], cz[8];
+        double max_magnitude = 0.0;
+        
+        for ( unsigned int i = 0; i < num_corners; ++i )
+        {
+            const Vec3d& p = *a[i];
+            const Vec3d& q = *b[i];
+            cx[i] = p[0] - q[0];
+            cy[i] = p[1] - q[1];
+            cz[i] = p[2] - q[2];
+            max_magnitude = std::max( max_magnitude, std::fabs(p[0]) + std::fabs(q[0]) 
+                                                     + std::fabs(p[1]) + std::fabs(q[1]) 
+                                                     + std::fabs(p[2]) + std::fabs(q[2]) );
+        }
+        
+        const double margin = 4.0 * DBL_EPSILON * max_magnitude;
+        
+        for ( unsigned int n = 0; n < 13; ++n )
+        {
+            const double nx = normals[n][0], ny = normals[n][1], nz = normals[n][2];
+            
+            double lo = nx * cx[0] + ny * cy[0] + nz * cz[0];
+            double hi = lo;
+            for ( unsigned int i = 1; i < num_corners; ++i )
+            {
+                const double d = nx * cx[i] + ny * cy[i] + nz * cz[i];
+                lo = std::min( lo, d );
+                hi = std::max( hi, d );
+            }
+            
+            if ( lo > margin || hi < -margin )
+            {
+                return true;
+            }
+        }
+        
+        return false;
+    }
+    
+    /// Run the prefilter and update the counters.  Returns true if the query can be answered "no collision" now.
+    ///
+    bool prefilter_and_count(const Vec3d &x0, const Vec3d &x1, const Vec3d &x2, const Vec3d &x3,
+                             const Vec3d &xnew0, const Vec3d &xnew1, const Vec3d &xnew2, const Vec3d &xnew3,
+                             bool is_edge_edge )
+    {
+        const bool culled = prefilter_culls( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, is_edge_edge );
+        
+        #pragma omp atomic
+        ++g_num_prefilter_queries;
+        
+        if ( culled )
+        {
+            #pragma omp atomic
+            ++g_num_prefilter_culled;
+        }
+        
+        return culled;
+    }
+    
 }
 
 
+namespace root_parity_ccd
+{
+
 // --------------------------------------------------------------------------------------------------
 // 2D Continuous collision detection
 // --------------------------------------------------------------------------------------------------
@@ -257,6 +380,11 @@ bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t /*inde
                               const Vec3d& x2, const Vec3d& xnew2, size_t /*index2*/,
                               const Vec3d& x3, const Vec3d& xnew3, size_t /*index3*/ )
 {   
+    if ( prefilter_and_count( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, false ) )
+    {
+        return false;
+    }
+    
     rootparity::RootParityCollisionTest test( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, false );
     bool rayhex_result = test.run_test();
     return rayhex_result;
@@ -272,6 +400,11 @@ bool point_triangle_collision(const Vec3d& x0, const Vec3d& xnew0, size_t /*inde
                               double& relative_normal_displacement )
 {
     
+    if ( prefilter_and_count( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, false ) )
+    {
+        return false;
+    }
+    
     rootparity::RootParityCollisionTest test( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, false );
     bool rayhex_result = test.run_test();
     
@@ -297,6 +430,11 @@ bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t /*ind
                                const Vec3d& x3, const Vec3d& xnew3, size_t /*index3*/)
 {
     
+    if ( prefilter_and_count( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, true ) )
+    {
+        return false;
+    }
+    
     rootparity::RootParityCollisionTest test( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, true );
     bool rayhex_result = test.run_test();
     return rayhex_result;
@@ -311,6 +449,11 @@ bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t /*ind
                                Vec3d& normal,
                                double& relative_normal_displacement )
 {
+    if ( prefilter_and_count( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, true ) )
+    {
+        return false;
+    }
+    
     rootparity::RootParityCollisionTest test( x0, x1, x2, x3, xnew0, xnew1, xnew2, xnew3, true );
     bool rayhex_result = test.edge_edge_collision();
     
@@ -330,6 +473,20 @@ bool segment_segment_collision(const Vec3d& x0, const Vec3d& xnew0, size_t /*ind
 }
 
 
+void get_prefilter_counts( size_t& num_queries, size_t& num_culled )
+{
+    num_queries = g_num_prefilter_queries;
+    num_culled = g_num_prefilter_culled;
+}
+
+
+void reset_prefilter_counts()
+{
+    g_num_prefilter_queries = 0;
+    g_num_prefilter_culled = 0;
+}
+
+
 // --------------------------------------------------------------------------------------------------
 // 3D Static intersection detection
 // --------------------------------------------------------------------------------------------------
@@ -370,7 +527,5 @@ bool point_tetrahedron_intersection(const Vec3d& x0, size_t /*index0*/,
     return simplex_intersection3d( 1, x0.v, x1.v, x2.v, x3.v, x4.v, &bary[0], &bary[1], &bary[2], &bary[3], &bary[4] );
 }
 
-#endif
-
-
+} // namespace root_parity_ccd
 
@@ -0,0 +1,94 @@
+// ---------------------------------------------------------
+//
+//  directedrounding.h
+//
+//  Upper and lower bounds on the results of floating-point operations, without changing the rounding mode.
+//
+// ---------------------------------------------------------
+
+#ifndef TUNICATE_DIRECTEDROUNDING_H
+#define TUNICATE_DIRECTEDROUNDING_H
+
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+// ----------------------------------------
+//
+// Each operation is evaluated in whatever rounding mode is current, which is off by less than one ulp, then moved one
+// floating-point number outward.  The result bounds the exact value in any rounding mode, and nothing here touches the
+// floating-point environment, so these are thread-safe and don't stall the pipeline.  The bounds are at most one ulp 
+// looser than true directed rounding.
+//
+// Zero results are left alone when they are exact (a sum that rounds to zero always is), so exact zeros, which are 
+// common in the interval code, don't turn into subnormals, which are very slow on most hardware.  Inputs and results 
+// must be finite.
+//
+// ----------------------------------------
+
+/// Move x one double toward +infinity, unless x is zero.  Branch-free, so the interval code stays vectorizable.
+///
+inline double step_up_unless_zero( double x )
+{
+    int64_t bits;
+    std::memcpy( &bits, &x, sizeof(double) );
+    const int64_t nonzero_mask = -static_cast<int64_t>( x != 0 );
+    bits += nonzero_mask & ( ( bits >> 63 ) | 1 );     // magnitude up for positive x, down for negative
+    std::memcpy( &x, &bits, sizeof(double) );
+    return x;
+}
+
+/// Move x one double toward -infinity, unless x is zero.
+///
+inline double step_down_unless_zero( double x )
+{
+    return -step_up_unless_zero( -x );
+}
+
+inline double add_up( double a, double b ) { return step_up_unless_zero( a + b ); }
+inline double sub_up( double a, double b ) { return step_up_unless_zero( a - b ); }
+
+inline double add_down( double a, double b ) { return step_down_unless_zero( a + b ); }
+inline double sub_down( double a, double b ) { return step_down_unless_zero( a - b ); }
+
+inline double mul_up( double a, double b )
+{
+    const double p = a * b;
+    if ( p == 0 && a != 0 && b != 0 && ( a < 0 ) == ( b < 0 ) )
+    {
+        // a positive product that underflowed
+        return std::numeric_limits<double>::denorm_min();
+    }
+    return step_up_unless_zero( p );
+}
+
+inline double mul_down( double a, double b )
+{
+    const double p = a * b;
+    if ( p == 0 && a != 0 && b != 0 && ( a < 0 ) != ( b < 0 ) )
+    {
+        // a negative product that underflowed
+        return -std::numeric_limits<double>::denorm_min();
+    }
+    return step_down_unless_zero( p );
+}
+
+// ----------------------------------------
+//
+// The same operations as policy classes, for code written once for both directions.
+//
+// ----------------------------------------
+
+struct RoundUp
+{
+    static double add( double a, double b ) { return add_up( a, b ); }
+    static double mul( double a, double b ) { return mul_up( a, b ); }
+};
+
+struct RoundDown
+{
+    static double add( double a, double b ) { return add_down( a, b ); }
+    static double mul( double a, double b ) { return mul_down( a, b ); }
+};
+
+#endif
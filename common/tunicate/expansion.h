@@ -7,7 +7,11 @@
 // expansions, with simplicity favoured over speed.
 
 #include "commonoptions.h"
-#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 // The basic type is essentially a vector of *increasing* and 
 // *nonoverlapping* doubles, apart from allowed zeroes anywhere.
@@ -84,6 +88,103 @@ void
 print_full( const expansion& e );
 
 
+// ----------------------------------------------------
+
+// Storage for the components of an expansion: the first N doubles live
+// inside the object, so the short expansions produced by the predicates
+// never touch the heap.  Longer ones spill to a malloc'd block.  Only the
+// parts of the std::vector interface used by the expansion arithmetic are
+// provided.
+
+template<unsigned int N>
+class expansion_buffer
+{
+    
+public:
+    
+    expansion_buffer()
+    : m_size(0), m_capacity(N), m_data(m_inline)
+    {}
+    
+    expansion_buffer( std::size_t n, double val )
+    : m_size(0), m_capacity(N), m_data(m_inline)
+    {
+        resize( n, val );
+    }
+    
+    expansion_buffer( const expansion_buffer& other )
+    : m_size(0), m_capacity(N), m_data(m_inline)
+    {
+        assign( other );
+    }
+    
+    ~expansion_buffer()
+    {
+        if ( m_data != m_inline ) { std::free( m_data ); }
+    }
+    
+    expansion_buffer& operator=( const expansion_buffer& other )
+    {
+        if ( this != &other ) { assign( other ); }
+        return *this;
+    }
+    
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    
+    double& operator[]( std::size_t i ) { assert( i < m_size ); return m_data[i]; }
+    const double& operator[]( std::size_t i ) const { assert( i < m_size ); return m_data[i]; }
+    
+    double& back() { assert( m_size > 0 ); return m_data[m_size-1]; }
+    const double& back() const { assert( m_size > 0 ); return m_data[m_size-1]; }
+    
+    void reserve( std::size_t n )
+    {
+        if ( n > m_capacity ) { grow( n ); }
+    }
+    
+    void push_back( double val )
+    {
+        if ( m_size == m_capacity ) { grow( 2*m_capacity ); }
+        m_data[m_size++] = val;
+    }
+    
+    // new entries are zero, as with std::vector
+    void resize( std::size_t n, double val = 0.0 )
+    {
+        reserve( n );
+        for ( std::size_t i = m_size; i < n; ++i ) { m_data[i] = val; }
+        m_size = n;
+    }
+    
+    void clear() { m_size = 0; }
+    
+private:
+    
+    void grow( std::size_t n )
+    {
+        double* new_data = static_cast<double*>( std::malloc( n * sizeof(double) ) );
+        if ( new_data == NULL ) { throw std::bad_alloc(); }
+        std::memcpy( new_data, m_data, m_size * sizeof(double) );
+        if ( m_data != m_inline ) { std::free( m_data ); }
+        m_data = new_data;
+        m_capacity = n;
+    }
+    
+    void assign( const expansion_buffer& other )
+    {
+        m_size = 0;
+        reserve( other.m_size );
+        std::memcpy( m_data, other.m_data, other.m_size * sizeof(double) );
+        m_size = other.m_size;
+    }
+    
+    std::size_t m_size, m_capacity;
+    double* m_data;
+    double m_inline[N];
+    
+};
+
 // ----------------------------------------------------
 
 class expansion
@@ -91,10 +192,14 @@ class expansion
     
 public:
     
-    std::vector<double> v;
+    // Number of components stored without a heap allocation.  Covers the 
+    // exact 2D and 3D orientation determinants and most 4D ones.
+    static const unsigned int INLINE_LENGTH = 32;
+    
+    expansion_buffer<INLINE_LENGTH> v;
     
     expansion()
-    : v(0)
+    : v()
     {}
     
     explicit expansion( double val )
@@ -105,8 +210,6 @@ public:
     : v(n,val)
     {}
     
-    virtual ~expansion() {}
-    
     expansion& operator+=(const expansion &rhs)
     {
         add( *this, rhs, *this );
@@ -129,23 +232,23 @@ public:
     
     inline expansion operator+(const expansion &other) const 
     {
-        expansion result = *this;     
-        result += other;  
+        expansion result;
+        add( *this, other, result );
         return result;              
     }
     
     inline expansion operator-(const expansion &other) const 
     {
-        expansion result = *this;    
-        result -= other;  
+        expansion result;
+        subtract( *this, other, result );
         return result;              
     }
     
     
     inline expansion operator*(const expansion &other) const
     {
-        expansion result = *this;    
-        result *= other;  
+        expansion result;
+        multiply( *this, other, result );
         return result;              
     }
     
@@ -189,7 +292,8 @@ inline void make_expansion( double a, expansion& e )
 { 
     if(a) 
     {
-        e = expansion(1, a); 
+        e.v.resize(1);
+        e.v[0] = a;
     }
     else
     {
@@ -10,8 +10,9 @@
 #ifndef TUNICATE_INTERVAL_H
 #define TUNICATE_INTERVAL_H
 
+#include <algorithm>
 #include <cassert>
-#include "fenv_include.h"
+#include "directedrounding.h"
 #include "intervalbase.h"
 
 class Interval;
@@ -25,19 +26,13 @@ assert( v[0] == v[0] ); \
 assert( v[1] == v[1] );
 #endif
 
-#ifndef DEBUG
-#define CHECK_ROUNDING_MODE() (void)0;
-#else
-#define CHECK_ROUNDING_MODE() assert( fegetround( ) == FE_UPWARD ); 
-#endif
-
-
 // ----------------------------------------
 //
 // class Interval:
 //
 // Stores the interval [a,b] as [-a,b] internally.  With proper arithmetic operations, this 
-// allows us to use only FE_UPWARD and avoid switching rounding modes over and over.
+// allows us to only ever round upward.  Upward rounding is done with the bounds in directedrounding.h rather than by
+// changing the rounding mode, so intervals can be used from any number of threads at once.
 //
 // ----------------------------------------
 
@@ -51,8 +46,6 @@ public:
     // Internal representation
     double v[2];
     
-    static int s_previous_rounding_mode;
-    
 public:
     
     Interval( double val );   
@@ -74,8 +67,10 @@ public:
     
     virtual Interval operator-( ) const;
     
-    static void begin_special_arithmetic();
-    static void end_special_arithmetic();
+    /// No-ops, kept so code templated on the arithmetic type (Interval or expansion) can bracket its computations
+    ///
+    static void begin_special_arithmetic() {}
+    static void end_special_arithmetic() {}
     
 };
 
@@ -129,10 +124,9 @@ inline double Interval::stored_right() const
 
 inline Interval& Interval::operator+=(const Interval &rhs)
 {
-    CHECK_ROUNDING_MODE();
     VERIFY();
-    v[0] += rhs.v[0];
-    v[1] += rhs.v[1];
+    v[0] = add_up( v[0], rhs.v[0] );
+    v[1] = add_up( v[1], rhs.v[1] );
     VERIFY();
     
     return *this;
@@ -142,9 +136,8 @@ inline Interval& Interval::operator+=(const Interval &rhs)
 
 inline Interval& Interval::operator-=( const Interval& rhs )
 {
-    CHECK_ROUNDING_MODE();   
-    v[0] += rhs.v[1];
-    v[1] += rhs.v[0];
+    v[0] = add_up( v[0], rhs.v[1] );
+    v[1] = add_up( v[1], rhs.v[0] );
     VERIFY();
     return *this;
 }
@@ -153,7 +146,6 @@ inline Interval& Interval::operator-=( const Interval& rhs )
 
 inline Interval& Interval::operator*=( const Interval& rhs )
 {
-    CHECK_ROUNDING_MODE();   
     Interval p = (*this) * rhs;
     *this = p;
     return *this;
@@ -163,9 +155,8 @@ inline Interval& Interval::operator*=( const Interval& rhs )
 
 inline Interval Interval::operator+(const Interval &other) const 
 {
-    CHECK_ROUNDING_MODE();   
-    double v0 = v[0] + other.v[0];
-    double v1 = v[1] + other.v[1  ];
+    double v0 = add_up( v[0], other.v[0] );
+    double v1 = add_up( v[1], other.v[1] );
     return Interval(-v0, v1);
 }
 
@@ -173,9 +164,8 @@ inline Interval Interval::operator+(const Interval &other) const
 
 inline Interval Interval::operator-(const Interval &other) const 
 {
-    CHECK_ROUNDING_MODE();   
-    double v0 = v[0] + other.v[1];
-    double v1 = v[1] + other.v[0];
+    double v0 = add_up( v[0], other.v[1] );
+    double v1 = add_up( v[1], other.v[0] );
     return Interval(-v0, v1);              
 }
 
@@ -183,8 +173,6 @@ inline Interval Interval::operator-(const Interval &other) const
 
 inline Interval Interval::operator*(const Interval &other) const
 {
-    CHECK_ROUNDING_MODE();
-    
     double neg_a = v[0];
     double b = v[1];
     double neg_c = other.v[0];
@@ -196,36 +184,36 @@ inline Interval Interval::operator*(const Interval &other) const
     {
         if ( d <= 0 )
         {
-            product.v[0] = -b * d;
-            product.v[1] = neg_a * neg_c;
+            product.v[0] = mul_up( -b, d );
+            product.v[1] = mul_up( neg_a, neg_c );
         }
         else if ( -neg_c <= 0 && 0 <= d )
         {
-            product.v[0] = neg_a * d;
-            product.v[1] = neg_a * neg_c;
+            product.v[0] = mul_up( neg_a, d );
+            product.v[1] = mul_up( neg_a, neg_c );
         }
         else
         {
-            product.v[0] = neg_a * d;
-            product.v[1] = b * -neg_c;
+            product.v[0] = mul_up( neg_a, d );
+            product.v[1] = mul_up( b, -neg_c );
         }
     }
     else if ( -neg_a <= 0 && 0 <= b )
     {
         if ( d <= 0 )
         {
-            product.v[0] = b * neg_c;
-            product.v[1] = neg_a * neg_c;
+            product.v[0] = mul_up( b, neg_c );
+            product.v[1] = mul_up( neg_a, neg_c );
         }
         else if ( -neg_c <= 0 && 0 <= d )
         {
-            product.v[0] = std::max( neg_a * d, b * neg_c );
-            product.v[1] = std::max( neg_a * neg_c, b * d );
+            product.v[0] = std::max( mul_up( neg_a, d ), mul_up( b, neg_c ) );
+            product.v[1] = std::max( mul_up( neg_a, neg_c ), mul_up( b, d ) );
         }
         else
         {
-            product.v[0] = neg_a * d;
-            product.v[1] = b * d;
+            product.v[0] = mul_up( neg_a, d );
+            product.v[1] = mul_up( b, d );
         }
         
     }
@@ -233,18 +221,18 @@ inline Interval Interval::operator*(const Interval &other) const
     {
         if ( d <= 0 )
         {
-            product.v[0] = b * neg_c; 
-            product.v[1] = -neg_a * d;
+            product.v[0] = mul_up( b, neg_c ); 
+            product.v[1] = mul_up( -neg_a, d );
         }
         else if ( -neg_c <= 0 && 0 <= d )
         {
-            product.v[0] = b * neg_c;
-            product.v[1] = b * d;
+            product.v[0] = mul_up( b, neg_c );
+            product.v[1] = mul_up( b, d );
         }
         else
         {
-            product.v[0] = -neg_a * neg_c;
-            product.v[1] = b * d;
+            product.v[0] = mul_up( -neg_a, neg_c );
+            product.v[1] = mul_up( b, d );
         }
     }
     
@@ -257,26 +245,9 @@ inline Interval Interval::operator*(const Interval &other) const
 
 inline Interval Interval::operator-( ) const
 {
-    CHECK_ROUNDING_MODE();
     return Interval( -v[1], v[0] );   
 }
 
-// ----------------------------------------
-
-inline void Interval::begin_special_arithmetic()
-{
-    s_previous_rounding_mode = fegetround();
-    fesetround( FE_UPWARD );
-}
-
-// ----------------------------------------
-
-inline void Interval::end_special_arithmetic()
-{
-    fesetround( s_previous_rounding_mode );
-}
-
-
 // ----------------------------------------
 
 inline void create_from_double( double a, Interval& out )
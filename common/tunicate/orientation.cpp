@@ -1,13 +1,39 @@
 // Released into the public domain by Robert Bridson, 2009.
 
 #include <cassert>
-#include "fenv_include.h"
+#include <cfloat>
 #include <cmath>
 #include <limits>
+#include "directedrounding.h"
 #include "tunicate.h"
 #include "expansion.h"
 #include "neg.h"
 
+//==============================================================================
+// The interval routines below used to evaluate each expression twice, with the
+// rounding mode set downward and then upward.  Changing the mode is slow and
+// affects every computation on the thread, so instead:
+//  - if no product can underflow or overflow, evaluate once in the current
+//    mode and pad by a bound on the accumulated rounding error (as in
+//    Shewchuk's predicates), computed from the same terms in absolute value;
+//  - otherwise, evaluate with the explicit bounds from directedrounding.h.
+// None of these touch the floating-point environment, so they are thread-safe.
+
+//==============================================================================
+// True if every value is zero or has magnitude in [2^-300, 2^300], in which
+// case products of up to three of them are normal numbers.
+static bool
+in_safe_range(const double* x,
+              int n)
+{
+    const double tiny=std::ldexp(1.0, -300), huge=std::ldexp(1.0, 300);
+    for(int i=0; i<n; ++i){
+        double a=std::fabs(x[i]);
+        if(a!=0 && (a<tiny || a>huge)) return false;
+    }
+    return true;
+}
+
 //==============================================================================
 double
 orientation1d(const double* x0,
@@ -28,6 +54,35 @@ simple_orientation2d(const double* x0,
     + x2[0]*x0[1] + neg(x2[0])*x1[1];
 }
 
+//==============================================================================
+// Sum of the absolute values of the terms of simple_orientation2d.
+static double
+permanent2d(const double* x0,
+            const double* x1,
+            const double* x2)
+{
+    return std::fabs(x0[0])*(std::fabs(x1[1])+std::fabs(x2[1]))
+    + std::fabs(x1[0])*(std::fabs(x2[1])+std::fabs(x0[1]))
+    + std::fabs(x2[0])*(std::fabs(x0[1])+std::fabs(x1[1]));
+}
+
+//==============================================================================
+// simple_orientation2d, rounded in the direction given by R.
+template<class R>
+static double
+directed_orientation2d(const double* x0,
+                       const double* x1,
+                       const double* x2)
+{
+    double sum=R::mul(x0[0], x1[1]);
+    sum=R::add(sum, R::mul(-x0[0], x2[1]));
+    sum=R::add(sum, R::mul( x1[0], x2[1]));
+    sum=R::add(sum, R::mul(-x1[0], x0[1]));
+    sum=R::add(sum, R::mul( x2[0], x0[1]));
+    sum=R::add(sum, R::mul(-x2[0], x1[1]));
+    return sum;
+}
+
 //==============================================================================
 void
 interval_orientation2d(const double* x0,
@@ -36,10 +91,19 @@ interval_orientation2d(const double* x0,
                        double* lower,
                        double* upper)
 {
-    fesetround(FE_DOWNWARD);
-    *lower=simple_orientation2d(x0, x1, x2);
-    fesetround(FE_UPWARD);
-    *upper=simple_orientation2d(x0, x1, x2);
+    const double x[6]={x0[0], x0[1], x1[0], x1[1], x2[0], x2[1]};
+    if(in_safe_range(x, 6)){
+        // 6 products and 5 sums: error under 6u times the permanent
+        // (u=DBL_EPSILON/2); pad by 12u to also cover the rounding of the
+        // permanent and of the padding itself
+        double value=simple_orientation2d(x0, x1, x2);
+        double error=6*DBL_EPSILON*permanent2d(x0, x1, x2);
+        *lower=value-error;
+        *upper=value+error;
+    }else{
+        *lower=directed_orientation2d<RoundDown>(x0, x1, x2);
+        *upper=directed_orientation2d<RoundUp>(x0, x1, x2);
+    }
     assert(*lower<=*upper);
 }
 
@@ -82,7 +146,6 @@ orientation2d(const double* x0,
     assert(x0 && x1 && x2);
     double lower, upper;
     interval_orientation2d(x0, x1, x2, &lower, &upper);
-    fesetround(FE_TONEAREST);
     if(upper<0 || lower>0)
         return 0.5*(lower+upper);
     else if(lower==upper) // and hence are both equal to zero
@@ -92,53 +155,86 @@ orientation2d(const double* x0,
 }
 
 //==============================================================================
-// Multiply three numbers together in a way where the rounding mode is
-// respected (upward or downward) no matter the signs of the factors.
+// Multiply three numbers together in a way where the rounding direction given
+// by R is respected no matter the signs of the factors.
+template<class R>
 static double
 three_product(double a,
               double b,
               double c)
 {
     if(a>0)
-        return a*(b*c);
+        return R::mul(a, R::mul(b, c));
     else
-        return neg(a)*(-b*c);
+        return R::mul(-a, R::mul(-b, c));
 }
 
 //==============================================================================
+// Evaluated in the current rounding mode.
+struct RoundNearest
+{
+    static double add(double a, double b) { return a+b; }
+    static double mul(double a, double b) { return a*b; }
+};
+
+//==============================================================================
+template<class R>
 static double
 simple_orientation3d(const double* x0,
                      const double* x1,
                      const double* x2,
                      const double* x3)
 {
-    return three_product( x0[0], x1[1], x2[2])
-    + three_product(-x0[0], x1[1], x3[2])
-    + three_product(-x0[0], x2[1], x1[2])
-    + three_product( x0[0], x2[1], x3[2])
-    + three_product( x0[0], x3[1], x1[2])
-    + three_product(-x0[0], x3[1], x2[2])
+    double sum=three_product<R>( x0[0], x1[1], x2[2]);
+    sum=R::add(sum, three_product<R>(-x0[0], x1[1], x3[2]));
+    sum=R::add(sum, three_product<R>(-x0[0], x2[1], x1[2]));
+    sum=R::add(sum, three_product<R>( x0[0], x2[1], x3[2]));
+    sum=R::add(sum, three_product<R>( x0[0], x3[1], x1[2]));
+    sum=R::add(sum, three_product<R>(-x0[0], x3[1], x2[2]));
     
-    + three_product(-x1[0], x0[1], x2[2])
-    + three_product( x1[0], x0[1], x3[2])
-    + three_product( x1[0], x2[1], x0[2])
-    + three_product(-x1[0], x2[1], x3[2])
-    + three_product(-x1[0], x3[1], x0[2])
-    + three_product( x1[0], x3[1], x2[2])
+    sum=R::add(sum, three_product<R>(-x1[0], x0[1], x2[2]));
+    sum=R::add(sum, three_product<R>( x1[0], x0[1], x3[2]));
+    sum=R::add(sum, three_product<R>( x1[0], x2[1], x0[2]));
+    sum=R::add(sum, three_product<R>(-x1[0], x2[1], x3[2]));
+    sum=R::add(sum, three_product<R>(-x1[0], x3[1], x0[2]));
+    sum=R::add(sum, three_product<R>( x1[0], x3[1], x2[2]));
     
-    + three_product( x2[0], x0[1], x1[2])
-    + three_product(-x2[0], x0[1], x3[2])
-    + three_product(-x2[0], x1[1], x0[2])
-    + three_product( x2[0], x1[1], x3[2])
-    + three_product( x2[0], x3[1], x0[2])
-    + three_product(-x2[0], x3[1], x1[2])
+    sum=R::add(sum, three_product<R>( x2[0], x0[1], x1[2]));
+    sum=R::add(sum, three_product<R>(-x2[0], x0[1], x3[2]));
+    sum=R::add(sum, three_product<R>(-x2[0], x1[1], x0[2]));
+    sum=R::add(sum, three_product<R>( x2[0], x1[1], x3[2]));
+    sum=R::add(sum, three_product<R>( x2[0], x3[1], x0[2]));
+    sum=R::add(sum, three_product<R>(-x2[0], x3[1], x1[2]));
     
-    + three_product(-x3[0], x0[1], x1[2])
-    + three_product( x3[0], x0[1], x2[2])
-    + three_product( x3[0], x1[1], x0[2])
-    + three_product(-x3[0], x1[1], x2[2])
-    + three_product(-x3[0], x2[1], x0[2])
-    + three_product( x3[0], x2[1], x1[2]);
+    sum=R::add(sum, three_product<R>(-x3[0], x0[1], x1[2]));
+    sum=R::add(sum, three_product<R>( x3[0], x0[1], x2[2]));
+    sum=R::add(sum, three_product<R>( x3[0], x1[1], x0[2]));
+    sum=R::add(sum, three_product<R>(-x3[0], x1[1], x2[2]));
+    sum=R::add(sum, three_product<R>(-x3[0], x2[1], x0[2]));
+    sum=R::add(sum, three_product<R>( x3[0], x2[1], x1[2]));
+    return sum;
+}
+
+//==============================================================================
+// Sum of the absolute values of the terms of simple_orientation3d.
+static double
+permanent3d(const double* x0,
+            const double* x1,
+            const double* x2,
+            const double* x3)
+{
+    const double a0[3]={std::fabs(x0[0]), std::fabs(x0[1]), std::fabs(x0[2])};
+    const double a1[3]={std::fabs(x1[0]), std::fabs(x1[1]), std::fabs(x1[2])};
+    const double a2[3]={std::fabs(x2[0]), std::fabs(x2[1]), std::fabs(x2[2])};
+    const double a3[3]={std::fabs(x3[0]), std::fabs(x3[1]), std::fabs(x3[2])};
+    return a0[0]*a1[1]*a2[2] + a0[0]*a1[1]*a3[2] + a0[0]*a2[1]*a1[2]
+    + a0[0]*a2[1]*a3[2] + a0[0]*a3[1]*a1[2] + a0[0]*a3[1]*a2[2]
+    + a1[0]*a0[1]*a2[2] + a1[0]*a0[1]*a3[2] + a1[0]*a2[1]*a0[2]
+    + a1[0]*a2[1]*a3[2] + a1[0]*a3[1]*a0[2] + a1[0]*a3[1]*a2[2]
+    + a2[0]*a0[1]*a1[2] + a2[0]*a0[1]*a3[2] + a2[0]*a1[1]*a0[2]
+    + a2[0]*a1[1]*a3[2] + a2[0]*a3[1]*a0[2] + a2[0]*a3[1]*a1[2]
+    + a3[0]*a0[1]*a1[2] + a3[0]*a0[1]*a2[2] + a3[0]*a1[1]*a0[2]
+    + a3[0]*a1[1]*a2[2] + a3[0]*a2[1]*a0[2] + a3[0]*a2[1]*a1[2];
 }
 
 //==============================================================================
@@ -150,10 +246,20 @@ interval_orientation3d(const double* x0,
                        double* lower,
                        double* upper)
 {
-    fesetround(FE_DOWNWARD);
-    *lower=simple_orientation3d(x0, x1, x2, x3);
-    fesetround(FE_UPWARD);
-    *upper=simple_orientation3d(x0, x1, x2, x3);
+    const double x[12]={x0[0], x0[1], x0[2], x1[0], x1[1], x1[2],
+                        x2[0], x2[1], x2[2], x3[0], x3[1], x3[2]};
+    if(in_safe_range(x, 12)){
+        // 48 products and 23 sums: error under 26u times the permanent
+        // (u=DBL_EPSILON/2); pad by 32u to also cover the rounding of the
+        // permanent and of the padding itself
+        double value=simple_orientation3d<RoundNearest>(x0, x1, x2, x3);
+        double error=16*DBL_EPSILON*permanent3d(x0, x1, x2, x3);
+        *lower=value-error;
+        *upper=value+error;
+    }else{
+        *lower=simple_orientation3d<RoundDown>(x0, x1, x2, x3);
+        *upper=simple_orientation3d<RoundUp>(x0, x1, x2, x3);
+    }
 #ifdef _MSC_VER
     assert( !_isnan(*lower) );
     assert( !_isnan(*upper) );
@@ -219,7 +325,6 @@ orientation3d(const double* x0,
     assert(x0 && x1 && x2 && x3);
     double lower, upper;
     interval_orientation3d(x0, x1, x2, x3, &lower, &upper);
-    fesetround(FE_TONEAREST);
     if(upper<0 || lower>0)
         return 0.5*(lower+upper);
     else if(lower==upper) // and hence exactly zero
@@ -248,10 +353,8 @@ interval_orientation_time3d(const double* x0, int time0,
     if(time3) interval_orientation3d(x0, x1, x2, x4, &lower0124, &upper0124);
     double lower0123=0, upper0123=0;
     if(time4) interval_orientation3d(x0, x1, x2, x3, &lower0123, &upper0123);
-    fesetround(FE_DOWNWARD);
-    *lower=-upper1234+lower0234-upper0134+lower0124-upper0123;
-    fesetround(FE_UPWARD);
-    *upper=-lower1234+upper0234-lower0134+upper0124-lower0123;
+    *lower=add_down(add_down(add_down(add_down(-upper1234, lower0234), -upper0134), lower0124), -upper0123);
+    *upper=add_up(add_up(add_up(add_up(-lower1234, upper0234), -lower0134), upper0124), -lower0123);
     assert(*lower<=*upper);
 }
 
@@ -317,7 +420,6 @@ orientation_time3d(const double* x0, int time0,
     double lower, upper;
     interval_orientation_time3d(x0, time0, x1, time1, x2, time2, x3, time3,
                                 x4, time4, &lower, &upper);
-    fesetround(FE_TONEAREST);
     if(upper<0 || lower>0)
         return 0.5*(lower+upper);
     else if(lower==upper) // and hence exactly zero
@@ -347,18 +449,19 @@ interval_orientation4d(const double* x0,
     interval_orientation3d(x0+1, x1+1, x2+1, x4+1, &lower0124, &upper0124);
     double lower0123, upper0123;
     interval_orientation3d(x0+1, x1+1, x2+1, x3+1, &lower0123, &upper0123);
-    fesetround(FE_DOWNWARD);
-    *lower= x0[0]*(x0[0]<0 ? upper1234 : lower1234)
-    +neg(x1[0])*(x1[0]>0 ? upper0234 : lower0234)
-    +x2[0]*(x2[0]<0 ? upper0134 : lower0134)
-    +neg(x3[0])*(x3[0]>0 ? upper0124 : lower0124)
-    +x4[0]*(x4[0]<0 ? upper0123 : lower0123);
-    fesetround(FE_UPWARD);
-    *upper= x0[0]*(x0[0]>0 ? upper1234 : lower1234)
-    +neg(x1[0])*(x1[0]<0 ? upper0234 : lower0234)
-    +x2[0]*(x2[0]>0 ? upper0134 : lower0134)
-    +neg(x3[0])*(x3[0]<0 ? upper0124 : lower0124)
-    +x4[0]*(x4[0]>0 ? upper0123 : lower0123);
+    double sum;
+    sum=mul_down(x0[0], x0[0]<0 ? upper1234 : lower1234);
+    sum=add_down(sum, mul_down(-x1[0], x1[0]>0 ? upper0234 : lower0234));
+    sum=add_down(sum, mul_down( x2[0], x2[0]<0 ? upper0134 : lower0134));
+    sum=add_down(sum, mul_down(-x3[0], x3[0]>0 ? upper0124 : lower0124));
+    sum=add_down(sum, mul_down( x4[0], x4[0]<0 ? upper0123 : lower0123));
+    *lower=sum;
+    sum=mul_up(x0[0], x0[0]>0 ? upper1234 : lower1234);
+    sum=add_up(sum, mul_up(-x1[0], x1[0]<0 ? upper0234 : lower0234));
+    sum=add_up(sum, mul_up( x2[0], x2[0]>0 ? upper0134 : lower0134));
+    sum=add_up(sum, mul_up(-x3[0], x3[0]<0 ? upper0124 : lower0124));
+    sum=add_up(sum, mul_up( x4[0], x4[0]>0 ? upper0123 : lower0123));
+    *upper=sum;
     assert(*lower<=*upper);
 }
 
@@ -451,7 +554,6 @@ orientation4d(const double* x0,
     assert(x0 && x1 && x2 && x3 && x4);
     double lower, upper;
     interval_orientation4d(x0, x1, x2, x3, x4, &lower, &upper);
-    fesetround(FE_TONEAREST);
     if(upper<0 || lower>0)
         return 0.5*(lower+upper);
     else if(lower==upper) // and hence exactly zero
@@ -1,5 +1,7 @@
 
 #include "rootparitycollisiontest.h"
+#include <cfloat>
+#include <cmath>
 #include <cstdlib>
 
 namespace rootparity 
@@ -262,102 +264,30 @@ namespace rootparity
         
         /// --------------------------------------------------------
         
-        inline void add( Vec3d& a, const Vec3d& b )
-        {
-            a[0] += b[0];
-            a[1] += b[1];
-            a[2] += b[2];
-        }
-        
-        /// --------------------------------------------------------
-        
-        inline void sub( Vec3d& a, const Vec3d& b )
+        /// Set out to the interval [a-b, a-b], rounded outward
+        ///
+        inline void interval_difference( const Vec3d& a, const Vec3d& b, Vec<3,IntervalType>& out )
         {
-            a[0] -= b[0];
-            a[1] -= b[1];
-            a[2] -= b[2];
+            for ( unsigned int i = 0; i < 3; ++i )
+            {
+                out[i].v[0] = sub_up( b[i], a[i] );
+                out[i].v[1] = sub_up( a[i], b[i] );
+            }
         }
         
         // --------------------------------------------------------
         
+        /// At a domain corner, the edge-edge collision function is the difference between one vertex of each edge, so
+        /// evaluate it with a single outward rounding instead of expanding the general formula.
+        ///
         inline void edge_edge_collision_function(const Vec3d &d_x0,    const Vec3d &d_x1,    const Vec3d &d_x2,    const Vec3d &d_x3,
                                                  const Vec3d &d_x0new, const Vec3d &d_x1new, const Vec3d &d_x2new, const Vec3d &d_x3new,
                                                  bool b_t, bool b_u, bool b_v,
                                                  Vec<3,IntervalType>& out )
         {
-            
-            Vec3d out_lower( -d_x0[0], -d_x0[1], -d_x0[2] );
-            add( out_lower, d_x2 );
-            
-            Vec3d out_upper( d_x0[0], d_x0[1], d_x0[2] );
-            sub( out_upper, d_x2 );
-            
-            if ( b_t )
-            {
-                
-                sub( out_lower, d_x0new );
-                add( out_lower, d_x0 );
-                add( out_lower, d_x2new );
-                sub( out_lower, d_x2 );
-                
-                add( out_upper, d_x0new );
-                sub( out_upper, d_x0 );
-                sub( out_upper, d_x2new );
-                add( out_upper, d_x2 );
-                
-                if ( b_u )
-                {
-                    sub( out_lower, d_x0 );
-                    add( out_lower, d_x0new );
-                    sub( out_lower, d_x1new );
-                    add( out_lower, d_x1 );
-                    
-                    add( out_upper, d_x0 );
-                    sub( out_upper, d_x0new );
-                    add( out_upper, d_x1new );
-                    sub( out_upper, d_x1 );
-                }
-                
-                if ( b_v )
-                {
-                    sub( out_lower, d_x2new );
-                    add( out_lower, d_x2 );
-                    add( out_lower, d_x3new );
-                    sub( out_lower, d_x3 );
-                    
-                    add( out_upper, d_x2new );
-                    sub( out_upper, d_x2 );
-                    sub( out_upper, d_x3new );
-                    add( out_upper, d_x3 );
-                }
-            }
-            
-            if ( b_u )
-            {
-                sub( out_lower, d_x1 );
-                add( out_lower, d_x0 );
-                
-                add( out_upper, d_x1 );
-                sub( out_upper, d_x0 );
-            }
-            
-            if ( b_v )
-            {
-                sub( out_lower, d_x2 );
-                add( out_lower, d_x3 );
-                
-                add( out_upper, d_x2 );
-                sub( out_upper, d_x3 );
-            }
-            
-            out[0].v[0] = out_lower[0];
-            out[1].v[0] = out_lower[1];
-            out[2].v[0] = out_lower[2];
-            
-            out[0].v[1] = out_upper[0];
-            out[1].v[1] = out_upper[1];
-            out[2].v[1] = out_upper[2];
-            
+            const Vec3d& a = b_t ? ( b_u ? d_x1new : d_x0new ) : ( b_u ? d_x1 : d_x0 );
+            const Vec3d& b = b_t ? ( b_v ? d_x3new : d_x2new ) : ( b_v ? d_x3 : d_x2 );
+            interval_difference( a, b, out );
         }
         
         
@@ -425,83 +355,18 @@ namespace rootparity
         
         /// --------------------------------------------------------
         
-        
+        /// At a domain corner, the point-triangle collision function is the difference between the point and one triangle
+        /// vertex.
+        ///
         void point_triangle_collision_function(const Vec3d &d_x0,    const Vec3d &d_x1,    const Vec3d &d_x2,    const Vec3d &d_x3,
                                                const Vec3d &d_x0new, const Vec3d &d_x1new, const Vec3d &d_x2new, const Vec3d &d_x3new,
                                                bool b_t, bool b_u, bool b_v,
                                                Vec<3,IntervalType>& out )
         {
-            
-            Vec3d out_lower( -d_x0[0], -d_x0[1], -d_x0[2] );
-            Vec3d out_upper( d_x0[0], d_x0[1], d_x0[2] );
-            
-            add( out_lower, d_x1 );
-            sub( out_upper, d_x1 );
-            
-            if ( b_t )
-            {
-                sub( out_lower, d_x0new );
-                add( out_lower, d_x0 );
-                add( out_lower, d_x1new );
-                sub( out_lower, d_x1 );
-                
-                add( out_upper, d_x0new );
-                sub( out_upper, d_x0 );
-                sub( out_upper, d_x1new );
-                add( out_upper, d_x1 );
-                
-                if ( b_u )
-                {
-                    sub( out_lower, d_x1new );
-                    add( out_lower, d_x1 );
-                    add( out_lower, d_x2new );
-                    sub( out_lower, d_x2 );
-                    
-                    add( out_upper, d_x1new );
-                    sub( out_upper, d_x1 );
-                    sub( out_upper, d_x2new );
-                    add( out_upper, d_x2 );
-                }
-                
-                if ( b_v )
-                {
-                    sub( out_lower, d_x1new );
-                    add( out_lower, d_x1 );
-                    add( out_lower, d_x3new );
-                    sub( out_lower, d_x3 );
-                    
-                    add( out_upper, d_x1new );
-                    sub( out_upper, d_x1 );
-                    sub( out_upper, d_x3new );
-                    add( out_upper, d_x3 );
-                }
-            }
-            
-            if ( b_u )
-            {
-                sub( out_lower, d_x1 );
-                add( out_lower, d_x2 );
-                add( out_upper, d_x1 );
-                sub( out_upper, d_x2 );
-            }
-            
-            if ( b_v )
-            {
-                sub( out_lower, d_x1 );
-                add( out_lower, d_x3 );
-                
-                add( out_upper, d_x1 );
-                sub( out_upper, d_x3 );
-            }
-            
-            out[0].v[0] = out_lower[0];
-            out[1].v[0] = out_lower[1];
-            out[2].v[0] = out_lower[2];
-            
-            out[0].v[1] = out_upper[0];
-            out[1].v[1] = out_upper[1];
-            out[2].v[1] = out_upper[2];
-            
+            assert( !( b_u && b_v ) );
+            const Vec3d& a = b_t ? d_x0new : d_x0;
+            const Vec3d& b = b_t ? ( b_u ? d_x2new : ( b_v ? d_x3new : d_x1new ) ) : ( b_u ? d_x2 : ( b_v ? d_x3 : d_x1 ) );
+            interval_difference( a, b, out );
         }
         
         
@@ -647,6 +512,84 @@ namespace rootparity
         }
         
         
+        // --------------------------------------------------------
+        
+        /// Absolute determinant terms, for bounding the error in orientation3d
+        ///
+        inline double orientation3d_permanent( const Vec3d* a )
+        {
+            using std::fabs;
+            return fabs( a[0][0] * a[1][1] ) * ( fabs( a[2][2] ) + fabs( a[3][2] ) )
+            + fabs( a[0][0] * a[2][1] ) * ( fabs( a[3][2] ) + fabs( a[1][2] ) )
+            + fabs( a[0][0] * a[3][1] ) * ( fabs( a[1][2] ) + fabs( a[2][2] ) )
+            + fabs( a[1][0] * a[0][1] ) * ( fabs( a[3][2] ) + fabs( a[2][2] ) )
+            + fabs( a[1][0] * a[2][1] ) * ( fabs( a[0][2] ) + fabs( a[3][2] ) )
+            + fabs( a[1][0] * a[3][1] ) * ( fabs( a[2][2] ) + fabs( a[0][2] ) )
+            + fabs( a[2][0] * a[0][1] ) * ( fabs( a[1][2] ) + fabs( a[3][2] ) )
+            + fabs( a[2][0] * a[1][1] ) * ( fabs( a[3][2] ) + fabs( a[0][2] ) )
+            + fabs( a[2][0] * a[3][1] ) * ( fabs( a[0][2] ) + fabs( a[1][2] ) )
+            + fabs( a[3][0] * a[0][1] ) * ( fabs( a[2][2] ) + fabs( a[1][2] ) )
+            + fabs( a[3][0] * a[1][1] ) * ( fabs( a[0][2] ) + fabs( a[2][2] ) )
+            + fabs( a[3][0] * a[2][1] ) * ( fabs( a[1][2] ) + fabs( a[0][2] ) );
+        }
+        
+        // --------------------------------------------------------
+        
+        /// Interval orientation3d, evaluated at the interval midpoints in plain floating point with a bound on the error 
+        /// from both the interval radii and rounding.  About as tight as interval arithmetic on the narrow intervals the 
+        /// collision test produces, with a fraction of the work.  Inputs too large or small for the bound to hold are
+        /// handed to the generic interval version.
+        ///
+        inline void orientation3d(const Vec<3,IntervalType>& x0,
+                                  const Vec<3,IntervalType>& x1,
+                                  const Vec<3,IntervalType>& x2,
+                                  const Vec<3,IntervalType>& x3,
+                                  IntervalType& result )
+        {
+            const Vec<3,IntervalType>* x[4] = { &x0, &x1, &x2, &x3 };
+            
+            Vec3d mid[4];        // interval midpoints
+            Vec3d abs_mid[4];
+            Vec3d abs_max[4];    // upper bounds on the magnitudes of the interval endpoints
+            const double tiny = std::ldexp( 1.0, -300 ), huge = std::ldexp( 1.0, 300 );
+            bool in_range = true;
+            
+            for ( unsigned int i = 0; i < 4; ++i )
+            {
+                for ( unsigned int j = 0; j < 3; ++j )
+                {
+                    const double neg_lower = (*x[i])[j].v[0];
+                    const double upper = (*x[i])[j].v[1];
+                    const double m = 0.5 * ( upper - neg_lower );
+                    const double radius = std::max( sub_up( upper, m ), add_up( neg_lower, m ) );
+                    mid[i][j] = m;
+                    abs_mid[i][j] = std::fabs( m );
+                    abs_max[i][j] = add_up( abs_mid[i][j], radius );
+                    in_range = in_range && ( abs_max[i][j] == 0 || ( abs_max[i][j] >= tiny && abs_max[i][j] <= huge ) );
+                }
+            }
+            
+            if ( !in_range )
+            {
+                orientation3d<IntervalType>( x0, x1, x2, x3, result );
+                return;
+            }
+            
+            double det;
+            orientation3d( mid[0], mid[1], mid[2], mid[3], det );
+            
+            // The determinant moves by at most permanent(abs_max) - permanent(abs_mid) over the intervals, and its 
+            // evaluation at the midpoints is off by at most 16*eps*permanent(abs_mid).  The constant also covers rounding 
+            // in the permanents themselves.
+            
+            const double max_permanent = orientation3d_permanent( abs_max );
+            const double mid_permanent = orientation3d_permanent( abs_mid );
+            const double error = ( max_permanent - mid_permanent ) + 64.0 * DBL_EPSILON * max_permanent;
+            
+            result.v[0] = add_up( -det, error );
+            result.v[1] = add_up( det, error );
+        }
+        
         // --------------------------------------------------------
         
         inline void orientation3d(const Vec<3,expansion>& x0,
@@ -757,7 +700,6 @@ namespace rootparity
         {
             assert( k == 1 );
             assert(out_alpha0 && out_alpha1 && out_alpha2);
-            assert(fegetround()== FE_TONEAREST);
             
             if( sign(x1-x2) < 0 )
             {
@@ -802,7 +744,6 @@ namespace rootparity
                                          double* out_alpha2 )
         {
             assert(k==1);
-            assert(fegetround()== FE_TONEAREST);
             
             // try projecting each coordinate out in turn
             
@@ -849,7 +790,6 @@ namespace rootparity
                                              double* out_alpha3)
         {
             assert(1<=k && k<=3);
-            assert(fegetround()== FE_TONEAREST);
             
             switch(k)
             {
@@ -965,7 +905,6 @@ namespace rootparity
                                               double* )
         {
             assert(k<=2);
-            assert(fegetround()== FE_TONEAREST);
             
             // try projecting each coordinate out in turn
             
@@ -1063,7 +1002,6 @@ namespace rootparity
                                                       double* alpha4)
         {
             
-            assert(fegetround()== FE_TONEAREST);
             
             // degenerate: point and tetrahedron in same plane
             if (expansion_simplex_intersection3d(1, x0, x2, x3, x4, alpha0, alpha2, alpha3, alpha4))
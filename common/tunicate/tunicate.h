@@ -6,10 +6,9 @@
 // Warning: this code hasn't been formally proven to be correct, and
 // almost certainly *will* fail in cases of overflow or underflow.
 
-// Note: all routines (except in 1d) internally change the floating point
-// rounding mode, and set it to the usual "round-to-nearest" on exit. If the
-// calling code relies on it being something else, you must arrange this
-// yourself.
+// Note: none of these routines change the floating point rounding mode, and
+// they are safe to call from several threads at once. The exact fallbacks
+// assume the usual "round-to-nearest" mode is in effect.
 
 #ifdef __cplusplus
 extern "C" {
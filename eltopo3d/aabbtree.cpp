@@ -0,0 +1,582 @@
+// ---------------------------------------------------------
+//
+//  aabbtree.cpp
+//
+//  A bounding volume hierarchy collision test culling structure.
+//
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Includes
+// ---------------------------------------------------------
+
+#include "aabbtree.h"
+
+#include <algorithm>
+#include <cassert>
+
+// ---------------------------------------------------------
+// Global externs
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Local constants, typedefs, macros
+// ---------------------------------------------------------
+
+namespace {
+
+/// Number of buckets used when evaluating the surface area heuristic
+const int NUM_SAH_BINS = 16;
+
+// ---------------------------------------------------------
+// Static function definitions
+// ---------------------------------------------------------
+
+/// Half the surface area of an AABB, which is proportional to the probability of a random ray or box hitting it
+inline double half_area( const Vec3d& xmin, const Vec3d& xmax )
+{
+    Vec3d d = xmax - xmin;
+    return d[0]*d[1] + d[1]*d[2] + d[2]*d[0];
+}
+
+inline bool aabbs_overlap( const Vec3d& amin, const Vec3d& amax, const Vec3d& bmin, const Vec3d& bmax )
+{
+    return ( amin[0] <= bmax[0] && amin[1] <= bmax[1] && amin[2] <= bmax[2] ) &&
+           ( amax[0] >= bmin[0] && amax[1] >= bmin[1] && amax[2] >= bmin[2] );
+}
+
+/// Predicate for partitioning elements by SAH bucket
+struct BelowSplit
+{
+    BelowSplit( const std::vector<Vec3d>& xmins, const std::vector<Vec3d>& xmaxs,
+                unsigned int axis, double cmin, double bin_scale, int split ) :
+        m_xmins( xmins ), m_xmaxs( xmaxs ), m_axis( axis ), m_cmin( cmin ), m_bin_scale( bin_scale ), m_split( split )
+    {}
+
+    bool operator()( size_t e ) const
+    {
+        double c = 0.5 * ( m_xmins[e][m_axis] + m_xmaxs[e][m_axis] );
+        int b = std::min( NUM_SAH_BINS - 1, (int) ( ( c - m_cmin ) * m_bin_scale ) );
+        return b < m_split;
+    }
+
+    const std::vector<Vec3d>& m_xmins;
+    const std::vector<Vec3d>& m_xmaxs;
+    unsigned int m_axis;
+    double m_cmin, m_bin_scale;
+    int m_split;
+};
+
+}
+
+// ---------------------------------------------------------
+// Member function definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Default constructor: empty tree
+///
+// --------------------------------------------------------
+
+AABBTree::AABBTree() :
+    m_elementxmins(0),
+    m_elementxmaxs(0),
+    m_nodes(0),
+    m_freenodes(0),
+    m_root(-1),
+    m_elementleaf(0)
+{}
+
+// --------------------------------------------------------
+///
+/// Get an unused node, either from the free list or by growing the node array
+///
+// --------------------------------------------------------
+
+int AABBTree::allocate_node()
+{
+    if ( !m_freenodes.empty() )
+    {
+        int n = m_freenodes.back();
+        m_freenodes.pop_back();
+        return n;
+    }
+
+    m_nodes.push_back( Node() );
+    return (int) m_nodes.size() - 1;
+}
+
+// --------------------------------------------------------
+///
+/// Return a node to the free list
+///
+// --------------------------------------------------------
+
+void AABBTree::free_node( int n )
+{
+    m_nodes[n].m_parent = -1;
+    m_nodes[n].m_left = m_nodes[n].m_right = -1;
+    m_freenodes.push_back( n );
+}
+
+// --------------------------------------------------------
+///
+/// Build the tree from scratch over the given set of elements
+///
+// --------------------------------------------------------
+
+void AABBTree::build( const std::vector<Vec3d>& xmins, const std::vector<Vec3d>& xmaxs, const std::vector<size_t>& indices )
+{
+    assert( xmaxs.size() == xmins.size() );
+    assert( xmins.size() == indices.size() );
+
+    clear();
+
+    size_t max_index = 0;
+    for ( size_t i = 0; i < indices.size(); ++i )
+    {
+        max_index = std::max( max_index, indices[i] + 1 );
+    }
+
+    m_elementxmins.resize( max_index );
+    m_elementxmaxs.resize( max_index );
+    m_elementleaf.resize( max_index, -1 );
+
+    std::vector<size_t> elements;
+    elements.reserve( indices.size() );
+
+    for ( size_t i = 0; i < indices.size(); ++i )
+    {
+        m_elementxmins[indices[i]] = xmins[i];
+        m_elementxmaxs[indices[i]] = xmaxs[i];
+
+        // don't add inside-out AABBs
+        if ( xmins[i][0] > xmaxs[i][0] )  { continue; }
+
+        elements.push_back( indices[i] );
+    }
+
+    if ( elements.empty() ) { return; }
+
+    m_nodes.reserve( 2 * elements.size() );
+    m_root = build_subtree( elements, 0, elements.size(), -1 );
+}
+
+// --------------------------------------------------------
+///
+/// Recursively build the subtree over elements[begin, end), splitting at the bucket boundary with the lowest surface
+/// area heuristic cost along the axis of greatest centroid extent.  Returns the index of the subtree root.
+///
+// --------------------------------------------------------
+
+int AABBTree::build_subtree( std::vector<size_t>& elements, size_t begin, size_t end, int parent )
+{
+    assert( end > begin );
+
+    int n = allocate_node();
+    m_nodes[n].m_parent = parent;
+
+    if ( end - begin == 1 )
+    {
+        size_t e = elements[begin];
+        m_nodes[n].m_xmin = m_elementxmins[e];
+        m_nodes[n].m_xmax = m_elementxmaxs[e];
+        m_nodes[n].m_left = m_nodes[n].m_right = -1;
+        m_nodes[n].m_element = e;
+        m_elementleaf[e] = n;
+        return n;
+    }
+
+    // bounds of the element AABBs and of their centroids
+
+    Vec3d xmin = m_elementxmins[elements[begin]], xmax = m_elementxmaxs[elements[begin]];
+    Vec3d cmin = 0.5 * ( xmin + xmax ), cmax = cmin;
+
+    for ( size_t i = begin; i < end; ++i )
+    {
+        size_t e = elements[i];
+        update_minmax( m_elementxmins[e], xmin, xmax );
+        update_minmax( m_elementxmaxs[e], xmin, xmax );
+        update_minmax( Vec3d( 0.5 * ( m_elementxmins[e] + m_elementxmaxs[e] ) ), cmin, cmax );
+    }
+
+    m_nodes[n].m_xmin = xmin;
+    m_nodes[n].m_xmax = xmax;
+
+    unsigned int axis = 0;
+    if ( cmax[1] - cmin[1] > cmax[axis] - cmin[axis] ) { axis = 1; }
+    if ( cmax[2] - cmin[2] > cmax[axis] - cmin[axis] ) { axis = 2; }
+
+    size_t mid = begin + ( end - begin ) / 2;
+
+    double extent = cmax[axis] - cmin[axis];
+
+    if ( extent > 0.0 )
+    {
+        // bin the centroids
+
+        double bin_scale = NUM_SAH_BINS / extent;
+
+        size_t bin_counts[NUM_SAH_BINS];
+        Vec3d bin_xmins[NUM_SAH_BINS], bin_xmaxs[NUM_SAH_BINS];
+
+        for ( int b = 0; b < NUM_SAH_BINS; ++b )
+        {
+            bin_counts[b] = 0;
+        }
+
+        for ( size_t i = begin; i < end; ++i )
+        {
+            size_t e = elements[i];
+            double c = 0.5 * ( m_elementxmins[e][axis] + m_elementxmaxs[e][axis] );
+            int b = std::min( NUM_SAH_BINS - 1, (int) ( ( c - cmin[axis] ) * bin_scale ) );
+
+            if ( bin_counts[b] == 0 )
+            {
+                bin_xmins[b] = m_elementxmins[e];
+                bin_xmaxs[b] = m_elementxmaxs[e];
+            }
+            else
+            {
+                bin_xmins[b] = min_union( bin_xmins[b], m_elementxmins[e] );
+                bin_xmaxs[b] = max_union( bin_xmaxs[b], m_elementxmaxs[e] );
+            }
+            ++bin_counts[b];
+        }
+
+        // sweep from the right to get the cost of everything above each split plane
+
+        double right_costs[NUM_SAH_BINS];
+        size_t right_count = 0;
+        Vec3d right_xmin, right_xmax;
+
+        for ( int b = NUM_SAH_BINS - 1; b > 0; --b )
+        {
+            if ( bin_counts[b] > 0 )
+            {
+                if ( right_count == 0 )
+                {
+                    right_xmin = bin_xmins[b];
+                    right_xmax = bin_xmaxs[b];
+                }
+                else
+                {
+                    right_xmin = min_union( right_xmin, bin_xmins[b] );
+                    right_xmax = max_union( right_xmax, bin_xmaxs[b] );
+                }
+                right_count += bin_counts[b];
+            }
+            right_costs[b] = ( right_count > 0 ) ? right_count * half_area( right_xmin, right_xmax ) : 0.0;
+        }
+
+        // then sweep from the left and pick the cheapest split
+
+        int best_split = -1;
+        double best_cost = 0.0;
+        size_t left_count = 0;
+        Vec3d left_xmin, left_xmax;
+
+        for ( int b = 0; b < NUM_SAH_BINS - 1; ++b )
+        {
+            if ( bin_counts[b] > 0 )
+            {
+                if ( left_count == 0 )
+                {
+                    left_xmin = bin_xmins[b];
+                    left_xmax = bin_xmaxs[b];
+                }
+                else
+                {
+                    left_xmin = min_union( left_xmin, bin_xmins[b] );
+                    left_xmax = max_union( left_xmax, bin_xmaxs[b] );
+                }
+                left_count += bin_counts[b];
+            }
+
+            if ( left_count == 0 || left_count == end - begin ) { continue; }
+
+            double cost = left_count * half_area( left_xmin, left_xmax ) + right_costs[b+1];
+            if ( best_split < 0 || cost < best_cost )
+            {
+                best_split = b + 1;
+                best_cost = cost;
+            }
+        }
+
+        if ( best_split > 0 )
+        {
+            std::vector<size_t>::iterator split_iter =
+                std::partition( elements.begin() + begin, elements.begin() + end,
+                                BelowSplit( m_elementxmins, m_elementxmaxs, axis, cmin[axis], bin_scale, best_split ) );
+            mid = split_iter - elements.begin();
+        }
+    }
+
+    assert( mid > begin && mid < end );
+
+    // m_nodes may be reallocated by the recursive calls, so don't hold references into it
+    int left = build_subtree( elements, begin, mid, n );
+    int right = build_subtree( elements, mid, end, n );
+
+    m_nodes[n].m_left = left;
+    m_nodes[n].m_right = right;
+
+    return n;
+}
+
+// --------------------------------------------------------
+///
+/// Recompute the bounds of node n and its ancestors from their children.  Stops early once a node's bounds don't change.
+///
+// --------------------------------------------------------
+
+void AABBTree::refit_ancestors( int n )
+{
+    while ( n >= 0 )
+    {
+        Node& node = m_nodes[n];
+        Vec3d new_xmin = min_union( m_nodes[node.m_left].m_xmin, m_nodes[node.m_right].m_xmin );
+        Vec3d new_xmax = max_union( m_nodes[node.m_left].m_xmax, m_nodes[node.m_right].m_xmax );
+
+        if ( new_xmin == node.m_xmin && new_xmax == node.m_xmax ) { return; }
+
+        node.m_xmin = new_xmin;
+        node.m_xmax = new_xmax;
+        n = node.m_parent;
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Add an object with the specified index and AABB to the tree.  The new leaf is paired with the node whose bounds grow
+/// the least (summed over its ancestors) by including it.
+///
+// --------------------------------------------------------
+
+void AABBTree::add_element( size_t idx, const Vec3d& xmin, const Vec3d& xmax )
+{
+    if ( m_elementleaf.size() <= idx )
+    {
+        m_elementxmins.resize( idx+1 );
+        m_elementxmaxs.resize( idx+1 );
+        m_elementleaf.resize( idx+1, -1 );
+    }
+
+    if ( m_elementleaf[idx] >= 0 )
+    {
+        remove_element( idx );
+    }
+
+    m_elementxmins[idx] = xmin;
+    m_elementxmaxs[idx] = xmax;
+
+    int leaf = allocate_node();
+    m_nodes[leaf].m_xmin = xmin;
+    m_nodes[leaf].m_xmax = xmax;
+    m_nodes[leaf].m_parent = -1;
+    m_nodes[leaf].m_left = m_nodes[leaf].m_right = -1;
+    m_nodes[leaf].m_element = idx;
+    m_elementleaf[idx] = leaf;
+
+    if ( m_root < 0 )
+    {
+        m_root = leaf;
+        return;
+    }
+
+    // descend to the best sibling
+
+    int sibling = m_root;
+
+    while ( m_nodes[sibling].m_left >= 0 )
+    {
+        const Node& node = m_nodes[sibling];
+
+        double area = half_area( node.m_xmin, node.m_xmax );
+        double combined_area = half_area( min_union( node.m_xmin, xmin ), max_union( node.m_xmax, xmax ) );
+
+        // cost of making a new parent for this node and the new leaf
+        double cost_here = 2.0 * combined_area;
+
+        // minimum cost of pushing the leaf further down
+        double inherited_cost = 2.0 * ( combined_area - area );
+
+        double child_costs[2];
+        int children[2] = { node.m_left, node.m_right };
+
+        for ( int c = 0; c < 2; ++c )
+        {
+            const Node& child = m_nodes[children[c]];
+            double child_combined_area = half_area( min_union( child.m_xmin, xmin ), max_union( child.m_xmax, xmax ) );
+            if ( child.m_left < 0 )
+            {
+                child_costs[c] = child_combined_area + inherited_cost;
+            }
+            else
+            {
+                child_costs[c] = child_combined_area - half_area( child.m_xmin, child.m_xmax ) + inherited_cost;
+            }
+        }
+
+        if ( cost_here < child_costs[0] && cost_here < child_costs[1] ) { break; }
+
+        sibling = ( child_costs[0] <= child_costs[1] ) ? children[0] : children[1];
+    }
+
+    // splice in a new parent
+
+    int old_parent = m_nodes[sibling].m_parent;
+    int new_parent = allocate_node();
+
+    m_nodes[new_parent].m_parent = old_parent;
+    m_nodes[new_parent].m_left = sibling;
+    m_nodes[new_parent].m_right = leaf;
+    m_nodes[new_parent].m_xmin = min_union( m_nodes[sibling].m_xmin, xmin );
+    m_nodes[new_parent].m_xmax = max_union( m_nodes[sibling].m_xmax, xmax );
+
+    m_nodes[sibling].m_parent = new_parent;
+    m_nodes[leaf].m_parent = new_parent;
+
+    if ( old_parent < 0 )
+    {
+        m_root = new_parent;
+    }
+    else
+    {
+        if ( m_nodes[old_parent].m_left == sibling )
+        {
+            m_nodes[old_parent].m_left = new_parent;
+        }
+        else
+        {
+            m_nodes[old_parent].m_right = new_parent;
+        }
+
+        refit_ancestors( old_parent );
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Remove an object with the specified index from the tree.  Its sibling takes the place of their shared parent.
+///
+// --------------------------------------------------------
+
+void AABBTree::remove_element( size_t idx )
+{
+    if ( idx >= m_elementleaf.size() || m_elementleaf[idx] < 0 ) { return; }
+
+    int leaf = m_elementleaf[idx];
+    m_elementleaf[idx] = -1;
+
+    if ( leaf == m_root )
+    {
+        m_root = -1;
+        free_node( leaf );
+        return;
+    }
+
+    int parent = m_nodes[leaf].m_parent;
+    int grandparent = m_nodes[parent].m_parent;
+    int sibling = ( m_nodes[parent].m_left == leaf ) ? m_nodes[parent].m_right : m_nodes[parent].m_left;
+
+    if ( grandparent < 0 )
+    {
+        m_root = sibling;
+        m_nodes[sibling].m_parent = -1;
+    }
+    else
+    {
+        if ( m_nodes[grandparent].m_left == parent )
+        {
+            m_nodes[grandparent].m_left = sibling;
+        }
+        else
+        {
+            m_nodes[grandparent].m_right = sibling;
+        }
+        m_nodes[sibling].m_parent = grandparent;
+
+        refit_ancestors( grandparent );
+    }
+
+    free_node( parent );
+    free_node( leaf );
+}
+
+// --------------------------------------------------------
+///
+/// Reset the specified object's AABB and refit its ancestors.  The tree topology is not changed, so query performance
+/// degrades if elements move far; the broad phase is rebuilt from scratch often enough that this doesn't matter.
+///
+// --------------------------------------------------------
+
+void AABBTree::update_element( size_t idx, const Vec3d& xmin, const Vec3d& xmax )
+{
+    if ( idx >= m_elementleaf.size() || m_elementleaf[idx] < 0 )
+    {
+        add_element( idx, xmin, xmax );
+        return;
+    }
+
+    m_elementxmins[idx] = xmin;
+    m_elementxmaxs[idx] = xmax;
+
+    int leaf = m_elementleaf[idx];
+    m_nodes[leaf].m_xmin = xmin;
+    m_nodes[leaf].m_xmax = xmax;
+
+    refit_ancestors( m_nodes[leaf].m_parent );
+}
+
+// --------------------------------------------------------
+///
+/// Remove all elements from the tree
+///
+// --------------------------------------------------------
+
+void AABBTree::clear()
+{
+    m_nodes.clear();
+    m_freenodes.clear();
+    m_root = -1;
+    m_elementleaf.clear();
+    m_elementxmins.clear();
+    m_elementxmaxs.clear();
+}
+
+// --------------------------------------------------------
+///
+/// Return the set of elements which have AABBs overlapping the query AABB.
+///
+// --------------------------------------------------------
+
+void AABBTree::find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const
+{
+    if ( m_root < 0 ) { return; }
+    query_subtree( m_root, xmin, xmax, results );
+}
+
+// --------------------------------------------------------
+///
+/// Recursive helper for find_overlapping_elements
+///
+// --------------------------------------------------------
+
+void AABBTree::query_subtree( int n, const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const
+{
+    const Node& node = m_nodes[n];
+
+    if ( !aabbs_overlap( xmin, xmax, node.m_xmin, node.m_xmax ) ) { return; }
+
+    if ( node.m_left < 0 )
+    {
+        results.push_back( node.m_element );
+        return;
+    }
+
+    query_subtree( node.m_left, xmin, xmax, results );
+    query_subtree( node.m_right, xmin, xmax, results );
+}
+
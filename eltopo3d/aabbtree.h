@@ -0,0 +1,106 @@
+// ---------------------------------------------------------
+//
+//  aabbtree.h
+//
+//  A bounding volume hierarchy collision test culling structure.
+//
+// ---------------------------------------------------------
+
+#ifndef EL_TOPO_AABBTREE_H
+#define EL_TOPO_AABBTREE_H
+
+// ---------------------------------------------------------
+// Nested includes
+// ---------------------------------------------------------
+
+#include "../common/vec.h"
+#include <vector>
+
+// ---------------------------------------------------------
+//  Forwards and typedefs
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+//  Class definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Binary tree of axis-aligned bounding boxes, one element per leaf.  Built top-down using the surface area heuristic,
+/// then maintained incrementally: updated elements are refit in place, added elements are inserted into the cheapest
+/// branch, removed elements are unlinked.  Unlike AccelerationGrid, queries do not modify the tree, so they can be run
+/// concurrently.
+///
+// --------------------------------------------------------
+
+class AABBTree
+{
+
+public:
+
+    AABBTree();
+
+    /// Build the tree from scratch over the given set of elements
+    ///
+    void build( const std::vector<Vec3d>& xmins, const std::vector<Vec3d>& xmaxs, const std::vector<size_t>& indices );
+
+    /// Add an object with the specified index and AABB to the tree
+    ///
+    void add_element( size_t idx, const Vec3d& xmin, const Vec3d& xmax );
+
+    /// Remove an object with the specified index from the tree
+    ///
+    void remove_element( size_t idx );
+
+    /// Reset the specified object's AABB and refit its ancestors
+    ///
+    void update_element( size_t idx, const Vec3d& xmin, const Vec3d& xmax );
+
+    /// Remove all elements from the tree
+    ///
+    void clear();
+
+    /// Return the set of elements which have AABBs overlapping the query AABB.
+    ///
+    void find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const;
+
+    /// Element AABBs
+    ///
+    std::vector<Vec3d> m_elementxmins, m_elementxmaxs;
+
+private:
+
+    struct Node
+    {
+        Vec3d m_xmin, m_xmax;
+        int m_parent;
+        int m_left, m_right;     // -1 for leaves
+        size_t m_element;        // only meaningful for leaves
+    };
+
+    int allocate_node();
+    void free_node( int n );
+
+    int build_subtree( std::vector<size_t>& elements, size_t begin, size_t end, int parent );
+
+    void refit_ancestors( int n );
+
+    void query_subtree( int n, const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const;
+
+    /// Tree nodes, and the slots in m_nodes which are currently unused
+    ///
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freenodes;
+
+    /// Index of the root node, or -1 if the tree is empty
+    ///
+    int m_root;
+
+    /// For each element, the index of the leaf containing it, or -1 if the element is not in the tree
+    ///
+    std::vector<int> m_elementleaf;
+
+};
+
+
+#endif
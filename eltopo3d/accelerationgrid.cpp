@@ -13,7 +13,7 @@
 
 #include "accelerationgrid.h"
 
-#include "../common/array3.h"
+#include <climits>
 #include <limits>
 #include "../common/util.h"
 #include "../common/vec.h"
@@ -28,6 +28,13 @@
 // Local constants, typedefs, macros
 // ---------------------------------------------------------
 
+/// Use the sparse flat cell layout when there are more than this many cells per cell entry
+static const size_t SPARSE_CELLS_PER_ENTRY = 8;
+
+/// Fold the overlay into the flat cell layout once the overlay and stale entries together outnumber both this and the 
+/// flat cell entries
+static const size_t MIN_ENTRIES_BEFORE_COMPACT = 4096;
+
 // ---------------------------------------------------------
 // Static function definitions
 // ---------------------------------------------------------
@@ -43,12 +50,18 @@
 // --------------------------------------------------------
 
 AccelerationGrid::AccelerationGrid() :
-   m_cells(0,0,0),
-   m_elementidxs(0),
+   m_dims(0,0,0),
+   m_cellstarts(0),
+   m_cellelements(0),
+   m_sparse(false),
+   m_sparsecells(),
+   m_sparsecellcoords(0),
+   m_overlaycells(),
+   m_numoverlayentries(0),
+   m_numstaleentries(0),
+   m_elementlocation(0),
    m_elementxmins(0),
    m_elementxmaxs(0),
-   m_elementquery(0),
-   m_lastquery(0),
    m_gridxmin(0,0,0),
    m_gridxmax(0,0,0),
    m_cellsize(0,0,0),
@@ -66,12 +79,18 @@ AccelerationGrid::AccelerationGrid() :
 // --------------------------------------------------------
 
 AccelerationGrid::AccelerationGrid(AccelerationGrid& other) :
-    m_cells(0,0,0),
-    m_elementidxs(0),
+    m_dims(0,0,0),
+    m_cellstarts(0),
+    m_cellelements(0),
+    m_sparse(false),
+    m_sparsecells(),
+    m_sparsecellcoords(0),
+    m_overlaycells(),
+    m_numoverlayentries(0),
+    m_numstaleentries(0),
+    m_elementlocation(0),
     m_elementxmins(0),
     m_elementxmaxs(0),
-    m_elementquery(0),
-    m_lastquery(0),
     m_gridxmin(0,0,0),
     m_gridxmax(0,0,0),
     m_cellsize(0,0,0),
@@ -85,46 +104,57 @@ AccelerationGrid::AccelerationGrid(AccelerationGrid& other) :
 
 // --------------------------------------------------------
 ///
-/// Deep copy.
+/// Deep copy.  The hash tables are rebuilt rather than copied.
 ///
 // --------------------------------------------------------
 
 AccelerationGrid& AccelerationGrid::operator=( const AccelerationGrid& other)
 {
-    m_cells.resize( other.m_cells.ni, other.m_cells.nj, other.m_cells.nk, 0 );
-    for ( size_t i = 0; i < m_cells.a.size(); ++i )
-    {
-        if (other.m_cells.a[i])
-        {
-            m_cells.a[i] = new std::vector<size_t>();
-            *(m_cells.a[i]) = *(other.m_cells.a[i]);
-        }
-    }
-    
-    m_elementidxs = other.m_elementidxs;
+    m_dims = other.m_dims;
+    m_cellstarts = other.m_cellstarts;
+    m_cellelements = other.m_cellelements;
+    m_sparse = other.m_sparse;
+    m_sparsecellcoords = other.m_sparsecellcoords;
+    m_numstaleentries = other.m_numstaleentries;
+    m_elementlocation = other.m_elementlocation;
     m_elementxmins = other.m_elementxmins;
     m_elementxmaxs = other.m_elementxmaxs;
-    m_elementquery = other.m_elementquery;
-    m_lastquery = other.m_lastquery;
     m_gridxmin = other.m_gridxmin;
     m_gridxmax = other.m_gridxmax;
     m_cellsize = other.m_cellsize;
     m_invcellsize = other.m_invcellsize;   
     
+    m_sparsecells.clear();
+    for ( size_t c = 0; c < m_sparsecellcoords.size(); ++c )
+    {
+        m_sparsecells.add( m_sparsecellcoords[c], c );
+    }
+    
+    m_overlaycells.clear();
+    m_numoverlayentries = 0;
+    for ( size_t idx = 0; idx < m_elementlocation.size(); ++idx )
+    {
+        if ( m_elementlocation[idx] != ELEMENT_IN_OVERLAY ) { continue; }
+        
+        Vec3i xmini, xmaxi;
+        boundstoindices( m_elementxmins[idx], m_elementxmaxs[idx], xmini, xmaxi );
+        
+        for(int i = xmini[0]; i <= xmaxi[0]; i++)
+        {
+            for(int j = xmini[1]; j <= xmaxi[1]; j++)
+            {
+                for(int k = xmini[2]; k <= xmaxi[2]; k++)
+                {
+                    m_overlaycells.add( Vec3i(i, j, k), idx );
+                    ++m_numoverlayentries;
+                }
+            }
+        }
+    }
+    
     return *this;
 }
 
-// --------------------------------------------------------
-///
-/// Destructor: clear all grids
-///
-// --------------------------------------------------------
-
-AccelerationGrid::~AccelerationGrid()
-{
-    clear();
-}
-
 // --------------------------------------------------------
 ///
 /// Define the grid, given the extents of the domain and the number of desired voxels along each dimension
@@ -144,11 +174,7 @@ void AccelerationGrid::set( const Vec3st& dims, const Vec3d& xmin, const Vec3d&
     
     clear();
     
-    m_cells.resize(dims[0], dims[1], dims[2]);    
-    for(size_t i = 0; i < m_cells.a.size(); i++)
-    {
-        m_cells.a[i] = 0;
-    }   
+    m_dims = dims;
 }
 
 // --------------------------------------------------------
@@ -157,7 +183,7 @@ void AccelerationGrid::set( const Vec3st& dims, const Vec3d& xmin, const Vec3d&
 ///
 // --------------------------------------------------------
 
-void AccelerationGrid::boundstoindices(const Vec3d& xmin, const Vec3d& xmax, Vec3i& xmini, Vec3i& xmaxi)
+void AccelerationGrid::boundstoindices(const Vec3d& xmin, const Vec3d& xmax, Vec3i& xmini, Vec3i& xmaxi) const
 {
     
     xmini[0] = (int) floor((xmin[0] - m_gridxmin[0]) * m_invcellsize[0]);
@@ -176,20 +202,203 @@ void AccelerationGrid::boundstoindices(const Vec3d& xmin, const Vec3d& xmax, Vec
     if(xmaxi[1] < 0) xmaxi[1] = 0;
     if(xmaxi[2] < 0) xmaxi[2] = 0;
     
-    assert( m_cells.ni < INT_MAX );
-    assert( m_cells.nj < INT_MAX );
-    assert( m_cells.nk < INT_MAX );
+    assert( m_dims[0] < INT_MAX );
+    assert( m_dims[1] < INT_MAX );
+    assert( m_dims[2] < INT_MAX );
     
-    if(xmaxi[0] >= (int)m_cells.ni) xmaxi[0] = (int)m_cells.ni-1;
-    if(xmaxi[1] >= (int)m_cells.nj) xmaxi[1] = (int)m_cells.nj-1;
-    if(xmaxi[2] >= (int)m_cells.nk) xmaxi[2] = (int)m_cells.nk-1;
+    if(xmaxi[0] >= (int)m_dims[0]) xmaxi[0] = (int)m_dims[0]-1;
+    if(xmaxi[1] >= (int)m_dims[1]) xmaxi[1] = (int)m_dims[1]-1;
+    if(xmaxi[2] >= (int)m_dims[2]) xmaxi[2] = (int)m_dims[2]-1;
     
-    if(xmini[0] >= (int)m_cells.ni) xmini[0] = (int)m_cells.ni-1;
-    if(xmini[1] >= (int)m_cells.nj) xmini[1] = (int)m_cells.nj-1;
-    if(xmini[2] >= (int)m_cells.nk) xmini[2] = (int)m_cells.nk-1;
+    if(xmini[0] >= (int)m_dims[0]) xmini[0] = (int)m_dims[0]-1;
+    if(xmini[1] >= (int)m_dims[1]) xmini[1] = (int)m_dims[1]-1;
+    if(xmini[2] >= (int)m_dims[2]) xmini[2] = (int)m_dims[2]-1;
     
 }
 
+// --------------------------------------------------------
+///
+/// Replace the grid contents with the given set of elements.
+///
+// --------------------------------------------------------
+
+void AccelerationGrid::build( const std::vector<Vec3d>& xmins, const std::vector<Vec3d>& xmaxs, const std::vector<size_t>& indices )
+{
+    assert( xmaxs.size() == xmins.size() );
+    assert( xmins.size() == indices.size() );
+    
+    clear();
+    
+    size_t num_elements = 0;
+    for ( size_t i = 0; i < indices.size(); ++i )
+    {
+        num_elements = std::max( num_elements, indices[i] + 1 );
+    }
+    
+    m_elementlocation.resize( num_elements, ELEMENT_NOT_PRESENT );
+    m_elementxmins.resize( num_elements );
+    m_elementxmaxs.resize( num_elements );
+    
+    // going backwards, so cells list their elements in the same order as when adding elements one at a time from the end
+    
+    std::vector<size_t> elements;
+    elements.reserve( indices.size() );
+    
+    for( ptrdiff_t i = (ptrdiff_t) indices.size() - 1; i >= 0; i-- )
+    {
+        // don't add inside-out AABBs
+        if ( xmins[i][0] > xmaxs[i][0] )  { continue; }
+        
+        m_elementxmins[indices[i]] = xmins[i];
+        m_elementxmaxs[indices[i]] = xmaxs[i];
+        elements.push_back( indices[i] );
+    }
+    
+    build_flat_cells( elements );
+}
+
+// --------------------------------------------------------
+///
+/// Rebuild the flat cell layout from the given elements.  First pass counts the entries per cell, second pass places 
+/// each element into its cells' ranges.
+///
+// --------------------------------------------------------
+
+void AccelerationGrid::build_flat_cells( const std::vector<size_t>& elements )
+{
+    std::vector<Vec3i> element_xmini( elements.size() ), element_xmaxi( elements.size() );
+    
+    size_t num_entries = 0;
+    for ( size_t e = 0; e < elements.size(); ++e )
+    {
+        boundstoindices( m_elementxmins[elements[e]], m_elementxmaxs[elements[e]], element_xmini[e], element_xmaxi[e] );
+        num_entries += (size_t) ( element_xmaxi[e][0] - element_xmini[e][0] + 1 ) 
+                     * (size_t) ( element_xmaxi[e][1] - element_xmini[e][1] + 1 ) 
+                     * (size_t) ( element_xmaxi[e][2] - element_xmini[e][2] + 1 );
+    }
+    
+    const size_t num_cells = m_dims[0] * m_dims[1] * m_dims[2];
+    
+    m_sparse = ( num_cells > SPARSE_CELLS_PER_ENTRY * num_entries );
+    m_sparsecells.clear();
+    m_sparsecellcoords.clear();
+    
+    // count
+    
+    if ( !m_sparse )
+    {
+        m_cellstarts.assign( num_cells + 1, 0 );
+        
+        for ( size_t e = 0; e < elements.size(); ++e )
+        {
+            for(int k = element_xmini[e][2]; k <= element_xmaxi[e][2]; k++)
+            {
+                for(int j = element_xmini[e][1]; j <= element_xmaxi[e][1]; j++)
+                {
+                    size_t row = m_dims[0] * ( j + m_dims[1] * k );
+                    for(int i = element_xmini[e][0]; i <= element_xmaxi[e][0]; i++)
+                    {
+                        ++m_cellstarts[row + i + 1];
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        m_sparsecells.reserve( (unsigned int) std::min( num_entries, (size_t) UINT_MAX / 2 ) );
+        m_cellstarts.assign( 1, 0 );
+        
+        for ( size_t e = 0; e < elements.size(); ++e )
+        {
+            for(int k = element_xmini[e][2]; k <= element_xmaxi[e][2]; k++)
+            {
+                for(int j = element_xmini[e][1]; j <= element_xmaxi[e][1]; j++)
+                {
+                    for(int i = element_xmini[e][0]; i <= element_xmaxi[e][0]; i++)
+                    {
+                        Vec3i cell(i, j, k);
+                        size_t c;
+                        if ( !m_sparsecells.get_entry( cell, c ) )
+                        {
+                            c = m_sparsecellcoords.size();
+                            m_sparsecells.add( cell, c );
+                            m_sparsecellcoords.push_back( cell );
+                            m_cellstarts.push_back( 0 );
+                        }
+                        ++m_cellstarts[c + 1];
+                    }
+                }
+            }
+        }
+    }
+    
+    for ( size_t c = 1; c < m_cellstarts.size(); ++c )
+    {
+        m_cellstarts[c] += m_cellstarts[c-1];
+    }
+    
+    // fill
+    
+    m_cellelements.resize( num_entries );
+    std::vector<size_t> cursors( m_cellstarts.begin(), m_cellstarts.end() - 1 );
+    
+    for ( size_t e = 0; e < elements.size(); ++e )
+    {
+        size_t idx = elements[e];
+        
+        for(int i = element_xmini[e][0]; i <= element_xmaxi[e][0]; i++)
+        {
+            for(int j = element_xmini[e][1]; j <= element_xmaxi[e][1]; j++)
+            {
+                for(int k = element_xmini[e][2]; k <= element_xmaxi[e][2]; k++)
+                {
+                    size_t c = 0;
+                    if ( !m_sparse )
+                    {
+                        c = i + m_dims[0] * ( j + m_dims[1] * k );
+                    }
+                    else
+                    {
+                        // the counting pass created every cell an element covers
+                        bool cell_exists = m_sparsecells.get_entry( Vec3i(i, j, k), c );
+                        assert( cell_exists );
+                        (void) cell_exists;
+                    }
+                    m_cellelements[ cursors[c]++ ] = idx;
+                }
+            }
+        }
+        
+        m_elementlocation[idx] = ELEMENT_IN_FLAT_CELLS;
+    }
+    
+    m_numstaleentries = 0;
+}
+
+// --------------------------------------------------------
+///
+/// Move all overlay elements into the flat cell layout, and drop stale entries
+///
+// --------------------------------------------------------
+
+void AccelerationGrid::compact()
+{
+    std::vector<size_t> elements;
+    for ( size_t idx = 0; idx < m_elementlocation.size(); ++idx )
+    {
+        if ( m_elementlocation[idx] != ELEMENT_NOT_PRESENT )
+        {
+            elements.push_back( idx );
+        }
+    }
+    
+    m_overlaycells.clear();
+    m_numoverlayentries = 0;
+    
+    build_flat_cells( elements );
+}
+
 // --------------------------------------------------------
 ///
 /// Add an object with the specified index and AABB to the grid
@@ -198,17 +407,21 @@ void AccelerationGrid::boundstoindices(const Vec3d& xmin, const Vec3d& xmax, Vec
 
 void AccelerationGrid::add_element(size_t idx, const Vec3d& xmin, const Vec3d& xmax)
 {
-    if(m_elementidxs.size() <= idx)
+    if(m_elementlocation.size() <= idx)
     {
-        m_elementidxs.resize(idx+1);
+        m_elementlocation.resize(idx+1, ELEMENT_NOT_PRESENT);
         m_elementxmins.resize(idx+1);
         m_elementxmaxs.resize(idx+1);
-        m_elementquery.resize(idx+1);
+    }
+    
+    if ( m_elementlocation[idx] != ELEMENT_NOT_PRESENT )
+    {
+        remove_element( idx );
     }
     
     m_elementxmins[idx] = xmin;
     m_elementxmaxs[idx] = xmax;
-    m_elementquery[idx] = 0;
+    m_elementlocation[idx] = ELEMENT_IN_OVERLAY;
     
     Vec3i xmini, xmaxi;
     boundstoindices(xmin, xmax, xmini, xmaxi);
@@ -219,53 +432,83 @@ void AccelerationGrid::add_element(size_t idx, const Vec3d& xmin, const Vec3d& x
         {
             for(int k = xmini[2]; k <= xmaxi[2]; k++)
             {
-                std::vector<size_t>*& cell = m_cells(i, j, k);
-                if(!cell)
-                    cell = new std::vector<size_t>();
-                
-                cell->push_back(idx);
-                m_elementidxs[idx].push_back(Vec3st(i, j, k));
+                m_overlaycells.add( Vec3i(i, j, k), idx );
+                ++m_numoverlayentries;
             }
         }
     }
+    
+    if ( m_numoverlayentries + m_numstaleentries > std::max( MIN_ENTRIES_BEFORE_COMPACT, m_cellelements.size() ) )
+    {
+        compact();
+    }
 }
 
 // --------------------------------------------------------
 ///
-/// Remove an object with the specified index from the grid
+/// Remove an object with the specified index from the grid.  Entries in the flat cell layout are left in place and 
+/// skipped by queries until the next compaction.
 ///
 // --------------------------------------------------------
 
 void AccelerationGrid::remove_element(size_t idx)
 {
     
-    if ( idx >= m_elementidxs.size() ) { return; }
+    if ( idx >= m_elementlocation.size() ) { return; }
     
-    for(size_t c = 0; c < m_elementidxs[idx].size(); c++)
+    if ( m_elementlocation[idx] == ELEMENT_NOT_PRESENT ) { return; }
+    
+    Vec3i xmini, xmaxi;
+    boundstoindices(m_elementxmins[idx], m_elementxmaxs[idx], xmini, xmaxi);
+    
+    if ( m_elementlocation[idx] == ELEMENT_IN_FLAT_CELLS )
     {
-        Vec3st cellcoords = m_elementidxs[idx][c];
-        std::vector<size_t>* cell = m_cells(cellcoords[0], cellcoords[1], cellcoords[2]);
-        
-        std::vector<size_t>::iterator it = cell->begin();
-        while(*it != idx)
+        m_numstaleentries += (size_t) ( xmaxi[0] - xmini[0] + 1 ) 
+                           * (size_t) ( xmaxi[1] - xmini[1] + 1 ) 
+                           * (size_t) ( xmaxi[2] - xmini[2] + 1 );
+    }
+    else
+    {
+        for(int i = xmini[0]; i <= xmaxi[0]; i++)
         {
-            it++;
+            for(int j = xmini[1]; j <= xmaxi[1]; j++)
+            {
+                for(int k = xmini[2]; k <= xmaxi[2]; k++)
+                {
+                    m_overlaycells.delete_entry( Vec3i(i, j, k), idx );
+                    --m_numoverlayentries;
+                }
+            }
         }
-        
-        cell->erase(it);
     }
     
-    m_elementidxs[idx].clear();
+    m_elementlocation[idx] = ELEMENT_NOT_PRESENT;
 }
 
 // --------------------------------------------------------
 ///
-/// Reset the specified object's AABB
+/// Reset the specified object's AABB.  Only re-bins the object if it moved into a different set of cells.
 ///
 // --------------------------------------------------------
 
 void AccelerationGrid::update_element(size_t idx, const Vec3d& xmin, const Vec3d& xmax)
 {
+    if ( idx < m_elementlocation.size() && m_elementlocation[idx] != ELEMENT_NOT_PRESENT )
+    {
+        // if the element still covers the same cells, there is nothing to re-bin
+        
+        Vec3i old_xmini, old_xmaxi, new_xmini, new_xmaxi;
+        boundstoindices( m_elementxmins[idx], m_elementxmaxs[idx], old_xmini, old_xmaxi );
+        boundstoindices( xmin, xmax, new_xmini, new_xmaxi );
+        
+        if ( old_xmini == new_xmini && old_xmaxi == new_xmaxi )
+        {
+            m_elementxmins[idx] = xmin;
+            m_elementxmaxs[idx] = xmax;
+            return;
+        }
+    }
+    
     remove_element(idx);
     add_element(idx, xmin, xmax);
 }
@@ -278,80 +521,122 @@ void AccelerationGrid::update_element(size_t idx, const Vec3d& xmin, const Vec3d
 
 void AccelerationGrid::clear()
 {
-    for(size_t i = 0; i < m_cells.a.size(); i++)
-    {
-        std::vector<size_t>*& cell = m_cells.a[i];  
-        if(cell)
-        {
-            delete cell;
-            cell = 0;
-        }
-    }
+    m_cellstarts.clear();
+    m_cellelements.clear();
+    m_sparse = false;
+    m_sparsecells.clear();
+    m_sparsecellcoords.clear();
+    m_overlaycells.clear();
+    m_numoverlayentries = 0;
+    m_numstaleentries = 0;
     
-    m_elementidxs.clear();
+    m_elementlocation.clear();
     m_elementxmins.clear();
     m_elementxmaxs.clear();
-    m_elementquery.clear();
-    m_lastquery = 0;
     
 }
 
 // --------------------------------------------------------
 ///
-/// Return the set of elements which have AABBs overlapping the query AABB.
+/// Get the range of m_cellelements for the given cell, returns false if the cell is empty
 ///
 // --------------------------------------------------------
 
-void AccelerationGrid::find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) 
+inline bool AccelerationGrid::get_flat_cell_range( int i, int j, int k, size_t& begin, size_t& end ) const
 {
-    if(m_lastquery == std::numeric_limits<unsigned int>::max())
+    if ( m_cellelements.empty() ) { return false; }
+    
+    size_t c;
+    if ( !m_sparse )
     {
-        std::vector<unsigned int>::iterator iter = m_elementquery.begin();
-        for( ; iter != m_elementquery.end(); ++iter )
-        {
-            *iter = 0;
-        }
-        m_lastquery = 0;
+        c = i + m_dims[0] * ( j + m_dims[1] * k );
+    }
+    else if ( !m_sparsecells.get_entry( Vec3i(i, j, k), c ) )
+    {
+        return false;
     }
     
-    ++m_lastquery;
+    begin = m_cellstarts[c];
+    end = m_cellstarts[c+1];
+    return begin < end;
+}
+
+// --------------------------------------------------------
+///
+/// Check a candidate element found in the given cell against the current query.  An element spanning several cells is 
+/// only reported from the first of its cells the query visits, which keeps queries free of any per-query bookkeeping.
+///
+// --------------------------------------------------------
+
+inline void AccelerationGrid::test_element( size_t oidx, const Vec3d& xmin, const Vec3d& xmax, const Vec3i& query_xmini, 
+                                            const Vec3i& cell, std::vector<size_t>& results ) const
+{
+    const Vec3d& oxmin = m_elementxmins[oidx];
+    const Vec3d& oxmax = m_elementxmaxs[oidx];
     
+    if( (xmin[0] <= oxmax[0] && xmin[1] <= oxmax[1] && xmin[2] <= oxmax[2]) &&
+       (xmax[0] >= oxmin[0] && xmax[1] >= oxmin[1] && xmax[2] >= oxmin[2]) )
+    {
+        // Cells are visited in lexicographic order, so the first cell shared by the query and the element is the 
+        // corner where both ranges start.
+        
+        Vec3i oxmini, oxmaxi;
+        boundstoindices( oxmin, oxmax, oxmini, oxmaxi );
+        
+        if ( cell[0] == std::max( query_xmini[0], oxmini[0] ) &&
+             cell[1] == std::max( query_xmini[1], oxmini[1] ) &&
+             cell[2] == std::max( query_xmini[2], oxmini[2] ) )
+        {
+            results.push_back(oidx);
+        }
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Return the set of elements which have AABBs overlapping the query AABB.  Queries don't modify the grid, so any number
+/// of them can run concurrently, as long as nothing is added, removed or updated meanwhile.
+///
+// --------------------------------------------------------
+
+void AccelerationGrid::find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const
+{
     Vec3i xmini, xmaxi;
     boundstoindices(xmin, xmax, xmini, xmaxi);
     
+    std::vector<size_t> overlay_entries;
+    
     for(int i = xmini[0]; i <= xmaxi[0]; ++i)
     {
         for(int j = xmini[1]; j <= xmaxi[1]; ++j)
         {
             for(int k = xmini[2]; k <= xmaxi[2]; ++k)
             {
-                std::vector<size_t>* cell = m_cells(i, j, k);
+                const Vec3i cell(i, j, k);
                 
-                if(cell)
+                size_t begin, end;
+                if ( get_flat_cell_range( i, j, k, begin, end ) )
                 {
-                    for( std::vector<size_t>::const_iterator citer = cell->begin(); citer != cell->end(); ++citer)
+                    for ( size_t c = begin; c < end; ++c )
                     {
-                        size_t oidx = *citer;
+                        size_t oidx = m_cellelements[c];
                         
-                        // Check if the object has already been found during this query
+                        // skip entries left behind by removed or moved elements
+                        if ( m_elementlocation[oidx] != ELEMENT_IN_FLAT_CELLS ) { continue; }
                         
-                        if(m_elementquery[oidx] < m_lastquery)
-                        {
-                            
-                            // Object has not been found.  Set m_elementquery so that it will not be tested again during this query.
-                            
-                            m_elementquery[oidx] = m_lastquery;
-                            
-                            const Vec3d& oxmin = m_elementxmins[oidx];
-                            const Vec3d& oxmax = m_elementxmaxs[oidx];
-                            
-                            if( (xmin[0] <= oxmax[0] && xmin[1] <= oxmax[1] && xmin[2] <= oxmax[2]) &&
-                               (xmax[0] >= oxmin[0] && xmax[1] >= oxmin[1] && xmax[2] >= oxmin[2]) )
-                            {
-                                results.push_back(oidx);
-                            }
-                            
-                        }
+                        test_element( oidx, xmin, xmax, xmini, cell, results );
+                    }
+                }
+                
+                if ( m_numoverlayentries > 0 )
+                {
+                    overlay_entries.clear();
+                    m_overlaycells.append_all_entries( cell, overlay_entries );
+                    
+                    // the hash table returns the most recently added entries first
+                    for ( size_t c = overlay_entries.size(); c > 0; --c )
+                    {
+                        test_element( overlay_entries[c-1], xmin, xmax, xmini, cell, results );
                     }
                 }
                 
@@ -359,6 +644,3 @@ void AccelerationGrid::find_overlapping_elements( const Vec3d& xmin, const Vec3d
         }
     }
 }
-
-
-
@@ -5,6 +5,11 @@
 //  
 //  A grid-based collision test culling structure.
 //
+//  Elements added in bulk through build() are stored in a flat, compressed-row cell layout (an offset per cell into one 
+//  array of element indices), built with a two-pass counting sort.  When the grid has many more cells than cell entries,
+//  only occupied cells are stored, found through a hash table.  Elements added or moved individually afterwards go into a 
+//  hashed overlay; they are folded back into the flat layout once the overlay grows large.
+//
 // ---------------------------------------------------------
 
 #ifndef EL_TOPO_ACCELERATIONGRID_H
@@ -14,8 +19,9 @@
 // Nested includes
 // ---------------------------------------------------------
 
-#include "../common/array3.h"
+#include "../common/hashtable.h"
 #include "../common/vec.h"
+#include <vector>
 
 // ---------------------------------------------------------
 //  Forwards and typedefs
@@ -37,7 +43,6 @@ class AccelerationGrid
 public:
     
     AccelerationGrid();
-    ~AccelerationGrid();
     
     // deep copy
     AccelerationGrid(AccelerationGrid& other);
@@ -51,7 +56,11 @@ public:
     
     /// Generate a set of voxel indices from a pair of AABB extents
     ///
-    void boundstoindices( const Vec3d& xmin, const Vec3d& xmax, Vec3i& xmini, Vec3i& xmaxi);
+    void boundstoindices( const Vec3d& xmin, const Vec3d& xmax, Vec3i& xmini, Vec3i& xmaxi) const;
+    
+    /// Replace the grid contents with the given set of elements.  Much faster than adding the elements one at a time.
+    ///
+    void build( const std::vector<Vec3d>& xmins, const std::vector<Vec3d>& xmaxs, const std::vector<size_t>& indices );
     
     /// Add an object with the specified index and AABB to the grid
     ///
@@ -69,30 +78,75 @@ public:
     ///
     void clear();
     
-    /// Return the set of elements which have AABBs overlapping the query AABB.
+    /// Return the set of elements which have AABBs overlapping the query AABB.  Safe to call from several threads at once.
     ///
-    void find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results );
+    void find_overlapping_elements( const Vec3d& xmin, const Vec3d& xmax, std::vector<size_t>& results ) const;
     
+private:
     
-    /// Each cell contains an array of indices specifying the elements whose AABBs overlap the cell
+    /// Where an element's cell entries are stored
     ///
-    Array3<std::vector<size_t>* > m_cells;
+    enum ElementLocation
+    {
+        ELEMENT_NOT_PRESENT = 0,
+        ELEMENT_IN_FLAT_CELLS,
+        ELEMENT_IN_OVERLAY
+    };
+    
+    /// Rebuild the flat cell layout from the given elements, whose AABBs are already in m_elementxmins/m_elementxmaxs
+    ///
+    void build_flat_cells( const std::vector<size_t>& elements );
     
-    /// For each element, a list of triples, each triple specifying a cell which overlaps the element. 
+    /// Move all overlay elements into the flat cell layout
     ///
-    std::vector<std::vector<Vec3st> > m_elementidxs;
+    void compact();
     
-    /// Element AABBs
+    /// Get the range of m_cellelements for the given cell, returns false if the cell is empty
     ///
-    std::vector<Vec3d> m_elementxmins, m_elementxmaxs;
+    inline bool get_flat_cell_range( int i, int j, int k, size_t& begin, size_t& end ) const;
+    
+    /// Check a candidate element found in the given cell against the current query
+    ///
+    inline void test_element( size_t oidx, const Vec3d& xmin, const Vec3d& xmax, const Vec3i& query_xmini, 
+                              const Vec3i& cell, std::vector<size_t>& results ) const;
+    
+public:
+    
+    /// Number of cells along each dimension
+    ///
+    Vec3st m_dims;
     
-    /// For each element, the timestamp of the last query that examined the element
+    /// Flat cell layout: entries m_cellstarts[c] to m_cellstarts[c+1] of m_cellelements are the elements overlapping 
+    /// cell c.  In dense mode, c is the linear cell index; in sparse mode, c comes from m_sparsecells.
     ///
-    std::vector<unsigned int> m_elementquery;
+    std::vector<size_t> m_cellstarts;
+    std::vector<size_t> m_cellelements;
     
-    /// Timestamp of the last query
+    /// Whether the flat cell layout stores every cell, or only occupied cells
     ///
-    unsigned int m_lastquery;
+    bool m_sparse;
+    
+    /// In sparse mode, maps cell coordinates to an index into m_cellstarts, and the reverse
+    ///
+    HashTable<Vec3i, size_t> m_sparsecells;
+    std::vector<Vec3i> m_sparsecellcoords;
+    
+    /// Cell entries for elements added or updated since the flat cell layout was built
+    ///
+    HashTable<Vec3i, size_t> m_overlaycells;
+    size_t m_numoverlayentries;
+    
+    /// Number of entries in m_cellelements which belong to removed or moved elements
+    ///
+    size_t m_numstaleentries;
+    
+    /// For each element, whether it is in the grid and where (an ElementLocation)
+    ///
+    std::vector<unsigned char> m_elementlocation;
+    
+    /// Element AABBs
+    ///
+    std::vector<Vec3d> m_elementxmins, m_elementxmaxs;
     
     /// Lower/upper corners of the entire grid
     ///
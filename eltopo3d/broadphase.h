@@ -4,8 +4,8 @@
 //  Tyson Brochu 2008
 //  
 //  Interface for abstract broad phase collision detector class.  The main function of a broad phase is to avoid performing 
-//  collision detection between all primitives. Abstract so we can try different strategies, however only BroadPhaseGrid is 
-//  currently implemented.
+//  collision detection between all primitives. Abstract so we can try different strategies: BroadPhaseGrid (uniform grids) 
+//  and BroadPhaseBVH (bounding volume hierarchies) are currently implemented.
 //
 // ---------------------------------------------------------
 
@@ -24,13 +24,21 @@
 
 class DynamicSurface;
 
+/// Available broad phase implementations
+enum BroadPhaseType
+{
+    BROAD_PHASE_GRID,
+    BROAD_PHASE_BVH
+};
+
 // ---------------------------------------------------------
 //  Class definitions
 // ---------------------------------------------------------
 
 // --------------------------------------------------------
 ///
-/// Abstract broad phase collision detector
+/// Abstract broad phase collision detector.  Implementations must allow the get_potential_*_collisions queries to be 
+/// called from several threads at once; adding, removing or updating elements may not overlap with anything else.
 ///
 // --------------------------------------------------------
 
@@ -45,6 +53,16 @@ public:
     ///
     virtual void update_broad_phase( const DynamicSurface& surface, bool continuous ) = 0;
     
+    /// Bring the broad phase up to date after the given vertices have moved.  Implementations may update only the 
+    /// elements incident to those vertices; by default the broad phase is rebuilt from scratch.
+    ///
+    virtual void update_broad_phase_incremental( const DynamicSurface& surface, 
+                                                bool continuous, 
+                                                const std::vector<size_t>& /*moved_vertices*/ )
+    {
+        update_broad_phase( surface, continuous );
+    }
+    
     
     virtual void add_vertex( size_t index,
                             const Vec3d& aabb_low,
@@ -0,0 +1,177 @@
+// ---------------------------------------------------------
+//
+//  broadphasebvh.cpp
+//  
+//  Broad phase collision detection culling using bounding volume hierarchies.
+//
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Includes
+// ---------------------------------------------------------
+
+#include "broadphasebvh.h"
+#include "dynamicsurface.h"
+
+// ---------------------------------------------------------
+// Global externs
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Local constants, typedefs, macros
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Static function definitions
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Member function definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Rebuild the trees according to the given triangle mesh
+///
+// --------------------------------------------------------
+
+void BroadPhaseBVH::update_broad_phase( const DynamicSurface& surface, bool continuous )
+{
+    
+    // ---------------
+    // vertices
+    // ---------------
+    
+    {
+        size_t num_vertices = surface.get_num_vertices();
+        
+        std::vector<Vec3d> solid_vertex_xmins, solid_vertex_xmaxs;
+        std::vector<size_t> solid_vertex_indices;
+        std::vector<Vec3d> dynamic_vertex_xmins, dynamic_vertex_xmaxs;
+        std::vector<size_t> dynamic_vertex_indices;
+        
+        for(size_t i = 0; i < num_vertices; i++)
+        {
+            Vec3d xmin, xmax;
+            
+            if ( continuous )
+            {
+                surface.vertex_continuous_bounds( i, xmin, xmax );
+            }
+            else
+            {
+                surface.vertex_static_bounds( i, xmin, xmax );
+            }
+            
+            if ( surface.vertex_is_solid( i ) )
+            {
+                solid_vertex_xmins.push_back( xmin );
+                solid_vertex_xmaxs.push_back( xmax );
+                solid_vertex_indices.push_back( i );
+            }
+            else
+            {
+                dynamic_vertex_xmins.push_back( xmin );
+                dynamic_vertex_xmaxs.push_back( xmax );
+                dynamic_vertex_indices.push_back( i );
+            }
+        }
+        
+        m_solid_vertex_tree.build( solid_vertex_xmins, solid_vertex_xmaxs, solid_vertex_indices );
+        m_dynamic_vertex_tree.build( dynamic_vertex_xmins, dynamic_vertex_xmaxs, dynamic_vertex_indices );
+        
+    }
+    
+    // ---------------
+    // edges
+    // ---------------
+    
+    {
+        size_t num_edges = surface.m_mesh.m_edges.size();
+        
+        std::vector<Vec3d> solid_edge_xmins, solid_edge_xmaxs;
+        std::vector<size_t> solid_edge_indices;
+        std::vector<Vec3d> dynamic_edge_xmins, dynamic_edge_xmaxs;
+        std::vector<size_t> dynamic_edge_indices;
+        
+        for(size_t i = 0; i < num_edges; i++)
+        {
+            Vec3d xmin, xmax;
+            
+            if ( continuous )
+            {
+                surface.edge_continuous_bounds( i, xmin, xmax );
+            }
+            else
+            {
+                surface.edge_static_bounds( i, xmin, xmax );
+            }
+            
+            // if either vertex is solid, it has to go into the solid broad phase
+            if ( surface.edge_is_solid(i) )
+            {
+                solid_edge_xmins.push_back( xmin );
+                solid_edge_xmaxs.push_back( xmax );
+                solid_edge_indices.push_back( i );
+            }
+            else
+            {
+                dynamic_edge_xmins.push_back( xmin );
+                dynamic_edge_xmaxs.push_back( xmax );
+                dynamic_edge_indices.push_back( i );
+            }
+        }      
+        
+        m_solid_edge_tree.build( solid_edge_xmins, solid_edge_xmaxs, solid_edge_indices );
+        m_dynamic_edge_tree.build( dynamic_edge_xmins, dynamic_edge_xmaxs, dynamic_edge_indices );
+        
+    }
+    
+    // ---------------
+    // triangles
+    // ---------------
+    
+    {
+        size_t num_triangles = surface.m_mesh.num_triangles();
+        
+        std::vector<Vec3d> solid_tri_xmins, solid_tri_xmaxs;
+        std::vector<size_t> solid_tri_indices;
+        std::vector<Vec3d> dynamic_tri_xmins, dynamic_tri_xmaxs;
+        std::vector<size_t> dynamic_tri_indices;
+        
+        for(size_t i = 0; i < num_triangles; i++)
+        {
+            Vec3d xmin, xmax;
+            
+            if ( continuous )
+            {
+                surface.triangle_continuous_bounds(i, xmin, xmax);
+            }
+            else
+            {
+                surface.triangle_static_bounds(i, xmin, xmax);
+            }
+            
+            if ( surface.triangle_is_solid( i ) )
+            {
+                solid_tri_xmins.push_back( xmin );
+                solid_tri_xmaxs.push_back( xmax );
+                solid_tri_indices.push_back( i );
+            }
+            else
+            {
+                dynamic_tri_xmins.push_back( xmin );
+                dynamic_tri_xmaxs.push_back( xmax );
+                dynamic_tri_indices.push_back( i );
+            }
+        }
+        
+        m_solid_triangle_tree.build( solid_tri_xmins, solid_tri_xmaxs, solid_tri_indices );
+        m_dynamic_triangle_tree.build( dynamic_tri_xmins, dynamic_tri_xmaxs, dynamic_tri_indices );
+        
+    }
+    
+}
+
+
+
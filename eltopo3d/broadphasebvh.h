@@ -0,0 +1,384 @@
+// ---------------------------------------------------------
+//
+//  broadphasebvh.h
+//  
+//  Broad phase collision detection culling using bounding volume hierarchies.
+//
+// ---------------------------------------------------------
+
+#ifndef EL_TOPO_BROADPHASEBVH_H
+#define EL_TOPO_BROADPHASEBVH_H
+
+// ---------------------------------------------------------
+// Nested includes
+// ---------------------------------------------------------
+
+#include "broadphase.h"
+#include "aabbtree.h"
+
+// ---------------------------------------------------------
+//  Forwards and typedefs
+// ---------------------------------------------------------
+
+class DynamicSurface;
+
+// ---------------------------------------------------------
+//  Class definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Broad phase collision detector using AABB trees: one tree each for vertices, edges and triangles.  Adapts to meshes 
+/// with widely varying element sizes and to sparse scenes, where a single grid cell size fits poorly.
+///
+// --------------------------------------------------------
+
+class BroadPhaseBVH : public BroadPhase
+{
+public:
+    
+    BroadPhaseBVH() :
+        m_solid_vertex_tree(),
+        m_solid_edge_tree(),
+        m_solid_triangle_tree(),
+        m_dynamic_vertex_tree(),
+        m_dynamic_edge_tree(),
+        m_dynamic_triangle_tree()
+    {}
+    
+    ~BroadPhaseBVH() 
+    {}
+    
+    /// Rebuild the broad phase
+    ///
+    void update_broad_phase( const DynamicSurface& surface, bool continuous );
+    
+    inline void add_vertex( size_t index,
+                           const Vec3d& aabb_low,
+                           const Vec3d& aabb_high,
+                           bool is_solid );
+    
+    inline void add_edge( size_t index,
+                         const Vec3d& aabb_low,
+                         const Vec3d& aabb_high,
+                         bool is_solid );
+    
+    inline void add_triangle( size_t index,
+                             const Vec3d& aabb_low,
+                             const Vec3d& aabb_high,
+                             bool is_solid );
+    
+    inline void update_vertex( size_t index,
+                              const Vec3d& aabb_low,
+                              const Vec3d& aabb_high,
+                              bool is_solid );
+    
+    inline void update_edge( size_t index,
+                            const Vec3d& aabb_low,
+                            const Vec3d& aabb_high,
+                            bool is_solid );
+    
+    inline void update_triangle( size_t index,
+                                const Vec3d& aabb_low,
+                                const Vec3d& aabb_high,
+                                bool is_solid );
+    
+    inline void remove_vertex( size_t index );
+    inline void remove_edge( size_t index );
+    inline void remove_triangle( size_t index ); 
+    
+    virtual void get_vertex_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high );
+    virtual void get_edge_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high );
+    virtual void get_triangle_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high );
+    
+    /// Get the set of vertices whose bounding volumes overlap the specified bounding volume
+    ///
+    inline void get_potential_vertex_collisions( const Vec3d& aabb_low, 
+                                                const Vec3d& aabb_high,
+                                                bool return_solid,
+                                                bool return_dynamic,
+                                                std::vector<size_t>& overlapping_vertices );
+    
+    /// Get the set of edges whose bounding volumes overlap the specified bounding volume
+    ///
+    inline void get_potential_edge_collisions( const Vec3d& aabb_low, 
+                                              const Vec3d& aabb_high, 
+                                              bool return_solid,
+                                              bool return_dynamic,
+                                              std::vector<size_t>& overlapping_edges );
+    
+    /// Get the set of triangles whose bounding volumes overlap the specified bounding volume
+    ///
+    inline void get_potential_triangle_collisions( const Vec3d& aabb_low, 
+                                                  const Vec3d& aabb_high,
+                                                  bool return_solid,
+                                                  bool return_dynamic,
+                                                  std::vector<size_t>& overlapping_triangles );
+    
+    /// Bounding volume hierarchies
+    ///
+    AABBTree m_solid_vertex_tree;
+    AABBTree m_solid_edge_tree;
+    AABBTree m_solid_triangle_tree;
+    
+    AABBTree m_dynamic_vertex_tree;
+    AABBTree m_dynamic_edge_tree;
+    AABBTree m_dynamic_triangle_tree;
+    
+};
+
+// ---------------------------------------------------------
+//  Inline functions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Add a vertex to the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::add_vertex( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_vertex_tree.add_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_vertex_tree.add_element( index, aabb_low, aabb_high );
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Add an edge to the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::add_edge( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_edge_tree.add_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_edge_tree.add_element( index, aabb_low, aabb_high );
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Add a triangle to the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::add_triangle( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_triangle_tree.add_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_triangle_tree.add_element( index, aabb_low, aabb_high );
+    }
+}
+
+
+inline void BroadPhaseBVH::update_vertex( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_vertex_tree.update_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_vertex_tree.update_element( index, aabb_low, aabb_high );
+    }
+}
+
+inline void BroadPhaseBVH::update_edge( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_edge_tree.update_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_edge_tree.update_element( index, aabb_low, aabb_high );
+    }
+}
+
+inline void BroadPhaseBVH::update_triangle( size_t index, const Vec3d& aabb_low, const Vec3d& aabb_high, bool is_solid )
+{
+    if ( is_solid )
+    {
+        m_solid_triangle_tree.update_element( index, aabb_low, aabb_high );
+    }
+    else
+    {
+        m_dynamic_triangle_tree.update_element( index, aabb_low, aabb_high );
+    }
+}
+
+
+// --------------------------------------------------------
+///
+/// Remove a vertex from the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::remove_vertex( size_t index )
+{
+    m_solid_vertex_tree.remove_element( index );
+    m_dynamic_vertex_tree.remove_element( index );
+}
+
+// --------------------------------------------------------
+///
+/// Remove an edge from the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::remove_edge( size_t index )
+{
+    m_solid_edge_tree.remove_element( index );
+    m_dynamic_edge_tree.remove_element( index );
+}
+
+// --------------------------------------------------------
+///
+/// Remove a triangle from the broad phase
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::remove_triangle( size_t index )
+{
+    m_solid_triangle_tree.remove_element( index );
+    m_dynamic_triangle_tree.remove_element( index );
+}
+
+// --------------------------------------------------------
+///
+/// Query the broad phase to get the set of all vertices overlapping the given AABB
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_potential_vertex_collisions( const Vec3d& aabb_low,
+                                                            const Vec3d& aabb_high,
+                                                            bool return_solid,
+                                                            bool return_dynamic,
+                                                            std::vector<size_t>& overlapping_vertices )
+{
+    if ( return_solid )
+    {
+        m_solid_vertex_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_vertices );
+    }
+    
+    if ( return_dynamic )
+    {
+        m_dynamic_vertex_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_vertices );
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Query the broad phase to get the set of all edges overlapping the given AABB
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_potential_edge_collisions( const Vec3d& aabb_low,
+                                                          const Vec3d& aabb_high,
+                                                          bool return_solid,
+                                                          bool return_dynamic,
+                                                          std::vector<size_t>& overlapping_edges )
+{
+    if ( return_solid )
+    {
+        m_solid_edge_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_edges );
+    }
+    
+    if ( return_dynamic )
+    {
+        m_dynamic_edge_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_edges );
+    }
+}
+
+// --------------------------------------------------------
+///
+/// Query the broad phase to get the set of all triangles overlapping the given AABB
+///
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_potential_triangle_collisions( const Vec3d& aabb_low,
+                                                              const Vec3d& aabb_high,
+                                                              bool return_solid,
+                                                              bool return_dynamic,
+                                                              std::vector<size_t>& overlapping_triangles )
+{
+    if ( return_solid )
+    {
+        m_solid_triangle_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_triangles );
+    }
+    
+    if ( return_dynamic )
+    {
+        m_dynamic_triangle_tree.find_overlapping_elements( aabb_low, aabb_high, overlapping_triangles );
+    }
+}
+
+
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_vertex_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high )
+{
+    if ( is_solid )
+    {
+        aabb_low = m_solid_vertex_tree.m_elementxmins[index];
+        aabb_high = m_solid_vertex_tree.m_elementxmaxs[index];
+    }
+    else
+    {
+        aabb_low = m_dynamic_vertex_tree.m_elementxmins[index];
+        aabb_high = m_dynamic_vertex_tree.m_elementxmaxs[index];      
+    }
+}
+
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_edge_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high )
+{
+    if ( is_solid )
+    {
+        aabb_low = m_solid_edge_tree.m_elementxmins[index];
+        aabb_high = m_solid_edge_tree.m_elementxmaxs[index];
+    }
+    else
+    {
+        aabb_low = m_dynamic_edge_tree.m_elementxmins[index];
+        aabb_high = m_dynamic_edge_tree.m_elementxmaxs[index];      
+    }
+}
+
+// --------------------------------------------------------
+
+inline void BroadPhaseBVH::get_triangle_aabb( size_t index, bool is_solid, Vec3d& aabb_low, Vec3d& aabb_high )
+{
+    if ( is_solid )
+    {
+        aabb_low = m_solid_triangle_tree.m_elementxmins[index];
+        aabb_high = m_solid_triangle_tree.m_elementxmaxs[index];
+    }
+    else
+    {
+        aabb_low = m_dynamic_triangle_tree.m_elementxmins[index];
+        aabb_high = m_dynamic_triangle_tree.m_elementxmaxs[index];      
+    }   
+}
+
+
+#endif
+
+
+
@@ -12,6 +12,8 @@
 // ---------------------------------------------------------
 
 #include "broadphasegrid.h"
+
+#include <algorithm>
 #include "dynamicsurface.h"
 
 // ---------------------------------------------------------
@@ -22,10 +24,28 @@
 // Local constants, typedefs, macros
 // ---------------------------------------------------------
 
+/// Incremental updates are only done while the average edge length stays within this factor of the grid cell size
+static const double MAX_LENGTH_SCALE_DRIFT = 2.0;
+
 // ---------------------------------------------------------
 // Static function definitions
 // ---------------------------------------------------------
 
+// --------------------------------------------------------
+///
+/// Whether the given AABB lies entirely inside the grid's domain
+///
+// --------------------------------------------------------
+
+static bool aabb_inside_grid( const AccelerationGrid& grid, const Vec3d& low, const Vec3d& high )
+{
+    for ( unsigned int i = 0; i < 3; ++i )
+    {
+        if ( low[i] < grid.m_gridxmin[i] || high[i] > grid.m_gridxmax[i] ) { return false; }
+    }
+    return true;
+}
+
 // ---------------------------------------------------------
 // Member function definitions
 // ---------------------------------------------------------
@@ -99,14 +119,7 @@ void BroadPhaseGrid::build_acceleration_grid( AccelerationGrid& grid,
     
     grid.set(dims, xmin, xmax);
     
-    // going backwards from n to 0, so hopefully the grid only has to allocate once
-    
-    for( ptrdiff_t i = n-1; i >= 0; i-- )
-    {
-        // don't add inside-out AABBs
-        if ( xmins[i][0] > xmaxs[i][0] )  { continue; }
-        grid.add_element( indices[i], xmins[i], xmaxs[i]);
-    }
+    grid.build( xmins, xmaxs, indices );
 }
 
 
@@ -121,6 +134,10 @@ void BroadPhaseGrid::update_broad_phase( const DynamicSurface& surface, bool con
     
     double grid_scale = surface.get_average_edge_length();
     
+    m_is_built = true;
+    m_built_continuous = continuous;
+    m_built_length_scale = grid_scale;
+    
     // ---------------
     // vertices
     // ---------------
@@ -290,4 +307,121 @@ void BroadPhaseGrid::update_broad_phase( const DynamicSurface& surface, bool con
 }
 
 
+// --------------------------------------------------------
+///
+/// Update the vertices in moved_vertices and their incident edges and triangles.  Elements which stay within the same 
+/// cells only have their AABBs updated; others are re-binned.  Falls back to a full rebuild if the grids were built 
+/// with the other kind of bounds, if the average edge length has drifted too far from the cell size, or if any updated 
+/// AABB leaves its grid's domain.
+///
+// --------------------------------------------------------
 
+void BroadPhaseGrid::update_broad_phase_incremental( const DynamicSurface& surface, 
+                                                     bool continuous, 
+                                                     const std::vector<size_t>& moved_vertices )
+{
+    if ( !m_is_built || continuous != m_built_continuous )
+    {
+        update_broad_phase( surface, continuous );
+        return;
+    }
+    
+    double length_scale = surface.get_average_edge_length();
+    if ( length_scale > MAX_LENGTH_SCALE_DRIFT * m_built_length_scale || 
+         length_scale * MAX_LENGTH_SCALE_DRIFT < m_built_length_scale )
+    {
+        update_broad_phase( surface, continuous );
+        return;
+    }
+    
+    const NonDestructiveTriMesh& mesh = surface.m_mesh;
+    
+    // gather affected elements
+    
+    std::vector<size_t> vertices( moved_vertices ), edges, triangles;
+    
+    for ( size_t i = 0; i < moved_vertices.size(); ++i )
+    {
+        size_t v = moved_vertices[i];
+        if ( v >= mesh.m_vertex_to_edge_map.size() ) { continue; }
+        edges.insert( edges.end(), mesh.m_vertex_to_edge_map[v].begin(), mesh.m_vertex_to_edge_map[v].end() );
+        triangles.insert( triangles.end(), mesh.m_vertex_to_triangle_map[v].begin(), mesh.m_vertex_to_triangle_map[v].end() );
+    }
+    
+    std::sort( vertices.begin(), vertices.end() );
+    vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+    std::sort( edges.begin(), edges.end() );
+    edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+    std::sort( triangles.begin(), triangles.end() );
+    triangles.erase( std::unique( triangles.begin(), triangles.end() ), triangles.end() );
+    
+    // compute new bounds, and make sure they still fit in the grids before changing anything
+    
+    std::vector<Vec3d> vertex_lows( vertices.size() ), vertex_highs( vertices.size() );
+    std::vector<Vec3d> edge_lows( edges.size() ), edge_highs( edges.size() );
+    std::vector<Vec3d> triangle_lows( triangles.size() ), triangle_highs( triangles.size() );
+    
+    for ( size_t i = 0; i < vertices.size(); ++i )
+    {
+        if ( continuous ) { surface.vertex_continuous_bounds( vertices[i], vertex_lows[i], vertex_highs[i] ); }
+        else { surface.vertex_static_bounds( vertices[i], vertex_lows[i], vertex_highs[i] ); }
+        
+        // skip inside-out AABBs of isolated vertices
+        if ( vertex_lows[i][0] > vertex_highs[i][0] ) { continue; }
+        
+        const AccelerationGrid& grid = surface.vertex_is_solid( vertices[i] ) ? m_solid_vertex_grid : m_dynamic_vertex_grid;
+        if ( !aabb_inside_grid( grid, vertex_lows[i], vertex_highs[i] ) )
+        {
+            update_broad_phase( surface, continuous );
+            return;
+        }
+    }
+    
+    for ( size_t i = 0; i < edges.size(); ++i )
+    {
+        if ( continuous ) { surface.edge_continuous_bounds( edges[i], edge_lows[i], edge_highs[i] ); }
+        else { surface.edge_static_bounds( edges[i], edge_lows[i], edge_highs[i] ); }
+        
+        const AccelerationGrid& grid = surface.edge_is_solid( edges[i] ) ? m_solid_edge_grid : m_dynamic_edge_grid;
+        if ( !aabb_inside_grid( grid, edge_lows[i], edge_highs[i] ) )
+        {
+            update_broad_phase( surface, continuous );
+            return;
+        }
+    }
+    
+    for ( size_t i = 0; i < triangles.size(); ++i )
+    {
+        if ( continuous ) { surface.triangle_continuous_bounds( triangles[i], triangle_lows[i], triangle_highs[i] ); }
+        else { surface.triangle_static_bounds( triangles[i], triangle_lows[i], triangle_highs[i] ); }
+        
+        const AccelerationGrid& grid = surface.triangle_is_solid( triangles[i] ) ? m_solid_triangle_grid : m_dynamic_triangle_grid;
+        if ( !aabb_inside_grid( grid, triangle_lows[i], triangle_highs[i] ) )
+        {
+            update_broad_phase( surface, continuous );
+            return;
+        }
+    }
+    
+    // apply
+    
+    for ( size_t i = 0; i < vertices.size(); ++i )
+    {
+        if ( vertex_lows[i][0] > vertex_highs[i][0] ) 
+        { 
+            remove_vertex( vertices[i] );
+            continue; 
+        }
+        update_vertex( vertices[i], vertex_lows[i], vertex_highs[i], surface.vertex_is_solid( vertices[i] ) );
+    }
+    
+    for ( size_t i = 0; i < edges.size(); ++i )
+    {
+        update_edge( edges[i], edge_lows[i], edge_highs[i], surface.edge_is_solid( edges[i] ) );
+    }
+    
+    for ( size_t i = 0; i < triangles.size(); ++i )
+    {
+        update_triangle( triangles[i], triangle_lows[i], triangle_highs[i], surface.triangle_is_solid( triangles[i] ) );
+    }
+}
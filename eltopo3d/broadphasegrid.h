@@ -43,7 +43,10 @@ public:
         m_solid_triangle_grid(),
         m_dynamic_vertex_grid(),
         m_dynamic_edge_grid(),
-        m_dynamic_triangle_grid()
+        m_dynamic_triangle_grid(),
+        m_is_built( false ),
+        m_built_continuous( false ),
+        m_built_length_scale( 0.0 )
     {}
     
     ~BroadPhaseGrid() 
@@ -53,6 +56,12 @@ public:
     ///
     void update_broad_phase( const DynamicSurface& surface, bool continuous );
     
+    /// Update only the elements incident to the given vertices, as long as the grids still fit the mesh
+    ///
+    void update_broad_phase_incremental( const DynamicSurface& surface, 
+                                        bool continuous, 
+                                        const std::vector<size_t>& moved_vertices );
+    
     inline void add_vertex( size_t index,
                            const Vec3d& aabb_low,
                            const Vec3d& aabb_high,
@@ -134,6 +143,13 @@ public:
     AccelerationGrid m_dynamic_edge_grid;
     AccelerationGrid m_dynamic_triangle_grid;
     
+    /// Whether the grids have been built, whether they used continuous bounds, and the cell size they were built with.
+    /// Used to decide when an incremental update is allowed.
+    ///
+    bool m_is_built;
+    bool m_built_continuous;
+    double m_built_length_scale;
+    
 };
 
 // ---------------------------------------------------------
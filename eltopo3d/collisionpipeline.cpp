@@ -11,6 +11,7 @@
 #include "collisionpipeline.h"
 
 #include "broadphase.h"
+#include "../common/ccd_batch.h"
 #include "../common/ccd_wrapper.h"
 #include "../common/collisionqueries.h"
 #include "dynamicsurface.h"
@@ -19,6 +20,12 @@
 #include "../common/wallclocktime.h"
 
 static const double IMPULSE_MULTIPLIER = 1.0;
+
+// Number of collision candidates handed to a thread at a time by test_collision_candidates_parallel
+static const size_t PARALLEL_CANDIDATE_BLOCK_SIZE = 1024;
+
+// Number of triangles handed to a thread at a time by find_intersections
+static const size_t PARALLEL_TRIANGLE_BLOCK_SIZE = 256;
     
 // --------------------------------------------------------
 ///
@@ -26,7 +33,8 @@ static const double IMPULSE_MULTIPLIER = 1.0;
 ///
 // --------------------------------------------------------
 
-bool check_edge_triangle_intersection_by_index(size_t edge_a, 
+bool check_edge_triangle_intersection_by_index(CCDBackendType backend,
+                                               size_t edge_a, 
                                                size_t edge_b, 
                                                size_t triangle_a, 
                                                size_t triangle_b, 
@@ -42,7 +50,7 @@ bool check_edge_triangle_intersection_by_index(size_t edge_a,
     
     static const bool DEGEN_COUNTS_AS_INTERSECTION = true;
     
-    return segment_triangle_intersection(m_positions[edge_a], edge_a, m_positions[edge_b], edge_b,
+    return segment_triangle_intersection(backend, m_positions[edge_a], edge_a, m_positions[edge_b], edge_b,
                                          m_positions[triangle_a], triangle_a, 
                                          m_positions[triangle_b], triangle_b, 
                                          m_positions[triangle_c], triangle_c,
@@ -88,7 +96,7 @@ CollisionPipeline::CollisionPipeline(DynamicSurface& surface,
                                      double in_friction_coefficient ) :
    m_friction_coefficient( in_friction_coefficient ),
    m_surface( surface ),
-   m_broad_phase( broadphase )
+   m_broad_phase( &broadphase )
 {}
 
 
@@ -167,10 +175,12 @@ void CollisionPipeline::apply_impulse(const Vec4d& alphas,
     v2 += friction_i*s2*inv_m2 * tan_collision_normal;
     v3 += friction_i*s3*inv_m3 * tan_collision_normal;
     
+    m_surface.begin_broad_phase_updates();
     m_surface.set_newposition( e0, m_surface.get_position(e0) + dt * m_surface.m_velocities[e0] );
     m_surface.set_newposition( e1, m_surface.get_position(e1) + dt * m_surface.m_velocities[e1] );
     m_surface.set_newposition( e2, m_surface.get_position(e2) + dt * m_surface.m_velocities[e2] );
     m_surface.set_newposition( e3, m_surface.get_position(e3) + dt * m_surface.m_velocities[e3] );
+    m_surface.commit_broad_phase_updates();
     
 }
 
@@ -246,7 +256,7 @@ void CollisionPipeline::add_triangle_candidates(size_t t,
     m_surface.triangle_continuous_bounds(t, tmin, tmax);
     
     std::vector<size_t> candidate_vertices;
-    m_broad_phase.get_potential_vertex_collisions(tmin, tmax, return_solid, return_dynamic, candidate_vertices);
+    m_broad_phase->get_potential_vertex_collisions(tmin, tmax, return_solid, return_dynamic, candidate_vertices);
     
     for (size_t j = 0; j < candidate_vertices.size(); j++)
     {
@@ -270,7 +280,7 @@ void CollisionPipeline::add_edge_candidates(size_t e,
     m_surface.edge_continuous_bounds(e, emin, emax);
     
     std::vector<size_t> candidate_edges;
-    m_broad_phase.get_potential_edge_collisions(emin, emax, return_solid, return_dynamic, candidate_edges);
+    m_broad_phase->get_potential_edge_collisions(emin, emax, return_solid, return_dynamic, candidate_edges);
     
     for (size_t j = 0; j < candidate_edges.size(); j++)
     {      
@@ -293,7 +303,7 @@ void CollisionPipeline::add_point_candidates(size_t v,
     m_surface.vertex_continuous_bounds(v, vmin, vmax);
     
     std::vector<size_t> candidate_triangles;
-    m_broad_phase.get_potential_triangle_collisions(vmin, vmax, return_solid, return_dynamic, candidate_triangles);
+    m_broad_phase->get_potential_triangle_collisions(vmin, vmax, return_solid, return_dynamic, candidate_triangles);
     
     for (size_t j = 0; j < candidate_triangles.size(); j++)
     {
@@ -317,8 +327,8 @@ void CollisionPipeline::add_point_update_candidates(size_t v,
     
     add_point_candidates(v, true, true, collision_candidates);
     
-    std::vector<size_t>& incident_triangles = m_surface.m_mesh.m_vertex_to_triangle_map[v];
-    std::vector<size_t>& incident_edges = m_surface.m_mesh.m_vertex_to_edge_map[v];
+    const VertexAdjacencyList& incident_triangles = m_surface.m_mesh.m_vertex_to_triangle_map[v];
+    const VertexAdjacencyList& incident_edges = m_surface.m_mesh.m_vertex_to_edge_map[v];
     
     for (size_t i = 0; i < incident_triangles.size(); i++)
     {
@@ -332,6 +342,97 @@ void CollisionPipeline::add_point_update_candidates(size_t v,
     
 }
 
+// ---------------------------------------------------------
+///
+/// Add collision candidates for the moving vertices of a pseudo motion and all elements incident on them
+///
+// ---------------------------------------------------------
+
+void CollisionPipeline::add_pseudo_motion_candidates( const PseudoMotion& motion, CollisionCandidateSet& collision_candidates )
+{
+    const NonDestructiveTriMesh& mesh = m_surface.m_mesh;
+    const Vec3d padding( m_surface.m_aabb_padding );
+    const std::vector<size_t>& moving_vertices = motion.get_moving_vertices();
+    
+    std::vector<size_t> overlapping;
+    
+    for ( size_t m = 0; m < moving_vertices.size(); ++m )
+    {
+        size_t v = moving_vertices[m];
+        Vec3d low, high;
+        
+        // point-triangle candidates
+        
+        minmax( m_surface.get_position(v), motion.get_newposition(v), low, high );
+        
+        overlapping.clear();
+        
+        m_broad_phase->get_potential_triangle_collisions( low - padding, high + padding, true, true, overlapping );
+        
+        for ( size_t j = 0; j < overlapping.size(); ++j )
+        {
+            collision_candidates.push_back( Vec3st( overlapping[j], v, 0 ) );
+        }
+        
+        // triangle-point candidates
+        
+        const VertexAdjacencyList& incident_triangles = mesh.m_vertex_to_triangle_map[v];
+        
+        for ( size_t i = 0; i < incident_triangles.size(); ++i )
+        {
+            size_t t = incident_triangles[i];
+            const Vec3st& tri = mesh.get_triangle(t);
+            if ( tri[0] == tri[1] ) { continue; }
+            
+            minmax( m_surface.get_position(tri[0]), motion.get_newposition(tri[0]), 
+                    m_surface.get_position(tri[1]), motion.get_newposition(tri[1]), 
+                    m_surface.get_position(tri[2]), motion.get_newposition(tri[2]), 
+                    low, high );
+            
+            overlapping.clear();
+            
+            m_broad_phase->get_potential_vertex_collisions( low - padding, high + padding, true, true, overlapping );
+            
+            for ( size_t j = 0; j < overlapping.size(); ++j )
+            {
+                collision_candidates.push_back( Vec3st( t, overlapping[j], 0 ) );
+            }
+        }
+        
+        // edge-edge candidates
+        
+        const VertexAdjacencyList& incident_edges = mesh.m_vertex_to_edge_map[v];
+        
+        for ( size_t i = 0; i < incident_edges.size(); ++i )
+        {
+            size_t e = incident_edges[i];
+            const Vec2st& edge = mesh.m_edges[e];
+            if ( edge[0] == edge[1] ) { continue; }
+            
+            minmax( m_surface.get_position(edge[0]), motion.get_newposition(edge[0]), 
+                    m_surface.get_position(edge[1]), motion.get_newposition(edge[1]), 
+                    low, high );
+            
+            overlapping.clear();
+            
+            m_broad_phase->get_potential_edge_collisions( low - padding, high + padding, true, true, overlapping );
+            
+            for ( size_t j = 0; j < overlapping.size(); ++j )
+            {
+                collision_candidates.push_back( Vec3st( e, overlapping[j], 1 ) );
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+
+inline const Vec3d& CollisionPipeline::get_newposition( size_t v, const PseudoMotion* motion ) const
+{
+    return motion ? motion->get_newposition(v) : m_surface.get_newposition(v);
+}
+
+
 
 // =========================================================
 //
@@ -347,6 +448,9 @@ void CollisionPipeline::process_proximity_candidates(double dt,
     
     static const double k = 10.0;
     
+    // the proximity tests read current positions only, so the broad phase can be brought up to date once at the end
+    m_surface.begin_broad_phase_updates();
+    
     while ( false == candidates.empty() )
     {
         CollisionCandidateSet::iterator iter = candidates.begin();
@@ -482,6 +586,8 @@ void CollisionPipeline::process_proximity_candidates(double dt,
         }
     }
     
+    m_surface.commit_broad_phase_updates();
+    
 }
 
 // ---------------------------------------------------------
@@ -582,7 +688,7 @@ void CollisionPipeline::handle_proximities(double dt)
 // =========================================================
 
 
-bool CollisionPipeline::detect_segment_segment_collision( const Vec3st& candidate, Collision& collision )
+bool CollisionPipeline::detect_segment_segment_collision( const Vec3st& candidate, Collision& collision, const PseudoMotion* motion ) const
 {
     
     assert( candidate[2] == 1 );
@@ -615,10 +721,10 @@ bool CollisionPipeline::detect_segment_segment_collision( const Vec3st& candidat
     size_t c = e1[0];
     size_t d = e1[1];
     
-    if (segment_segment_collision(m_surface.get_position(a), m_surface.get_newposition(a), a, 
-                                  m_surface.get_position(b), m_surface.get_newposition(b), b, 
-                                  m_surface.get_position(c), m_surface.get_newposition(c), c,
-                                  m_surface.get_position(d), m_surface.get_newposition(d), d, 
+    if (segment_segment_collision(m_surface.m_ccd_backend, m_surface.get_position(a), get_newposition(a, motion), a, 
+                                  m_surface.get_position(b), get_newposition(b, motion), b, 
+                                  m_surface.get_position(c), get_newposition(c, motion), c,
+                                  m_surface.get_position(d), get_newposition(d, motion), d, 
                                   s0, s2, normal, rel_disp) )
     {
         collision = Collision( true, Vec4st( a,b,c,d ), normal, Vec4d( s0, (1-s0), s2, (1-s2) ), rel_disp );         
@@ -632,7 +738,7 @@ bool CollisionPipeline::detect_segment_segment_collision( const Vec3st& candidat
 // ---------------------------------------------------------
 
 
-bool CollisionPipeline::detect_point_triangle_collision( const Vec3st& candidate, Collision& collision )
+bool CollisionPipeline::detect_point_triangle_collision( const Vec3st& candidate, Collision& collision, const PseudoMotion* motion ) const
 {
     assert( candidate[2] == 0 );
     
@@ -655,10 +761,10 @@ bool CollisionPipeline::detect_point_triangle_collision( const Vec3st& candidate
     Vec3d normal;
     Vec3st sorted_tri = sort_triangle(tri);
     
-    if ( point_triangle_collision(m_surface.get_position(v), m_surface.get_newposition(v), v,
-                                  m_surface.get_position(sorted_tri[0]), m_surface.get_newposition(sorted_tri[0]), sorted_tri[0],
-                                  m_surface.get_position(sorted_tri[1]), m_surface.get_newposition(sorted_tri[1]), sorted_tri[1],
-                                  m_surface.get_position(sorted_tri[2]), m_surface.get_newposition(sorted_tri[2]), sorted_tri[2],
+    if ( point_triangle_collision(m_surface.m_ccd_backend, m_surface.get_position(v), get_newposition(v, motion), v,
+                                  m_surface.get_position(sorted_tri[0]), get_newposition(sorted_tri[0], motion), sorted_tri[0],
+                                  m_surface.get_position(sorted_tri[1]), get_newposition(sorted_tri[1], motion), sorted_tri[1],
+                                  m_surface.get_position(sorted_tri[2]), get_newposition(sorted_tri[2], motion), sorted_tri[2],
                                   s1, s2, s3, normal, rel_disp) )
         
     {
@@ -672,6 +778,49 @@ bool CollisionPipeline::detect_point_triangle_collision( const Vec3st& candidate
 
 // ---------------------------------------------------------
 
+void CollisionPipeline::cull_collision_candidates( const Vec3st* candidates, 
+                                                   size_t num_candidates, 
+                                                   unsigned char* may_collide,
+                                                   const PseudoMotion* motion ) const
+{
+    assert( num_candidates <= CCD_BATCH_WIDTH );
+    
+    CCDBatch batch;
+    
+    for ( size_t i = 0; i < num_candidates; ++i )
+    {
+        const Vec3st& candidate = candidates[i];
+        Vec4st vs;
+        
+        if ( candidate[2] == 1 )
+        {
+            const Vec2st& e0 = m_surface.m_mesh.m_edges[candidate[0]];
+            const Vec2st& e1 = m_surface.m_mesh.m_edges[candidate[1]];
+            vs = Vec4st( e0[0], e0[1], e1[0], e1[1] );
+        }
+        else
+        {
+            const Vec3st& tri = m_surface.m_mesh.get_triangle( candidate[0] );
+            vs = Vec4st( candidate[1], tri[0], tri[1], tri[2] );
+        }
+        
+        batch.push_back( m_surface.get_position(vs[0]), get_newposition(vs[0], motion),
+                         m_surface.get_position(vs[1]), get_newposition(vs[1], motion),
+                         m_surface.get_position(vs[2]), get_newposition(vs[2], motion),
+                         m_surface.get_position(vs[3]), get_newposition(vs[3], motion) );
+    }
+    
+    unsigned char may_be_coplanar[CCD_BATCH_WIDTH];
+    batch_coplanarity_cull( batch, may_be_coplanar );
+    
+    for ( size_t i = 0; i < num_candidates; ++i )
+    {
+        may_collide[i] = may_be_coplanar[i];
+    }
+}
+
+// ---------------------------------------------------------
+
 void CollisionPipeline::process_collision_candidates(double dt,
                                                      CollisionCandidateSet& candidates,
                                                      bool add_to_new_candidates,
@@ -684,11 +833,30 @@ void CollisionPipeline::process_collision_candidates(double dt,
     
     static const size_t MAX_CANDIDATES = 1000000;
     
+    Vec3st batch[CCD_BATCH_WIDTH];
+    unsigned char may_collide[CCD_BATCH_WIDTH];
+    size_t batch_size = 0, batch_next = 0;
+    
     while ( false == candidates.empty() && i++ < max_iteration )
     {
-        CollisionCandidateSet::iterator iter = candidates.begin();
-        Vec3st candidate = *iter;
-        candidates.erase(iter);
+        // Cull the candidates at the front of the queue in batches.  Impulses move vertices, so the rest of a batch is
+        // re-culled after each collision.
+        
+        if ( batch_next == batch_size )
+        {
+            batch_size = std::min( candidates.size(), (size_t) CCD_BATCH_WIDTH );
+            batch_next = 0;
+            std::copy( candidates.begin(), candidates.begin() + batch_size, batch );
+            cull_collision_candidates( batch, batch_size, may_collide );
+        }
+        
+        Vec3st candidate = candidates.front();
+        candidates.pop_front();
+        
+        if ( !may_collide[batch_next++] )
+        {
+            continue;
+        }
         
         if ( candidate[2] == 1 )
         {
@@ -696,6 +864,8 @@ void CollisionPipeline::process_collision_candidates(double dt,
             Collision collision;
             if ( detect_segment_segment_collision( candidate, collision ) )
             {            
+                batch_next = batch_size;
+                
                 double relvel = collision.m_relative_displacement / dt;
                 double desired_relative_velocity = 0.0;
                 double impulse = IMPULSE_MULTIPLIER * (desired_relative_velocity - relvel);
@@ -724,6 +894,8 @@ void CollisionPipeline::process_collision_candidates(double dt,
             Collision collision;
             if ( detect_point_triangle_collision( candidate, collision ) )
             {
+                batch_next = batch_size;
+                
                 double relvel = collision.m_relative_displacement / dt;
                 double desired_relative_velocity = 0.0;
                 double impulse = IMPULSE_MULTIPLIER * (desired_relative_velocity - relvel);
@@ -766,11 +938,33 @@ void CollisionPipeline::test_collision_candidates(CollisionCandidateSet& candida
     
     const size_t MAX_COLLISIONS = 5000;
     
+    if ( m_surface.m_num_threads > 1 && candidates.size() > PARALLEL_CANDIDATE_BLOCK_SIZE )
+    {
+        test_collision_candidates_parallel( candidates, collisions, status );
+        return;
+    }
+    
+    Vec3st batch[CCD_BATCH_WIDTH];
+    unsigned char may_collide[CCD_BATCH_WIDTH];
+    size_t batch_size = 0, batch_next = 0;
+    
     while ( false == candidates.empty() )
     {
-        CollisionCandidateSet::iterator iter = candidates.begin();
-        Vec3st candidate = *iter;
-        candidates.erase(iter);
+        if ( batch_next == batch_size )
+        {
+            batch_size = std::min( candidates.size(), (size_t) CCD_BATCH_WIDTH );
+            batch_next = 0;
+            std::copy( candidates.begin(), candidates.begin() + batch_size, batch );
+            cull_collision_candidates( batch, batch_size, may_collide );
+        }
+        
+        Vec3st candidate = candidates.front();
+        candidates.pop_front();
+        
+        if ( !may_collide[batch_next++] )
+        {
+            continue;
+        }
         
         if ( candidate[2] == 1 )
         {
@@ -820,22 +1014,130 @@ void CollisionPipeline::test_collision_candidates(CollisionCandidateSet& candida
     
 }
 
+
+// --------------------------------------------------------
+///
+/// Test the candidates and return collision info, running the CCD tests on m_surface.m_num_threads threads.
+///
+/// Candidates are split into fixed-size blocks which are tested independently, each into its own result buffer.  The
+/// buffers are then concatenated in candidate order, so the output (including where we stop on overflow) does not 
+/// depend on the number of threads or on scheduling.  Requires the CCD predicates to be reentrant.
+///
+// --------------------------------------------------------
+
+void CollisionPipeline::test_collision_candidates_parallel( CollisionCandidateSet& candidates,
+                                                           std::vector<Collision>& collisions,
+                                                           ProcessCollisionStatus& status )
+{
+    const size_t MAX_COLLISIONS = 5000;
+    
+    const std::vector<Vec3st> candidate_list( candidates.begin(), candidates.end() );
+    const size_t num_candidates = candidate_list.size();
+    const int num_blocks = (int) ( ( num_candidates + PARALLEL_CANDIDATE_BLOCK_SIZE - 1 ) / PARALLEL_CANDIDATE_BLOCK_SIZE );
+    
+    // per-block results: collisions found, and the index of the candidate which generated each one
+    std::vector< std::vector<Collision> > block_collisions( num_blocks );
+    std::vector< std::vector<size_t> > block_candidate_indices( num_blocks );
+    
+    #pragma omp parallel for schedule(dynamic) num_threads(m_surface.m_num_threads)
+    for ( int b = 0; b < num_blocks; ++b )
+    {
+        const size_t begin = (size_t) b * PARALLEL_CANDIDATE_BLOCK_SIZE;
+        const size_t end = std::min( begin + PARALLEL_CANDIDATE_BLOCK_SIZE, num_candidates );
+        
+        unsigned char may_collide[CCD_BATCH_WIDTH];
+        
+        for ( size_t i = begin; i < end; ++i )
+        {
+            if ( ( i - begin ) % CCD_BATCH_WIDTH == 0 )
+            {
+                cull_collision_candidates( &candidate_list[i], std::min( end - i, (size_t) CCD_BATCH_WIDTH ), may_collide );
+            }
+            
+            if ( !may_collide[( i - begin ) % CCD_BATCH_WIDTH] )
+            {
+                continue;
+            }
+            
+            const Vec3st& candidate = candidate_list[i];
+            Collision collision;
+            
+            bool hit;
+            if ( candidate[2] == 1 )
+            {
+                hit = detect_segment_segment_collision( candidate, collision );
+            }
+            else
+            {
+                hit = detect_point_triangle_collision( candidate, collision );
+            }
+            
+            if ( hit )
+            {
+                block_collisions[b].push_back( collision );
+                block_candidate_indices[b].push_back( i );
+            }
+        }
+    }
+    
+    // merge in candidate order, stopping where the serial version would have stopped
+    
+    for ( int b = 0; b < num_blocks; ++b )
+    {
+        for ( size_t j = 0; j < block_collisions[b].size(); ++j )
+        {
+            status.collision_found = true;
+            collisions.push_back( block_collisions[b][j] );
+            
+            if ( collisions.size() > MAX_COLLISIONS )
+            {
+                // candidates up to and including this one have been consumed
+                candidates.erase( candidates.begin(), candidates.begin() + block_candidate_indices[b][j] + 1 );
+                status.overflow = true;
+                status.all_candidates_processed = false;
+                return;
+            }
+        }
+    }
+    
+    candidates.clear();
+    
+    status.all_candidates_processed = true;
+    
+    assert( status.all_candidates_processed == !status.overflow );
+    
+}
+
 // ---------------------------------------------------------
 
-bool CollisionPipeline::any_collision( CollisionCandidateSet& candidates, Collision& collision )
+bool CollisionPipeline::any_collision( const CollisionCandidateSet& candidates, Collision& collision, const PseudoMotion* motion ) const
 {
     
-    CollisionCandidateSet::iterator iter = candidates.begin();
+    Vec3st batch[CCD_BATCH_WIDTH];
+    unsigned char may_collide[CCD_BATCH_WIDTH];
     
-    for ( ; iter != candidates.end(); ++iter )
+    CollisionCandidateSet::const_iterator iter = candidates.begin();
+    
+    for ( size_t i = 0; iter != candidates.end(); ++iter, ++i )
     {
+        if ( i % CCD_BATCH_WIDTH == 0 )
+        {
+            size_t batch_size = std::min( (size_t) ( candidates.end() - iter ), (size_t) CCD_BATCH_WIDTH );
+            std::copy( iter, iter + batch_size, batch );
+            cull_collision_candidates( batch, batch_size, may_collide, motion );
+        }
+        
+        if ( !may_collide[i % CCD_BATCH_WIDTH] )
+        {
+            continue;
+        }
         
         Vec3st candidate = *iter;
         
         if ( candidate[2] == 1 )
         {
             // edge-edge
-            if ( detect_segment_segment_collision( candidate, collision ) )
+            if ( detect_segment_segment_collision( candidate, collision, motion ) )
             {
                 return true;
             }         
@@ -843,7 +1145,7 @@ bool CollisionPipeline::any_collision( CollisionCandidateSet& candidates, Collis
         else
         {
             // point-triangle
-            if ( detect_point_triangle_collision( candidate, collision ) )
+            if ( detect_point_triangle_collision( candidate, collision, motion ) )
             {
                 return true;
             }
@@ -1146,7 +1448,7 @@ bool CollisionPipeline::detect_collisions( std::vector<Collision>& collisions )
 ///
 // ---------------------------------------------------------
 
-bool CollisionPipeline::detect_new_collisions( const std::vector<ImpactZone> impact_zones, std::vector<Collision>& collisions ) 
+bool CollisionPipeline::detect_new_collisions( const std::vector<ImpactZone>& impact_zones, std::vector<Collision>& collisions ) 
 {
     //m_surface.check_continuous_broad_phase_is_up_to_date();
     
@@ -1154,17 +1456,11 @@ bool CollisionPipeline::detect_new_collisions( const std::vector<ImpactZone> imp
     std::vector<size_t> zone_edges;
     std::vector<size_t> zone_triangles;
     
-    // Get all vertices in the impact zone
+    // Get all vertices in the impact zone (zones don't share vertices)
     
     for ( size_t i = 0; i < impact_zones.size(); ++i )
     {
-        for ( size_t j = 0; j < impact_zones[i].m_collisions.size(); ++j )
-        {
-            add_unique( zone_vertices, impact_zones[i].m_collisions[j].m_vertex_indices[0] );
-            add_unique( zone_vertices, impact_zones[i].m_collisions[j].m_vertex_indices[1] );
-            add_unique( zone_vertices, impact_zones[i].m_collisions[j].m_vertex_indices[2] );
-            add_unique( zone_vertices, impact_zones[i].m_collisions[j].m_vertex_indices[3] );         
-        }
+        zone_vertices.insert( zone_vertices.end(), impact_zones[i].m_vertices.begin(), impact_zones[i].m_vertices.end() );
     }
     
     // Get all triangles in the impact zone
@@ -1281,7 +1577,7 @@ void CollisionPipeline::detect_collisions(size_t edge_index,
     
     // edge vs triangle edge 0
     
-    if (segment_segment_collision(m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
+    if (segment_segment_collision(m_surface.m_ccd_backend, m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
                                   m_surface.get_position(e1), m_surface.get_newposition(e1), e1,
                                   m_surface.get_position(t0), m_surface.get_newposition(t0), t0,
                                   m_surface.get_position(t1), m_surface.get_newposition(t1), t1,
@@ -1302,7 +1598,7 @@ void CollisionPipeline::detect_collisions(size_t edge_index,
     
     // edge vs triangle edge 1
     
-    if (segment_segment_collision(m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
+    if (segment_segment_collision(m_surface.m_ccd_backend, m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
                                   m_surface.get_position(e1), m_surface.get_newposition(e1), e1,
                                   m_surface.get_position(t1), m_surface.get_newposition(t1), t1,
                                   m_surface.get_position(t2), m_surface.get_newposition(t2), t2,
@@ -1325,7 +1621,7 @@ void CollisionPipeline::detect_collisions(size_t edge_index,
     // edge vs triangle edge 2
     
     
-    if (segment_segment_collision(m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
+    if (segment_segment_collision(m_surface.m_ccd_backend, m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
                                   m_surface.get_position(e1), m_surface.get_newposition(e1), e1,
                                   m_surface.get_position(t0), m_surface.get_newposition(t0), t0,
                                   m_surface.get_position(t2), m_surface.get_newposition(t2), t2,
@@ -1346,7 +1642,7 @@ void CollisionPipeline::detect_collisions(size_t edge_index,
     
     // edge point 0 vs triangle
     
-    if ( point_triangle_collision(m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
+    if ( point_triangle_collision(m_surface.m_ccd_backend, m_surface.get_position(e0), m_surface.get_newposition(e0), e0,
                                   m_surface.get_position(t0), m_surface.get_newposition(t0), t0,
                                   m_surface.get_position(t1), m_surface.get_newposition(t1), t1,
                                   m_surface.get_position(t2), m_surface.get_newposition(t2), t2,
@@ -1358,7 +1654,7 @@ void CollisionPipeline::detect_collisions(size_t edge_index,
     
     // edge point 1 vs triangle
     
-    if ( point_triangle_collision(m_surface.get_position(e1), m_surface.get_newposition(e1), e1,
+    if ( point_triangle_collision(m_surface.m_ccd_backend, m_surface.get_position(e1), m_surface.get_newposition(e1), e1,
                                   m_surface.get_position(t0), m_surface.get_newposition(t0), t0,
                                   m_surface.get_position(t1), m_surface.get_newposition(t1), t1,
                                   m_surface.get_position(t2), m_surface.get_newposition(t2), t2,
@@ -1474,7 +1770,7 @@ bool CollisionPipeline::check_if_collision_persists( const Collision& collision
     
     if ( collision.m_is_edge_edge )
     {
-        return segment_segment_collision( m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0], 
+        return segment_segment_collision( m_surface.m_ccd_backend, m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0], 
                                          m_surface.get_position(vs[1]), m_surface.get_newposition(vs[1]), vs[1], 
                                          m_surface.get_position(vs[2]), m_surface.get_newposition(vs[2]), vs[2],
                                          m_surface.get_position(vs[3]), m_surface.get_newposition(vs[3]), vs[3] ); 
@@ -1482,7 +1778,7 @@ bool CollisionPipeline::check_if_collision_persists( const Collision& collision
     }
     else
     {
-        return point_triangle_collision( m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0], 
+        return point_triangle_collision( m_surface.m_ccd_backend, m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0], 
                                         m_surface.get_position(vs[1]), m_surface.get_newposition(vs[1]), vs[1], 
                                         m_surface.get_position(vs[2]), m_surface.get_newposition(vs[2]), vs[2],
                                         m_surface.get_position(vs[3]), m_surface.get_newposition(vs[3]), vs[3] ); 
@@ -1508,7 +1804,7 @@ void CollisionPipeline::get_triangle_intersections( const Vec3d& segment_point_a
     minmax( segment_point_a, segment_point_b, aabb_low, aabb_high );
     
     std::vector<size_t> overlapping_triangles;
-    m_broad_phase.get_potential_triangle_collisions( aabb_low, aabb_high, true, true, overlapping_triangles );
+    m_broad_phase->get_potential_triangle_collisions( aabb_low, aabb_high, true, true, overlapping_triangles );
     
     for ( size_t i = 0; i < overlapping_triangles.size(); ++i )
     {
@@ -1527,7 +1823,7 @@ void CollisionPipeline::get_triangle_intersections( const Vec3d& segment_point_a
         Vec3d normal;
         double sa, sb;
         
-        bool hit = segment_triangle_intersection(segment_point_a, dummy_index, 
+        bool hit = segment_triangle_intersection(m_surface.m_ccd_backend, segment_point_a, dummy_index, 
                                                  segment_point_b, dummy_index+1,
                                                  v0, t[0],
                                                  v1, t[1],
@@ -1560,7 +1856,7 @@ size_t CollisionPipeline::get_number_of_triangle_intersections( const Vec3d& seg
     minmax( segment_point_a, segment_point_b, aabb_low, aabb_high );
     
     std::vector<size_t> overlapping_triangles;
-    m_broad_phase.get_potential_triangle_collisions( aabb_low, aabb_high, true, true, overlapping_triangles );
+    m_broad_phase->get_potential_triangle_collisions( aabb_low, aabb_high, true, true, overlapping_triangles );
     
     for ( size_t i = 0; i < overlapping_triangles.size(); ++i )
     {
@@ -1576,7 +1872,7 @@ size_t CollisionPipeline::get_number_of_triangle_intersections( const Vec3d& seg
         size_t dummy_index = m_surface.get_num_vertices();
         static const bool degenerate_counts_as_hit = true;
         
-        bool hit = segment_triangle_intersection( segment_point_a, dummy_index,
+        bool hit = segment_triangle_intersection( m_surface.m_ccd_backend, segment_point_a, dummy_index,
                                                  segment_point_b, dummy_index + 1, 
                                                  v0, t[0],
                                                  v1, t[1],
@@ -1632,14 +1928,14 @@ bool CollisionPipeline::check_triangle_vs_all_triangles_for_intersection( const
     {
         
         const Vec3st& curr_tri = m_surface.m_mesh.get_triangle( overlapping_triangles[i] );
-        bool result = check_edge_triangle_intersection_by_index( tri[0], tri[1],
+        bool result = check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[0], tri[1],
                                                                 curr_tri[0], curr_tri[1], curr_tri[2],
                                                                 m_surface.get_positions(),
                                                                 false );
         
         if ( result )
         {
-            check_edge_triangle_intersection_by_index( tri[0], tri[1],
+            check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[0], tri[1],
                                                       curr_tri[0], curr_tri[1], curr_tri[2],
                                                       m_surface.get_positions(),
                                                       true );
@@ -1659,14 +1955,14 @@ bool CollisionPipeline::check_triangle_vs_all_triangles_for_intersection( const
     {
         const Vec3st& curr_tri = m_surface.m_mesh.get_triangle( overlapping_triangles[i] );
         
-        bool result = check_edge_triangle_intersection_by_index( tri[1], tri[2],
+        bool result = check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[1], tri[2],
                                                                 curr_tri[0], curr_tri[1], curr_tri[2],
                                                                 m_surface.get_positions(),
                                                                 false );
         
         if ( result )
         {
-            check_edge_triangle_intersection_by_index( tri[1], tri[2],
+            check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[1], tri[2],
                                                       curr_tri[0], curr_tri[1], curr_tri[2],
                                                       m_surface.get_positions(),
                                                       true );
@@ -1686,14 +1982,14 @@ bool CollisionPipeline::check_triangle_vs_all_triangles_for_intersection( const
     {
         const Vec3st& curr_tri = m_surface.m_mesh.get_triangle( overlapping_triangles[i] );
         
-        bool result = check_edge_triangle_intersection_by_index( tri[2], tri[0],
+        bool result = check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[2], tri[0],
                                                                 curr_tri[0], curr_tri[1], curr_tri[2],
                                                                 m_surface.get_positions(),
                                                                 false );
         
         if ( result )
         {
-            check_edge_triangle_intersection_by_index( tri[2], tri[0],
+            check_edge_triangle_intersection_by_index( m_surface.m_ccd_backend, tri[2], tri[0],
                                                       curr_tri[0], curr_tri[1], curr_tri[2],
                                                       m_surface.get_positions(),
                                                       true );
@@ -1716,7 +2012,7 @@ bool CollisionPipeline::check_triangle_vs_all_triangles_for_intersection( const
     for ( size_t i = 0; i < overlapping_edges.size(); ++i )
     {
         
-        bool result = check_edge_triangle_intersection_by_index(m_surface.m_mesh.m_edges[overlapping_edges[i]][0], 
+        bool result = check_edge_triangle_intersection_by_index(m_surface.m_ccd_backend, m_surface.m_mesh.m_edges[overlapping_edges[i]][0], 
                                                                 m_surface.m_mesh.m_edges[overlapping_edges[i]][1], 
                                                                 tri[0], tri[1], tri[2],
                                                                 m_surface.get_positions(),
@@ -1724,7 +2020,7 @@ bool CollisionPipeline::check_triangle_vs_all_triangles_for_intersection( const
         
         if ( result )
         {
-            check_edge_triangle_intersection_by_index(m_surface.m_mesh.m_edges[overlapping_edges[i]][0], 
+            check_edge_triangle_intersection_by_index(m_surface.m_ccd_backend, m_surface.m_mesh.m_edges[overlapping_edges[i]][0], 
                                                       m_surface.m_mesh.m_edges[overlapping_edges[i]][1], 
                                                       tri[0], tri[1], tri[2],
                                                       m_surface.get_positions(),
@@ -1748,6 +2044,48 @@ void CollisionPipeline::get_intersections( bool degeneracy_counts_as_intersectio
                                        bool use_new_positions, 
                                        std::vector<Intersection>& intersections )
 {
+    find_intersections( degeneracy_counts_as_intersection, use_new_positions, false, intersections );
+}
+
+
+// ---------------------------------------------------------
+///
+/// Look for self-intersections, but stop when the first one is found.  Returns true and sets intersection if one 
+/// was found.  The intersection returned is the same one get_intersections would list first.
+///
+// ---------------------------------------------------------
+
+bool CollisionPipeline::get_first_intersection( bool degeneracy_counts_as_intersection, 
+                                                bool use_new_positions, 
+                                                Intersection& intersection )
+{
+    std::vector<Intersection> intersections;
+    find_intersections( degeneracy_counts_as_intersection, use_new_positions, true, intersections );
+    
+    if ( intersections.empty() )
+    {
+        return false;
+    }
+    
+    intersection = intersections[0];
+    return true;
+}
+
+
+// ---------------------------------------------------------
+///
+/// Test all edge-triangle pairs reported by the broad phase for intersection.  Triangles are processed in blocks 
+/// on m_surface.m_num_threads threads, each block writing to its own buffer; buffers are appended in triangle order 
+/// so the result does not depend on the thread count.  If stop_at_first is set, blocks after the first block 
+/// containing an intersection are skipped, and only that block's first intersection is returned.
+///
+// ---------------------------------------------------------
+
+void CollisionPipeline::find_intersections( bool degeneracy_counts_as_intersection, 
+                                            bool use_new_positions, 
+                                            bool stop_at_first,
+                                            std::vector<Intersection>& intersections )
+{
     
     //assert( degeneracy_counts_as_intersection == false );
     
@@ -1760,67 +2098,116 @@ void CollisionPipeline::get_intersections( bool degeneracy_counts_as_intersectio
     //      check_static_broad_phase_is_up_to_date();
     //   }
     
-    for ( size_t i = 0; i < m_surface.m_mesh.num_triangles(); ++i )
+    const size_t num_triangles = m_surface.m_mesh.num_triangles();
+    const int num_blocks = (int) ( ( num_triangles + PARALLEL_TRIANGLE_BLOCK_SIZE - 1 ) / PARALLEL_TRIANGLE_BLOCK_SIZE );
+    
+    std::vector< std::vector<Intersection> > block_intersections( num_blocks );
+    
+    // lowest block index containing an intersection, used for early exit (only accessed in the 
+    // eltopo_first_intersection critical section)
+    int first_hit_block = num_blocks;
+    
+    #pragma omp parallel for schedule(dynamic) num_threads(m_surface.m_num_threads)
+    for ( int b = 0; b < num_blocks; ++b )
     {
-        std::vector<size_t> edge_candidates;
-        
-        bool get_solid_edges = !m_surface.triangle_is_solid(i);
-        
-        Vec3d low, high;
-        m_surface.triangle_static_bounds( i, low, high );       
-        m_surface.m_broad_phase->get_potential_edge_collisions( low, high, get_solid_edges, true, edge_candidates );
-        
-        const Vec3st& triangle = m_surface.m_mesh.get_triangle(i);
+        if ( stop_at_first )
+        {
+            int current_first_hit;
+            #pragma omp critical(eltopo_first_intersection)
+            current_first_hit = first_hit_block;
+            if ( current_first_hit < b ) { continue; }
+        }
         
-        if ( triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0] )    { continue; }
+        const size_t begin = (size_t) b * PARALLEL_TRIANGLE_BLOCK_SIZE;
+        const size_t end = std::min( begin + PARALLEL_TRIANGLE_BLOCK_SIZE, num_triangles );
         
-        assert( m_surface.m_mesh.get_edge_index( triangle[0], triangle[1] ) != m_surface.m_mesh.m_edges.size() );
-        assert( m_surface.m_mesh.get_edge_index( triangle[1], triangle[2] ) != m_surface.m_mesh.m_edges.size() );
-        assert( m_surface.m_mesh.get_edge_index( triangle[2], triangle[0] ) != m_surface.m_mesh.m_edges.size() );
+        std::vector<size_t> edge_candidates;
+        std::vector<Intersection>& block_results = block_intersections[b];
         
-        for ( size_t j = 0; j < edge_candidates.size(); ++j )
+        for ( size_t i = begin; i < end; ++i )
         {
+            edge_candidates.clear();
+            
+            bool get_solid_edges = !m_surface.triangle_is_solid(i);
             
-            assert ( !m_surface.triangle_is_solid( i ) || !m_surface.edge_is_solid( edge_candidates[j] ) );
+            Vec3d low, high;
+            m_surface.triangle_static_bounds( i, low, high );       
+            m_surface.m_broad_phase->get_potential_edge_collisions( low, high, get_solid_edges, true, edge_candidates );
             
-            const Vec2st& edge = m_surface.m_mesh.m_edges[ edge_candidates[j] ];
+            const Vec3st& triangle = m_surface.m_mesh.get_triangle(i);
             
-            if ( edge[0] == edge[1] )    { continue; }
+            if ( triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0] )    { continue; }
             
-            if (    edge[0] == triangle[0] || edge[0] == triangle[1] || edge[0] == triangle[2] 
-                || edge[1] == triangle[0] || edge[1] == triangle[1] || edge[1] == triangle[2] )
+            assert( m_surface.m_mesh.get_edge_index( triangle[0], triangle[1] ) != m_surface.m_mesh.m_edges.size() );
+            assert( m_surface.m_mesh.get_edge_index( triangle[1], triangle[2] ) != m_surface.m_mesh.m_edges.size() );
+            assert( m_surface.m_mesh.get_edge_index( triangle[2], triangle[0] ) != m_surface.m_mesh.m_edges.size() );
+            
+            for ( size_t j = 0; j < edge_candidates.size(); ++j )
             {
-                continue;
+                
+                assert ( !m_surface.triangle_is_solid( i ) || !m_surface.edge_is_solid( edge_candidates[j] ) );
+                
+                const Vec2st& edge = m_surface.m_mesh.m_edges[ edge_candidates[j] ];
+                
+                if ( edge[0] == edge[1] )    { continue; }
+                
+                if (    edge[0] == triangle[0] || edge[0] == triangle[1] || edge[0] == triangle[2] 
+                    || edge[1] == triangle[0] || edge[1] == triangle[1] || edge[1] == triangle[2] )
+                {
+                    continue;
+                }
+                
+                const Vec3d& e0 = use_new_positions ? m_surface.get_newposition(edge[0]) : m_surface.get_position(edge[0]);
+                const Vec3d& e1 = use_new_positions ? m_surface.get_newposition(edge[1]) : m_surface.get_position(edge[1]);
+                const Vec3d& t0 = use_new_positions ? m_surface.get_newposition(triangle[0]) : m_surface.get_position(triangle[0]);
+                const Vec3d& t1 = use_new_positions ? m_surface.get_newposition(triangle[1]) : m_surface.get_position(triangle[1]);
+                const Vec3d& t2 = use_new_positions ? m_surface.get_newposition(triangle[2]) : m_surface.get_position(triangle[2]);
+                
+                if ( segment_triangle_intersection(m_surface.m_ccd_backend, e0, edge[0], 
+                                                   e1, edge[1],
+                                                   t0, triangle[0], 
+                                                   t1, triangle[1], 
+                                                   t2, triangle[2], 
+                                                   degeneracy_counts_as_intersection, false ) )
+                {
+                    block_results.push_back( Intersection( edge_candidates[j], i ) );
+                    if ( stop_at_first ) { break; }
+                }
+                
             }
             
-            const Vec3d& e0 = use_new_positions ? m_surface.get_newposition(edge[0]) : m_surface.get_position(edge[0]);
-            const Vec3d& e1 = use_new_positions ? m_surface.get_newposition(edge[1]) : m_surface.get_position(edge[1]);
-            const Vec3d& t0 = use_new_positions ? m_surface.get_newposition(triangle[0]) : m_surface.get_position(triangle[0]);
-            const Vec3d& t1 = use_new_positions ? m_surface.get_newposition(triangle[1]) : m_surface.get_position(triangle[1]);
-            const Vec3d& t2 = use_new_positions ? m_surface.get_newposition(triangle[2]) : m_surface.get_position(triangle[2]);
+            if ( stop_at_first && !block_results.empty() ) { break; }
+        }
+        
+        if ( stop_at_first && !block_results.empty() )
+        {
+            #pragma omp critical(eltopo_first_intersection)
+            first_hit_block = std::min( first_hit_block, b );
+        }
+    }
+    
+    for ( int b = 0; b < num_blocks; ++b )
+    {
+        for ( size_t k = 0; k < block_intersections[b].size(); ++k )
+        {
+            const Intersection& intersection = block_intersections[b][k];
             
-            if ( segment_triangle_intersection(e0, edge[0], 
-                                               e1, edge[1],
-                                               t0, triangle[0], 
-                                               t1, triangle[1], 
-                                               t2, triangle[2], 
-                                               degeneracy_counts_as_intersection, m_surface.m_verbose ) )
+            if(m_surface.m_verbose)
             {
-              if(m_surface.m_verbose)
-              {
+                const Vec2st& edge = m_surface.m_mesh.m_edges[ intersection.m_edge_index ];
+                const Vec3st& triangle = m_surface.m_mesh.get_triangle( intersection.m_triangle_index );
                 std::cout << "intersection: " << edge << " vs " << triangle << std::endl;
-                std::cout << "e0: " << e0 << std::endl;
-                std::cout << "e1: " << e1 << std::endl;
-                std::cout << "t0: " << t0 << std::endl;
-                std::cout << "t1: " << t1 << std::endl;
-                std::cout << "t2: " << t2 << std::endl;            
-              }
-                
-                intersections.push_back( Intersection( edge_candidates[j], i ) );
+                std::cout << "e0: " << ( use_new_positions ? m_surface.get_newposition(edge[0]) : m_surface.get_position(edge[0]) ) << std::endl;
+                std::cout << "e1: " << ( use_new_positions ? m_surface.get_newposition(edge[1]) : m_surface.get_position(edge[1]) ) << std::endl;
+                std::cout << "t0: " << ( use_new_positions ? m_surface.get_newposition(triangle[0]) : m_surface.get_position(triangle[0]) ) << std::endl;
+                std::cout << "t1: " << ( use_new_positions ? m_surface.get_newposition(triangle[1]) : m_surface.get_position(triangle[1]) ) << std::endl;
+                std::cout << "t2: " << ( use_new_positions ? m_surface.get_newposition(triangle[2]) : m_surface.get_position(triangle[2]) ) << std::endl;            
             }
             
+            intersections.push_back( intersection );
+            
+            if ( stop_at_first ) { return; }
         }
-        
     }
     
 }
@@ -1834,21 +2221,20 @@ void CollisionPipeline::get_intersections( bool degeneracy_counts_as_intersectio
 void CollisionPipeline::assert_mesh_is_intersection_free( bool degeneracy_counts_as_intersection )
 {
     
-    std::vector<Intersection> intersections;
-    get_intersections( degeneracy_counts_as_intersection, false, intersections );
+    Intersection intersection( 0, 0 );
     
-    for ( size_t i = 0; i < intersections.size(); ++i )
+    if ( get_first_intersection( degeneracy_counts_as_intersection, false, intersection ) )
     {
         
-        const Vec3st& triangle = m_surface.m_mesh.get_triangle( intersections[i].m_triangle_index );
-        const Vec2st& edge = m_surface.m_mesh.m_edges[ intersections[i].m_edge_index ];
+        const Vec3st& triangle = m_surface.m_mesh.get_triangle( intersection.m_triangle_index );
+        const Vec2st& edge = m_surface.m_mesh.m_edges[ intersection.m_edge_index ];
         
         if(m_surface.m_verbose)
         {
           std::cout << "Intersection!  Triangle " << triangle << " vs edge " << edge << std::endl;
         }
         
-        segment_triangle_intersection(m_surface.get_position(edge[0]), edge[0], 
+        segment_triangle_intersection(m_surface.m_ccd_backend, m_surface.get_position(edge[0]), edge[0], 
                                       m_surface.get_position(edge[1]), edge[1],
                                       m_surface.get_position(triangle[0]), triangle[0],
                                       m_surface.get_position(triangle[1]), triangle[1], 
@@ -1887,7 +2273,7 @@ void CollisionPipeline::assert_predicted_mesh_is_intersection_free( bool degener
           std::cout << "Intersection!  Triangle " << triangle << " vs edge " << edge << std::endl;
         }
         
-        segment_triangle_intersection(m_surface.get_position(edge[0]), edge[0], 
+        segment_triangle_intersection(m_surface.m_ccd_backend, m_surface.get_position(edge[0]), edge[0], 
                                       m_surface.get_position(edge[1]), edge[1],
                                       m_surface.get_position(triangle[0]), triangle[0],
                                       m_surface.get_position(triangle[1]), triangle[1], 
@@ -1942,7 +2328,7 @@ void CollisionPipeline::assert_predicted_mesh_is_intersection_free( bool degener
           std::cout << "-----\n edge-triangle check using m_positions:" << std::endl;
         }
         
-        bool result = segment_triangle_intersection(m_surface.get_position(edge[0]), edge[0], 
+        bool result = segment_triangle_intersection(m_surface.m_ccd_backend, m_surface.get_position(edge[0]), edge[0], 
                                                     m_surface.get_position(edge[1]), edge[1],
                                                     m_surface.get_position(triangle[0]), triangle[0], 
                                                     m_surface.get_position(triangle[1]), triangle[1],
@@ -1957,7 +2343,7 @@ void CollisionPipeline::assert_predicted_mesh_is_intersection_free( bool degener
           std::cout << "-----\n edge-triangle check using new m_positions" << std::endl;
         }
         
-        result = segment_triangle_intersection(m_surface.get_newposition(edge[0]), edge[0], 
+        result = segment_triangle_intersection(m_surface.m_ccd_backend, m_surface.get_newposition(edge[0]), edge[0], 
                                                m_surface.get_newposition(edge[1]), edge[1],
                                                m_surface.get_newposition(triangle[0]), triangle[0], 
                                                m_surface.get_newposition(triangle[1]), triangle[1],
@@ -2001,27 +2387,27 @@ void CollisionPipeline::assert_predicted_mesh_is_intersection_free( bool degener
         
         if(m_surface.m_verbose) std::cout << "-----" << std::endl;
         
-        assert( !segment_segment_collision(ea, ea_new, edge[0], eb, eb_new, edge[1], 
+        assert( !segment_segment_collision(m_surface.m_ccd_backend, ea, ea_new, edge[0], eb, eb_new, edge[1], 
                                            ta, ta_new, triangle[0], tb, tb_new, triangle[1] ) );
         
         if(m_surface.m_verbose) std::cout << "-----" << std::endl;
         
-        assert( !segment_segment_collision(ea, ea_new, edge[0], eb, eb_new, edge[1], 
+        assert( !segment_segment_collision(m_surface.m_ccd_backend, ea, ea_new, edge[0], eb, eb_new, edge[1], 
                                            tb, tb_new, triangle[1], tc, tc_new, triangle[2] ) );
         
         if(m_surface.m_verbose) std::cout << "-----" << std::endl;
         
-        assert( !segment_segment_collision(ea, ea_new, edge[0], eb, eb_new, edge[1], 
+        assert( !segment_segment_collision(m_surface.m_ccd_backend, ea, ea_new, edge[0], eb, eb_new, edge[1], 
                                            ta, ta_new, triangle[0], tc, tc_new, triangle[2] ) );
         
         if(m_surface.m_verbose) std::cout << "-----" << std::endl;
         
-        assert( !point_triangle_collision(ea, ea_new, edge[0], ta, ta_new, triangle[0], 
+        assert( !point_triangle_collision(m_surface.m_ccd_backend, ea, ea_new, edge[0], ta, ta_new, triangle[0], 
                                           tb, tb_new, triangle[1], tc, tc_new, triangle[2] ) );
         
         if(m_surface.m_verbose) std::cout << "-----" << std::endl;
         
-        assert( !point_triangle_collision(eb, eb_new, edge[1], ta, ta_new, triangle[0], 
+        assert( !point_triangle_collision(m_surface.m_ccd_backend, eb, eb_new, edge[1], ta, ta_new, triangle[0], 
                                           tb, tb_new, triangle[1], tc, tc_new, triangle[2] ) );
         
         //m_surface.m_verbose = false;
@@ -12,10 +12,12 @@
 
 #include <deque>
 #include "options.h"
+#include "../common/ccd_wrapper.h"
 #include "../common/vec.h"
 
 
-bool check_edge_triangle_intersection_by_index(size_t edge_a, 
+bool check_edge_triangle_intersection_by_index(CCDBackendType backend,
+                                               size_t edge_a, 
                                                size_t edge_b, 
                                                size_t triangle_a, 
                                                size_t triangle_b, 
@@ -23,7 +25,8 @@ bool check_edge_triangle_intersection_by_index(size_t edge_a,
                                                const std::vector<Vec3d>& m_positions, 
                                                bool verbose );
 
-inline bool check_triangle_triangle_intersection(Vec3st triangle_a, 
+inline bool check_triangle_triangle_intersection(CCDBackendType backend,
+                                                 Vec3st triangle_a, 
                                                  Vec3st triangle_b, 
                                                  const std::vector<Vec3d>& positions );
 
@@ -135,6 +138,49 @@ struct ProcessCollisionStatus
 };
 
 
+// --------------------------------------------------------
+///
+/// A hypothetical motion used to check a mesh operation: the listed vertices move from their current positions to new
+/// positions, and every other vertex stays where it is.  Testing a pseudo motion reads the surface but doesn't write its
+/// predicted positions or update its broad phase, so several can be tested at once.
+///
+// --------------------------------------------------------
+
+class PseudoMotion
+{
+
+public:
+
+    explicit PseudoMotion( const std::vector<Vec3d>& positions ) :
+        m_positions( positions ),
+        m_moving_vertices(),
+        m_new_positions()
+    {}
+
+    /// Move the given vertex to new_position
+    ///
+    void move_vertex( size_t vertex_index, const Vec3d& new_position )
+    {
+        m_moving_vertices.push_back( vertex_index );
+        m_new_positions.push_back( new_position );
+    }
+
+    /// Vertices which move
+    ///
+    const std::vector<size_t>& get_moving_vertices() const { return m_moving_vertices; }
+
+    /// Position of the given vertex at the end of the motion
+    ///
+    inline const Vec3d& get_newposition( size_t vertex_index ) const;
+
+private:
+
+    const std::vector<Vec3d>& m_positions;
+    std::vector<size_t> m_moving_vertices;
+    std::vector<Vec3d> m_new_positions;
+
+};
+
 // --------------------------------------------------------
 ///
 /// Encapsulates all collision detection and resolution.
@@ -171,7 +217,7 @@ public:
     
     /// Get collisions involving vertices in the impact zones
     /// 
-    bool detect_new_collisions( const std::vector<ImpactZone> impact_zones, 
+    bool detect_new_collisions( const std::vector<ImpactZone>& impact_zones, 
                                std::vector<Collision>& collisions );
     
     /// Get any collisions involving an edge and a triangle
@@ -207,10 +253,10 @@ public:
                            bool use_new_positions, 
                            std::vector<Intersection>& intersections );
     
-    /// Look for self-intersections, but stop when the first one is found
-    void get_first_intersection( bool degeneracy_counts_as_intersection, 
+    /// Look for self-intersections, but stop when the first one is found.  Returns false if there are none.
+    bool get_first_intersection( bool degeneracy_counts_as_intersection, 
                                 bool use_new_positions, 
-                                Intersection& intersections );
+                                Intersection& intersection );
     
     /// Fire an assert if the mesh contains a self-intersection. Uses m_positions as the vertex locations.
     void assert_mesh_is_intersection_free( bool degeneracy_counts_as_intersection );              
@@ -252,11 +298,27 @@ private:
                                  CollisionCandidateSet& collision_candidates );
     
     void add_point_update_candidates( size_t v, CollisionCandidateSet& collision_candidates );
-    
-    
-    bool detect_segment_segment_collision( const Vec3st& candidate, Collision& collision );
-    
-    bool detect_point_triangle_collision( const Vec3st& candidate, Collision& collision );
+
+    /// Add collision candidates for the moving vertices of a pseudo motion and all elements incident on them, with
+    /// each query AABB swept over the pseudo motion.  Safe to call from several threads at once.
+    ///
+    void add_pseudo_motion_candidates( const PseudoMotion& motion, CollisionCandidateSet& collision_candidates );
+
+    /// Predicted position of a vertex: from the pseudo motion if given, otherwise the surface's predicted position
+    ///
+    inline const Vec3d& get_newposition( size_t v, const PseudoMotion* motion ) const;
+
+    bool detect_segment_segment_collision( const Vec3st& candidate, Collision& collision, const PseudoMotion* motion = NULL ) const;
+
+    bool detect_point_triangle_collision( const Vec3st& candidate, Collision& collision, const PseudoMotion* motion = NULL ) const;
+
+    /// Run the batched coplanarity test on up to CCD_BATCH_WIDTH candidates.  Sets may_collide[i] to 0 if candidate i
+    /// certainly has no collision, so the full CCD test can be skipped.
+    ///
+    void cull_collision_candidates( const Vec3st* candidates,
+                                    size_t num_candidates,
+                                    unsigned char* may_collide,
+                                    const PseudoMotion* motion = NULL ) const;
     
     /// Test the candidates for proximity and apply impulses
     ///
@@ -282,7 +344,24 @@ private:
                                    std::vector<Collision>& collisions,
                                    ProcessCollisionStatus& status );
     
-    bool any_collision( CollisionCandidateSet& candidates, Collision& collision );
+    /// Shared implementation of get_intersections and get_first_intersection
+    ///
+    void find_intersections( bool degeneracy_counts_as_intersection, 
+                            bool use_new_positions, 
+                            bool stop_at_first,
+                            std::vector<Intersection>& intersections );
+    
+    /// Multithreaded version of test_collision_candidates.  Produces the same collisions, in the same order, as the 
+    /// serial version.
+    ///
+    void test_collision_candidates_parallel( CollisionCandidateSet& candidates,
+                                            std::vector<Collision>& collisions,
+                                            ProcessCollisionStatus& status );
+    
+    /// Returns true if any candidate collides.  If a pseudo motion is given, vertex trajectories are taken from it
+    /// instead of from the surface's predicted positions.
+    ///
+    bool any_collision( const CollisionCandidateSet& candidates, Collision& collision, const PseudoMotion* motion = NULL ) const;
     
     void dynamic_point_vs_solid_triangle_collisions( double dt,
                                                     bool collect_candidates,
@@ -300,7 +379,7 @@ private:
                                              ProcessCollisionStatus& status );
     
     DynamicSurface& m_surface;
-    BroadPhase& m_broad_phase;
+    BroadPhase* m_broad_phase;
     
     
     
@@ -356,6 +435,24 @@ inline bool Collision::same_vertices( const Collision& other ) const
     return ( found[0] && found[1] && found[2] && found[3] );
 }
 
+// --------------------------------------------------------
+///
+/// Position of the given vertex at the end of the pseudo motion.  Only a few vertices move, so a linear search is fine.
+///
+// --------------------------------------------------------
+
+inline const Vec3d& PseudoMotion::get_newposition( size_t vertex_index ) const
+{
+    for ( size_t i = 0; i < m_moving_vertices.size(); ++i )
+    {
+        if ( m_moving_vertices[i] == vertex_index )
+        {
+            return m_new_positions[i];
+        }
+    }
+    return m_positions[vertex_index];
+}
+
 
 // --------------------------------------------------------
 ///
@@ -364,7 +461,8 @@ inline bool Collision::same_vertices( const Collision& other ) const
 ///
 // --------------------------------------------------------
 
-inline bool check_triangle_triangle_intersection(Vec3st triangle_a, 
+inline bool check_triangle_triangle_intersection(CCDBackendType backend,
+                                                 Vec3st triangle_a, 
                                                  Vec3st triangle_b, 
                                                  const std::vector<Vec3d>& positions )
 {
@@ -373,42 +471,42 @@ inline bool check_triangle_triangle_intersection(Vec3st triangle_a,
         return false; 
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_a[0], triangle_a[1], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_a[0], triangle_a[1], 
                                                    triangle_b[0], triangle_b[1], triangle_b[2], 
                                                    positions, false ) )
     {
         return true;
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_a[1], triangle_a[2], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_a[1], triangle_a[2], 
                                                    triangle_b[0], triangle_b[1], triangle_b[2], 
                                                    positions, false ) )
     {
         return true;
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_a[2], triangle_a[0], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_a[2], triangle_a[0], 
                                                    triangle_b[0], triangle_b[1], triangle_b[2], 
                                                    positions, false ) )
     {
         return true;
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_b[0], triangle_b[1], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_b[0], triangle_b[1], 
                                                    triangle_a[0], triangle_a[1], triangle_a[2], 
                                                    positions, false ) )
     {
         return true;
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_b[1], triangle_b[2], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_b[1], triangle_b[2], 
                                                    triangle_a[0], triangle_a[1], triangle_a[2], 
                                                    positions, false ) )
     {
         return true;
     }
     
-    if ( check_edge_triangle_intersection_by_index( triangle_b[2], triangle_b[0], 
+    if ( check_edge_triangle_intersection_by_index( backend, triangle_b[2], triangle_b[0], 
                                                    triangle_a[0], triangle_a[1], triangle_a[2], 
                                                    positions, false ) )
     {
@@ -13,6 +13,8 @@
 
 #include "dynamicsurface.h"
 
+#include <algorithm>
+#include "broadphasebvh.h"
 #include "broadphasegrid.h"
 #include <cassert>
 #include "../common/ccd_wrapper.h"
@@ -32,6 +34,9 @@
 // Local constants, typedefs, macros
 // ---------------------------------------------------------
 
+// Fewest elements for which commit_broad_phase_updates computes bounds in parallel
+static const size_t PARALLEL_BROAD_PHASE_UPDATE_MIN_ELEMENTS = 1024;
+
 // ---------------------------------------------------------
 //  Extern globals
 // ---------------------------------------------------------
@@ -65,10 +70,17 @@ DynamicSurface::DynamicSurface( const std::vector<Vec3d>& vertex_positions,
     m_mesh(), 
     m_broad_phase( new BroadPhaseGrid() ),
     m_collision_pipeline( *this, *m_broad_phase, in_friction_coefficient ),    // allocated and initialized in the constructor body
+    m_impact_zone_solver_stats(),
     m_aabb_padding( max( in_proximity_epsilon, 1e-4 ) ),
+    m_num_threads( 1 ),
+    m_incremental_broad_phase( false ),
+    m_ccd_backend( default_ccd_backend() ),
     pm_positions(vertex_positions), 
     pm_newpositions(vertex_positions),
-    m_velocities(0)
+    m_velocities(0),
+    m_broad_phase_moved_vertices(0),
+    m_broad_phase_update_depth(0),
+    m_deferred_broad_phase_vertices(0)
 {
     
     if ( m_verbose )
@@ -222,7 +234,7 @@ void DynamicSurface::partition_surfaces( std::vector<size_t>& surface_ids, std::
             surface_ids[vertex_index] = curr_surface;
             surface_vertices.push_back( vertex_index );
             
-            const std::vector<size_t>& incident_edges = m_mesh.m_vertex_to_edge_map[vertex_index];
+            const VertexAdjacencyList& incident_edges = m_mesh.m_vertex_to_edge_map[vertex_index];
             
             for( size_t i = 0; i < incident_edges.size(); ++i )
             {
@@ -257,7 +269,7 @@ void DynamicSurface::partition_surfaces( std::vector<size_t>& surface_ids, std::
         
         assert( surface_ids[i] != UNASSIGNED );
         
-        const std::vector<size_t>& incident_edges = m_mesh.m_vertex_to_edge_map[i];    
+        const VertexAdjacencyList& incident_edges = m_mesh.m_vertex_to_edge_map[i];    
         for( size_t j = 0; j < incident_edges.size(); ++j )
         {
             size_t adjacent_vertex = m_mesh.m_edges[ incident_edges[j] ][0];
@@ -297,7 +309,7 @@ unsigned int DynamicSurface::classify_vertex( size_t v ) const
 {     
     if ( m_mesh.m_vertex_to_triangle_map[v].empty() )     { return 0; }
     
-    const std::vector<size_t>& incident_triangles = m_mesh.m_vertex_to_triangle_map[v];
+    const VertexAdjacencyList& incident_triangles = m_mesh.m_vertex_to_triangle_map[v];
     
     
     Mat33d A(0,0,0,0,0,0,0,0,0);
@@ -379,6 +391,11 @@ void DynamicSurface::integrate( double desired_dt, double& actual_dt )
         std::cout << "---------------------- El Topo: integration and collision handling --------------------" << std::endl;
     }
     
+    if ( m_verbose && m_ccd_backend == CCD_BACKEND_ROOT_PARITY )
+    {
+        reset_root_parity_prefilter_counts();
+    }
+    
     double curr_dt = desired_dt;
     bool success = false;
         
@@ -389,9 +406,8 @@ void DynamicSurface::integrate( double desired_dt, double& actual_dt )
         
         if ( m_collision_safety )
         {        
-            std::vector<Intersection> intersections;
-            m_collision_pipeline.get_intersections( DEGEN_DOES_NOT_COUNT, false, intersections );
-            if ( !intersections.empty() )
+            Intersection intersection( 0, 0 );
+            if ( m_collision_pipeline.get_first_intersection( DEGEN_DOES_NOT_COUNT, false, intersection ) )
             {
               if(m_verbose)
               {
@@ -450,20 +466,21 @@ void DynamicSurface::integrate( double desired_dt, double& actual_dt )
                 // back up and try again:
                 
                 curr_dt = 0.5 * curr_dt;
+                begin_broad_phase_updates();
                 for ( size_t i = 0; i < get_num_vertices(); ++i )
                 {
                     set_newposition(i, get_position(i) + 0.5 * (saved_predicted_positions[i] - get_position(i)) ) ;
                 }
+                commit_broad_phase_updates();
                 
                 continue;      
             }
             
             
             // verify intersection-free predicted mesh
-            std::vector<Intersection> intersections;
-            m_collision_pipeline.get_intersections( DEGEN_DOES_NOT_COUNT, USE_NEW_POSITIONS, intersections );
+            Intersection intersection( 0, 0 );
             
-            if ( !intersections.empty() )
+            if ( m_collision_pipeline.get_first_intersection( DEGEN_DOES_NOT_COUNT, USE_NEW_POSITIONS, intersection ) )
             {
               if(m_verbose)
               {
@@ -552,10 +569,12 @@ void DynamicSurface::integrate( double desired_dt, double& actual_dt )
                 // back up and try again:
                 
                 curr_dt = 0.5 * curr_dt;
+                begin_broad_phase_updates();
                 for ( size_t i = 0; i < get_num_vertices(); ++i )
                 {
                     set_newposition( i, get_position(i) + 0.5 * ( saved_predicted_positions[i] - get_position(i) ) );
                 }
+                commit_broad_phase_updates();
                 
                 continue;      
                 
@@ -577,11 +596,45 @@ void DynamicSurface::integrate( double desired_dt, double& actual_dt )
         
     }
     
+    if ( m_verbose && m_ccd_backend == CCD_BACKEND_ROOT_PARITY )
+    {
+        size_t num_queries, num_culled;
+        get_root_parity_prefilter_counts( num_queries, num_culled );
+        std::cout << "root parity prefilter culled " << num_culled << " of " << num_queries << " CCD queries" << std::endl;
+    }
+    
     static unsigned int step = 0;
     ++step;
     
 }
 
+// ---------------------------------------------------------
+///
+/// Replace the broad phase object with a new one of the specified type, and build it using m_positions.
+///
+// ---------------------------------------------------------
+
+void DynamicSurface::set_broad_phase_type( BroadPhaseType type )
+{
+    delete m_broad_phase;
+    
+    switch ( type )
+    {
+        case BROAD_PHASE_BVH:
+            m_broad_phase = new BroadPhaseBVH();
+            break;
+        case BROAD_PHASE_GRID:
+        default:
+            m_broad_phase = new BroadPhaseGrid();
+            break;
+    }
+    
+    m_collision_pipeline.m_broad_phase = m_broad_phase;
+    
+    rebuild_static_broad_phase();
+}
+
+
 // ---------------------------------------------------------
 ///
 /// Construct static acceleration structure
@@ -592,6 +645,7 @@ void DynamicSurface::rebuild_static_broad_phase()
 {
     assert( m_collision_safety );
     m_broad_phase->update_broad_phase( *this, false );
+    m_broad_phase_moved_vertices.clear();
 }
 
 // ---------------------------------------------------------
@@ -604,6 +658,29 @@ void DynamicSurface::rebuild_continuous_broad_phase()
 {
     assert( m_collision_safety );
     m_broad_phase->update_broad_phase( *this, true );
+    m_broad_phase_moved_vertices.clear();
+}
+
+// ---------------------------------------------------------
+///
+/// Update continuous acceleration structure after bulk position changes
+///
+// ---------------------------------------------------------
+
+void DynamicSurface::refresh_continuous_broad_phase()
+{
+    assert( m_collision_safety );
+    
+    if ( m_incremental_broad_phase )
+    {
+        m_broad_phase->update_broad_phase_incremental( *this, true, m_broad_phase_moved_vertices );
+    }
+    else
+    {
+        m_broad_phase->update_broad_phase( *this, true );
+    }
+    
+    m_broad_phase_moved_vertices.clear();
 }
 
 
@@ -615,8 +692,8 @@ void DynamicSurface::rebuild_continuous_broad_phase()
 
 void DynamicSurface::update_static_broad_phase( size_t vertex_index )
 {
-    const std::vector<size_t>& incident_tris = m_mesh.m_vertex_to_triangle_map[ vertex_index ];
-    const std::vector<size_t>& incident_edges = m_mesh.m_vertex_to_edge_map[ vertex_index ];
+    const VertexAdjacencyList& incident_tris = m_mesh.m_vertex_to_triangle_map[ vertex_index ];
+    const VertexAdjacencyList& incident_edges = m_mesh.m_vertex_to_edge_map[ vertex_index ];
     
     Vec3d low, high;
     vertex_static_bounds( vertex_index, low, high );
@@ -647,8 +724,8 @@ void DynamicSurface::update_continuous_broad_phase( size_t vertex_index )
 {
     assert( m_collision_safety );
     
-    const std::vector<size_t>& incident_tris = m_mesh.m_vertex_to_triangle_map[ vertex_index ];
-    const std::vector<size_t>& incident_edges = m_mesh.m_vertex_to_edge_map[ vertex_index ];
+    const VertexAdjacencyList& incident_tris = m_mesh.m_vertex_to_triangle_map[ vertex_index ];
+    const VertexAdjacencyList& incident_edges = m_mesh.m_vertex_to_edge_map[ vertex_index ];
     
     Vec3d low, high;
     vertex_continuous_bounds( vertex_index, low, high );
@@ -668,6 +745,100 @@ void DynamicSurface::update_continuous_broad_phase( size_t vertex_index )
 }
 
 
+// ---------------------------------------------------------
+///
+/// Start deferring continuous broad phase updates
+///
+// ---------------------------------------------------------
+
+void DynamicSurface::begin_broad_phase_updates( )
+{
+    ++m_broad_phase_update_depth;
+}
+
+// ---------------------------------------------------------
+///
+/// Close an update scope.  When the outermost scope closes, update every element incident on a vertex moved inside it.
+///
+// ---------------------------------------------------------
+
+void DynamicSurface::commit_broad_phase_updates( )
+{
+    assert( m_broad_phase_update_depth > 0 );
+    
+    if ( --m_broad_phase_update_depth > 0 ) { return; }
+    
+    if ( !m_collision_safety || m_deferred_broad_phase_vertices.empty() )
+    {
+        m_deferred_broad_phase_vertices.clear();
+        return;
+    }
+    
+    std::vector<size_t>& vertices = m_deferred_broad_phase_vertices;
+    std::vector<size_t> triangles, edges;
+    
+    std::sort( vertices.begin(), vertices.end() );
+    vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+    
+    for ( size_t i = 0; i < vertices.size(); ++i )
+    {
+        const VertexAdjacencyList& incident_tris = m_mesh.m_vertex_to_triangle_map[ vertices[i] ];
+        const VertexAdjacencyList& incident_edges = m_mesh.m_vertex_to_edge_map[ vertices[i] ];
+        triangles.insert( triangles.end(), incident_tris.begin(), incident_tris.end() );
+        edges.insert( edges.end(), incident_edges.begin(), incident_edges.end() );
+    }
+    
+    std::sort( triangles.begin(), triangles.end() );
+    triangles.erase( std::unique( triangles.begin(), triangles.end() ), triangles.end() );
+    std::sort( edges.begin(), edges.end() );
+    edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+    
+    // compute the bounds, in parallel if there are enough of them, then update the broad phase serially
+    
+    const size_t num_vertices = vertices.size();
+    const size_t num_triangles = triangles.size();
+    const size_t num_elements = num_vertices + num_triangles + edges.size();
+    
+    std::vector<Vec3d> lows( num_elements ), highs( num_elements );
+    
+    #pragma omp parallel for schedule(static) num_threads(m_num_threads) if(num_elements >= PARALLEL_BROAD_PHASE_UPDATE_MIN_ELEMENTS)
+    for ( int i = 0; i < (int) num_elements; ++i )
+    {
+        if ( (size_t) i < num_vertices )
+        {
+            vertex_continuous_bounds( vertices[i], lows[i], highs[i] );
+        }
+        else if ( (size_t) i < num_vertices + num_triangles )
+        {
+            triangle_continuous_bounds( triangles[i - num_vertices], lows[i], highs[i] );
+        }
+        else
+        {
+            edge_continuous_bounds( edges[i - num_vertices - num_triangles], lows[i], highs[i] );
+        }
+    }
+    
+    for ( size_t i = 0; i < num_vertices; ++i )
+    {
+        m_broad_phase->update_vertex( vertices[i], lows[i], highs[i], vertex_is_solid(vertices[i]) );
+    }
+    
+    for ( size_t i = 0; i < num_triangles; ++i )
+    {
+        size_t j = num_vertices + i;
+        m_broad_phase->update_triangle( triangles[i], lows[j], highs[j], triangle_is_solid(triangles[i]) );
+    }
+    
+    for ( size_t i = 0; i < edges.size(); ++i )
+    {
+        size_t j = num_vertices + num_triangles + i;
+        m_broad_phase->update_edge( edges[i], lows[j], highs[j], edge_is_solid(edges[i]) );
+    }
+    
+    vertices.clear();
+}
+
+
 // ---------------------------------------------------------
 ///
 /// Compute the (padded) AABB of a vertex
@@ -1237,13 +1408,13 @@ void DynamicSurface::check_continuous_broad_phase_is_up_to_date() const
                 std::cout << "query_overlaps_broadphase_aabb: " << query_overlaps_broadphase_aabb << std::endl;
                 
                 
-                BroadPhaseGrid* grid_bf = static_cast<BroadPhaseGrid*>(m_broad_phase);
+                BroadPhaseGrid* grid_bf = dynamic_cast<BroadPhaseGrid*>(m_broad_phase);
                 
-                const std::vector<Vec3st>& cells = grid_bf->m_dynamic_vertex_grid.m_elementidxs[ brute_force_overlapping_vertices[k] ];
-                std::cout << "cells: " << std::endl;
-                for ( size_t m = 0; m < cells.size(); ++m )
+                if ( grid_bf )
                 {
-                    std::cout << cells[m] << std::endl;
+                    Vec3i cells_low, cells_high;
+                    grid_bf->m_dynamic_vertex_grid.boundstoindices( lo, hi, cells_low, cells_high );
+                    std::cout << "cells: " << cells_low << " - " << cells_high << std::endl;
                 }
                 
             }
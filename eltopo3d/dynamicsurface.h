@@ -18,8 +18,10 @@
 // Nested includes
 // ---------------------------------------------------------
 
+#include "../common/ccd_wrapper.h"
 #include "broadphase.h"
 #include "collisionpipeline.h"
+#include "impactzonesolver.h"
 #include "nondestructivetrimesh.h"
 #include <limits>
 
@@ -150,17 +152,31 @@ public:
     // ---------------------------------------------------------
     // Broadphase
     
+    /// Replace the broad phase object with a new one of the specified type, and build it using m_positions.
+    void set_broad_phase_type( BroadPhaseType type );
+    
     /// Delete and rebuild the broad phase object, using AABBs defined from m_positions.
     void rebuild_static_broad_phase( );
     
     /// Delete and rebuild the broad phase object, using AABBs defined from m_positions and m_newpositions.
     void rebuild_continuous_broad_phase( );
     
+    /// Bring the continuous broad phase up to date after the bulk position setters.  If m_incremental_broad_phase is set, 
+    /// only the vertices recorded in m_broad_phase_moved_vertices (and their incident elements) are updated.
+    void refresh_continuous_broad_phase( );
+    
     /// Assume that the specified vertex has moved.  Update the broadphase entries of the vertex, its incident edges and incident 
     /// triangles.
     void update_static_broad_phase( size_t vertex_index );
     void update_continuous_broad_phase( size_t vertex_index );  
     
+    /// Defer the continuous broad phase updates made by set_position and set_newposition until the matching 
+    /// commit_broad_phase_updates.  Scopes may nest, and the updates are made when the outermost one commits.  Each 
+    /// element incident on a moved vertex is updated once, however many of its vertices moved.  The broad phase must not 
+    /// be queried about the moved vertices before the commit.
+    void begin_broad_phase_updates( );
+    void commit_broad_phase_updates( );
+    
     /// Get the AABB of the specified vertex, edge, or triangle, using m_positions.
     void vertex_static_bounds(size_t v, Vec3d &xmin, Vec3d &xmax) const;
     void edge_static_bounds(size_t e, Vec3d &xmin, Vec3d &xmax) const;
@@ -180,13 +196,21 @@ public:
     const std::vector<Vec3d>& get_positions( ) const;
     void set_position( size_t index, const Vec3d& x );       
     void set_all_positions( const std::vector<Vec3d>& xs );
-    void set_all_positions( size_t n, const double* xs );
+    
+    /// Read positions straight from a caller-owned array of n points, where point i is (xs[i*stride], xs[i*stride+1], 
+    /// xs[i*stride+2]), so the array must hold at least stride*(n-1)+3 doubles.  No intermediate vector is built.
+    ///
+    void set_all_positions( size_t n, const double* xs, size_t stride = 3 );
+    
+    /// Write current positions into a caller-owned array laid out as above, with n = get_positions().size()
+    ///
+    void get_all_positions( double* xs, size_t stride = 3 ) const;
     
     const Vec3d& get_newposition( size_t index ) const;
     const std::vector<Vec3d>& get_newpositions( ) const;
     void set_newposition( size_t index, const Vec3d& x );   
     void set_all_newpositions( const std::vector<Vec3d>& xs );
-    void set_all_newpositions( size_t n, const double* xs );
+    void set_all_newpositions( size_t n, const double* xs, size_t stride = 3 );
     
     inline void set_positions_to_newpositions();
     
@@ -214,9 +238,22 @@ public:
     /// Encapsulates the collision detection functionality
     CollisionPipeline m_collision_pipeline;
     
+    /// Solver choices and timings of the inelastic impact zone solver
+    ImpactZoneSolverStats m_impact_zone_solver_stats;
+    
     /// Amount to pad AABBs by when doing broad-phase collision detection
     double m_aabb_padding;
     
+    /// Number of threads used by the parallelizable stages of collision detection.  1 means run serially.
+    unsigned int m_num_threads;
+    
+    /// Update the broad phase incrementally when positions are set in bulk, instead of rebuilding it
+    bool m_incremental_broad_phase;
+    
+    /// Which implementation of the continuous collision and intersection queries to use
+    CCDBackendType m_ccd_backend;
+    
+    
 protected:
     
     friend class CollisionPipeline;
@@ -228,6 +265,20 @@ protected:
     // Temporary velocities field
     std::vector<Vec3d> m_velocities;
     
+    /// Vertices whose positions or predicted positions have changed since the broad phase was last refreshed
+    std::vector<size_t> m_broad_phase_moved_vertices;
+    
+    /// Number of open begin_broad_phase_updates scopes, and the vertices moved inside them
+    unsigned int m_broad_phase_update_depth;
+    std::vector<size_t> m_deferred_broad_phase_vertices;
+    
+    /// Update the continuous broad phase entry of a moved vertex and its incident elements, now or at the end of the 
+    /// current update scope
+    inline void vertex_moved( size_t vertex_index );
+    
+    /// Record vertices whose entries differ between the two arrays in m_broad_phase_moved_vertices
+    inline void mark_moved_vertices( const std::vector<Vec3d>& old_xs, const std::vector<Vec3d>& new_xs );
+    
 };
 
 
@@ -395,7 +446,7 @@ inline Vec3d DynamicSurface::get_vertex_normal( size_t vertex ) const
 
 inline Vec3d DynamicSurface::get_vertex_normal_max( size_t vertex_index ) const
 {
-    const std::vector<size_t>& inc_tris = m_mesh.m_vertex_to_triangle_map[vertex_index];
+    const VertexAdjacencyList& inc_tris = m_mesh.m_vertex_to_triangle_map[vertex_index];
     
     Vec3d sum_cross_products(0,0,0);
     
@@ -630,7 +681,7 @@ inline void DynamicSurface::set_position( size_t index, const Vec3d& x )
     // update broad phase
     if ( m_collision_safety )
     {
-        update_continuous_broad_phase( index );
+        vertex_moved( index );
     }
 }
 
@@ -638,34 +689,56 @@ inline void DynamicSurface::set_position( size_t index, const Vec3d& x )
 
 inline void DynamicSurface::set_all_positions( const std::vector<Vec3d>& xs )
 {
-    pm_positions = xs;
-    pm_newpositions = xs;
-    
-    // update broad phase
-    if ( m_collision_safety )
-    {
-        rebuild_continuous_broad_phase();
-    }
+    set_all_positions( xs.size(), xs.empty() ? NULL : xs[0].v, 3 );
 }
 
 // --------------------------------------------------------
 
-inline void DynamicSurface::set_all_positions( size_t n, const double* xs )
+inline void DynamicSurface::set_all_positions( size_t n, const double* xs, size_t stride )
 {
-    pm_positions.resize(n);
+    assert( stride >= 3 );
+    
+    const bool track_moved = m_collision_safety && m_incremental_broad_phase;
+    const size_t old_num_positions = pm_positions.size();
+    const size_t old_num_newpositions = pm_newpositions.size();
+    
+    pm_positions.resize( n );
+    pm_newpositions.resize( n );
+    
     for ( size_t i = 0; i < n; ++i )
     {
-        pm_positions[i][0] = xs[3*i+0];
-        pm_positions[i][1] = xs[3*i+1];
-        pm_positions[i][2] = xs[3*i+2];
+        const double* x = xs + i * stride;
+        const Vec3d new_x( x[0], x[1], x[2] );
+        
+        if ( track_moved && ( i >= old_num_positions || i >= old_num_newpositions || 
+                              pm_positions[i] != new_x || pm_newpositions[i] != new_x ) )
+        {
+            m_broad_phase_moved_vertices.push_back( i );
+        }
+        
+        pm_positions[i] = new_x;
+        pm_newpositions[i] = new_x;
     }
     
-    pm_newpositions = pm_positions;
-    
     // update broad phase
     if ( m_collision_safety )
     {
-        rebuild_continuous_broad_phase();
+        refresh_continuous_broad_phase();
+    }
+}
+
+// --------------------------------------------------------
+
+inline void DynamicSurface::get_all_positions( double* xs, size_t stride ) const
+{
+    assert( stride >= 3 );
+    
+    for ( size_t i = 0; i < pm_positions.size(); ++i )
+    {
+        double* x = xs + i * stride;
+        x[0] = pm_positions[i][0];
+        x[1] = pm_positions[i][1];
+        x[2] = pm_positions[i][2];
     }
 }
 
@@ -673,11 +746,16 @@ inline void DynamicSurface::set_all_positions( size_t n, const double* xs )
 
 inline void DynamicSurface::set_positions_to_newpositions()
 {
+    if ( m_collision_safety && m_incremental_broad_phase )
+    {
+        mark_moved_vertices( pm_positions, pm_newpositions );
+    }
+    
     pm_positions = pm_newpositions;
     
     if ( m_collision_safety )
     {
-        rebuild_continuous_broad_phase();
+        refresh_continuous_broad_phase();
     }
 }
 
@@ -700,40 +778,60 @@ inline void DynamicSurface::set_newposition( size_t index, const Vec3d& x )
     // update broad phase
     if ( m_collision_safety )
     {
-        update_continuous_broad_phase( index );
+        vertex_moved( index );
     }
     
 }
 
 // --------------------------------------------------------
 
-inline void DynamicSurface::set_all_newpositions( const std::vector<Vec3d>& xs )
+inline void DynamicSurface::vertex_moved( size_t index )
 {
-    pm_newpositions = xs;
-    
-    // update broad phase
-    if ( m_collision_safety )
+    if ( m_broad_phase_update_depth > 0 )
     {
-        rebuild_continuous_broad_phase();
+        m_deferred_broad_phase_vertices.push_back( index );
+    }
+    else
+    {
+        update_continuous_broad_phase( index );
     }
 }
 
 // --------------------------------------------------------
 
-inline void DynamicSurface::set_all_newpositions( size_t n, const double* xs )
+inline void DynamicSurface::set_all_newpositions( const std::vector<Vec3d>& xs )
 {
-    pm_newpositions.resize(n);
+    set_all_newpositions( xs.size(), xs.empty() ? NULL : xs[0].v, 3 );
+}
+
+// --------------------------------------------------------
+
+inline void DynamicSurface::set_all_newpositions( size_t n, const double* xs, size_t stride )
+{
+    assert( stride >= 3 );
+    
+    const bool track_moved = m_collision_safety && m_incremental_broad_phase;
+    const size_t old_num_newpositions = pm_newpositions.size();
+    
+    pm_newpositions.resize( n );
+    
     for ( size_t i = 0; i < n; ++i )
     {
-        pm_newpositions[i][0] = xs[3*i+0];
-        pm_newpositions[i][1] = xs[3*i+1];
-        pm_newpositions[i][2] = xs[3*i+2];
+        const double* x = xs + i * stride;
+        const Vec3d new_x( x[0], x[1], x[2] );
+        
+        if ( track_moved && ( i >= old_num_newpositions || pm_newpositions[i] != new_x ) )
+        {
+            m_broad_phase_moved_vertices.push_back( i );
+        }
+        
+        pm_newpositions[i] = new_x;
     }
     
     // update broad phase
     if ( m_collision_safety )
     {
-        rebuild_continuous_broad_phase();
+        refresh_continuous_broad_phase();
     }
 }
 
@@ -744,6 +842,19 @@ inline const std::vector<Vec3d>& DynamicSurface::get_newpositions( ) const
     return pm_newpositions;
 }
 
+// --------------------------------------------------------
+
+inline void DynamicSurface::mark_moved_vertices( const std::vector<Vec3d>& old_xs, const std::vector<Vec3d>& new_xs )
+{
+    for ( size_t i = 0; i < new_xs.size(); ++i )
+    {
+        if ( i >= old_xs.size() || old_xs[i] != new_xs[i] )
+        {
+            m_broad_phase_moved_vertices.push_back( i );
+        }
+    }
+}
+
 
 
 #endif
@@ -12,12 +12,60 @@
 #include "broadphase.h"
 #include "collisionpipeline.h"
 #include "../common/collisionqueries.h"
+#include "meshoperationscheduler.h"
 #include "nondestructivetrimesh.h"
 #include "../common/runstats.h"
 #include "subdivisionscheme.h"
 #include "surftrack.h"
 #include "trianglequality.h"
 #include <cstdio>
+#include <queue>
+
+
+// --------------------------------------------------------
+///
+/// A collapse which has passed its checks
+///
+// --------------------------------------------------------
+
+struct EdgeCollapser::CollapsePlan
+{
+    size_t m_edge;
+    size_t m_vertex_to_keep;
+    size_t m_vertex_to_delete;
+    Vec3d m_vertex_new_position;
+    
+    /// AABB of everything the collision checks looked at
+    Vec3d m_region_low, m_region_high;
+};
+
+
+namespace {
+
+// --------------------------------------------------------
+///
+/// Entry in the queue of edges to collapse.  When an edge changes, a new entry with a higher stamp is pushed, and the 
+/// old one is skipped when it comes off the queue.
+///
+// --------------------------------------------------------
+
+struct QueuedEdge
+{
+    size_t edge_index;
+    double edge_length;
+    unsigned int stamp;
+    
+    QueuedEdge( size_t ei, double el, unsigned int st ) : edge_index(ei), edge_length(el), stamp(st) {}
+    
+    /// std::priority_queue pops the largest element, so order by decreasing length.  Ties go to the lower edge index.
+    bool operator<( const QueuedEdge& other ) const
+    {
+        if ( edge_length != other.edge_length ) { return edge_length > other.edge_length; }
+        return edge_index > other.edge_index;
+    }
+};
+
+}
 
 // --------------------------------------------------------
 ///
@@ -117,39 +165,6 @@ void EdgeCollapser::get_moving_triangles( size_t source_vertex,
 }
 
 
-// --------------------------------------------------------
-///
-///
-///
-// --------------------------------------------------------
-
-void EdgeCollapser::get_moving_edges( size_t source_vertex, 
-                                     size_t destination_vertex, 
-                                     size_t,
-                                     std::vector<size_t>& moving_edges )
-{
-    
-    moving_edges = m_surf.m_mesh.m_vertex_to_edge_map[ source_vertex ];
-    moving_edges.insert( moving_edges.end(), m_surf.m_mesh.m_vertex_to_edge_map[ destination_vertex ].begin(), m_surf.m_mesh.m_vertex_to_edge_map[ destination_vertex ].end() );
-    
-    // Disregard collapsed edge
-    
-    //   for ( size_t i = 0; i < moving_edges.size(); ++i )
-    //   {
-    //      if ( moving_edges[i] == edge_index )
-    //      {
-    //         moving_edges.erase( moving_edges.begin() + i );
-    //         --i;
-    //      }
-    //   }
-    //   
-    //   std::sort( moving_edges.begin(), moving_edges.end() );
-    //   std::vector<size_t>::iterator new_end = std::unique(moving_edges.begin(), moving_edges.end());
-    //   moving_edges.erase(new_end, moving_edges.end());
-    
-}
-
-
 // --------------------------------------------------------
 ///
 /// Check the "pseudo motion" introduced by a collapsing edge for collision
@@ -158,44 +173,20 @@ void EdgeCollapser::get_moving_edges( size_t source_vertex,
 
 bool EdgeCollapser::collapse_edge_pseudo_motion_introduces_collision( size_t source_vertex, 
                                                                      size_t destination_vertex, 
-                                                                     size_t edge_index, 
-                                                                     const Vec3d& )
+                                                                     size_t, 
+                                                                     const Vec3d& vertex_new_position )
 {
     assert( m_surf.m_collision_safety );
     
-    //   if ( m_surf.m_collision_safety )
-    //   {
-    //      m_surf.check_continuous_broad_phase_is_up_to_date();
-    //   }
+    // Check for collisions, holding everything static except for the source and destination vertices.  The motion is 
+    // tested without setting predicted positions, so the surface and its broad phase aren't modified.
     
-    // Get the set of triangles which move because of this motion
-    std::vector<size_t> moving_triangles;
-    get_moving_triangles( source_vertex, destination_vertex, edge_index, moving_triangles );
-    
-    // And the set of edges
-    std::vector<size_t> moving_edges;
-    get_moving_edges( source_vertex, destination_vertex, edge_index, moving_edges );
-    
-    
-    // Check for collisions, holding everything static except for the source and destination vertices
+    PseudoMotion motion( m_surf.get_positions() );
+    motion.move_vertex( source_vertex, vertex_new_position );
+    motion.move_vertex( destination_vertex, vertex_new_position );
     
     CollisionCandidateSet collision_candidates;
-    
-    // triangle-point candidates
-    for ( size_t i = 0; i < moving_triangles.size(); ++i )
-    { 
-        m_surf.m_collision_pipeline.add_triangle_candidates( moving_triangles[i], true, true, collision_candidates );
-    }      
-    
-    // point-triangle candidates
-    m_surf.m_collision_pipeline.add_point_candidates( source_vertex, true, true, collision_candidates );
-    m_surf.m_collision_pipeline.add_point_candidates( destination_vertex, true, true, collision_candidates );
-    
-    // edge-edge candidates
-    for ( size_t i = 0; i < moving_edges.size(); ++i )
-    {
-        m_surf.m_collision_pipeline.add_edge_candidates( moving_edges[i], true, true, collision_candidates );
-    }
+    m_surf.m_collision_pipeline.add_pseudo_motion_candidates( motion, collision_candidates );
     
     // Prune collision candidates containing both the source and destination vertex (they will trivially be collisions )
     
@@ -244,7 +235,7 @@ bool EdgeCollapser::collapse_edge_pseudo_motion_introduces_collision( size_t sou
     }
     
     Collision collision;
-    if ( m_surf.m_collision_pipeline.any_collision( collision_candidates, collision ) )
+    if ( m_surf.m_collision_pipeline.any_collision( collision_candidates, collision, &motion ) )
     {
         return true;
     }
@@ -267,7 +258,7 @@ bool EdgeCollapser::collapse_edge_introduces_normal_inversion( size_t source_ver
 {
     
     // Get the set of triangles which are going to be deleted
-    std::vector< size_t >& triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge_index];   
+    const EdgeAdjacencyList& triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge_index];   
     
     // Get the set of triangles which move because of this motion
     std::vector<size_t> moving_triangles;
@@ -356,7 +347,7 @@ bool EdgeCollapser::collapse_edge_introduces_volume_change( size_t source_vertex
     // If any incident triangle has a tiny area, collapse the edge without regard to volume change
     //
     
-    const std::vector<size_t>& inc_tris = m_surf.m_mesh.m_edge_to_triangle_map[edge_index];
+    const EdgeAdjacencyList& inc_tris = m_surf.m_mesh.m_edge_to_triangle_map[edge_index];
     
     for ( size_t i = 0; i < inc_tris.size(); ++i )
     {
@@ -370,7 +361,7 @@ bool EdgeCollapser::collapse_edge_introduces_volume_change( size_t source_vertex
     // Check volume change
     //
     
-    const std::vector< size_t >& triangles_incident_to_vertex = m_surf.m_mesh.m_vertex_to_triangle_map[source_vertex];
+    const VertexAdjacencyList& triangles_incident_to_vertex = m_surf.m_mesh.m_vertex_to_triangle_map[source_vertex];
     double volume_change = 0;
     
     for ( size_t i = 0; i < triangles_incident_to_vertex.size(); ++i )
@@ -453,6 +444,26 @@ bool EdgeCollapser::collapse_edge_introduces_bad_angle( size_t source_vertex,
 // --------------------------------------------------------
 
 bool EdgeCollapser::collapse_edge( size_t edge )
+{
+    CollapsePlan plan;
+    
+    if ( !check_collapse( edge, plan ) )
+    {
+        return false;
+    }
+    
+    return apply_collapse( plan );
+}
+
+
+// --------------------------------------------------------
+///
+/// Check whether an edge can be collapsed, and decide which vertex to keep and where to put it.  Doesn't modify the 
+/// surface.
+///
+// --------------------------------------------------------
+
+bool EdgeCollapser::check_collapse( size_t edge, CollapsePlan& plan )
 {
     
     size_t vertex_to_keep = m_surf.m_mesh.m_edges[edge][0];
@@ -496,7 +507,7 @@ bool EdgeCollapser::collapse_edge( size_t edge )
         
         // Look for a vertex which is adjacent to both vertices on the edge, and which isn't on one of the incident triangles
         
-        const std::vector< size_t >& triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge];
+        const EdgeAdjacencyList& triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge];
         std::vector< size_t > third_vertices;
         
         for ( size_t i = 0; i < triangles_incident_to_edge.size(); ++i )
@@ -549,7 +560,7 @@ bool EdgeCollapser::collapse_edge( size_t edge )
     // --------------
     
     {
-        const std::vector< size_t >& r_triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge];
+        const EdgeAdjacencyList& r_triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge];
         
         // Do not collapse edge on a degenerate tet or degenerate triangle
         for ( size_t i=0; i < r_triangles_incident_to_edge.size(); ++i )
@@ -642,20 +653,11 @@ bool EdgeCollapser::collapse_edge( size_t edge )
     if ( mag ( m_surf.get_position(m_surf.m_mesh.m_edges[edge][1]) - m_surf.get_position(m_surf.m_mesh.m_edges[edge][0]) ) > 0 )
     {
         
-        // Change source vertex predicted position to superimpose onto dest vertex
-        m_surf.set_newposition( vertex_to_keep, vertex_new_position );
-        m_surf.set_newposition( vertex_to_delete, vertex_new_position );
-        
         bool volume_change = collapse_edge_introduces_volume_change( vertex_to_delete, edge, vertex_new_position );
         
         if ( volume_change )
         {
-            // Restore saved positions which were changed by the function we just called.
-            m_surf.set_newposition( vertex_to_keep, m_surf.get_position(vertex_to_keep) );
-            m_surf.set_newposition( vertex_to_delete, m_surf.get_position(vertex_to_delete) );
-            
             if ( m_surf.m_verbose ) { std::cout << "collapse_volume_change" << std::endl; }
-            
             return false;
         }
         
@@ -663,12 +665,7 @@ bool EdgeCollapser::collapse_edge( size_t edge )
         
         if ( normal_inversion )
         {
-            // Restore saved positions which were changed by the function we just called.
-            m_surf.set_newposition( vertex_to_keep, m_surf.get_position(vertex_to_keep) );
-            m_surf.set_newposition( vertex_to_delete, m_surf.get_position(vertex_to_delete) );
-            
             if ( m_surf.m_verbose ) { std::cout << "normal_inversion" << std::endl; }
-            
             return false;
         }
         
@@ -676,40 +673,60 @@ bool EdgeCollapser::collapse_edge( size_t edge )
         
         if ( bad_angle )
         {
-            // Restore saved positions which were changed by the function we just called.
-            m_surf.set_newposition( vertex_to_keep, m_surf.get_position(vertex_to_keep) );
-            m_surf.set_newposition( vertex_to_delete, m_surf.get_position(vertex_to_delete) );
-            
             if ( m_surf.m_verbose ) { std::cout << "bad_angle" << std::endl; }
-            
             return false;
-            
         }
         
-        bool collision = false;
-        
-        if ( m_surf.m_collision_safety )
+        if ( m_surf.m_collision_safety && collapse_edge_pseudo_motion_introduces_collision( vertex_to_delete, vertex_to_keep, edge, vertex_new_position ) )
         {
-            collision = collapse_edge_pseudo_motion_introduces_collision( vertex_to_delete, vertex_to_keep, edge, vertex_new_position );
-        }
-        
-        if ( collision ) 
-        { 
+            // edge collapse would introduce collision
             if ( m_surf.m_verbose ) { std::cout << "collision" << std::endl; }
+            return false;
         }
-        
-        // Restore saved positions which were changed by the function we just called.
-        m_surf.set_newposition( vertex_to_keep, m_surf.get_position(vertex_to_keep) );
-        m_surf.set_newposition( vertex_to_delete, m_surf.get_position(vertex_to_delete) );
-        
-        if ( collision )
+    }
+    
+    plan.m_edge = edge;
+    plan.m_vertex_to_keep = vertex_to_keep;
+    plan.m_vertex_to_delete = vertex_to_delete;
+    plan.m_vertex_new_position = vertex_new_position;
+    
+    // the collision checks only look at elements near the triangles incident on either vertex, swept to the new position
+    plan.m_region_low = plan.m_region_high = vertex_new_position;
+    
+    std::vector<size_t> adjacent_vertices;
+    for ( unsigned int i = 0; i < 2; ++i )
+    {
+        size_t v = m_surf.m_mesh.m_edges[edge][i];
+        update_minmax( m_surf.get_position(v), plan.m_region_low, plan.m_region_high );
+        m_surf.m_mesh.get_adjacent_vertices( v, adjacent_vertices );
+        for ( size_t j = 0; j < adjacent_vertices.size(); ++j )
         {
-            // edge collapse would introduce collision or change volume too much or invert triangle normals
-            return false;
+            update_minmax( m_surf.get_position(adjacent_vertices[j]), plan.m_region_low, plan.m_region_high );
         }
     }
     
-    std::vector<size_t> edges_incident_to_deleted_vertex = m_surf.m_mesh.m_vertex_to_edge_map[vertex_to_delete];
+    plan.m_region_low -= m_surf.m_aabb_padding * Vec3d(1,1,1);
+    plan.m_region_high += m_surf.m_aabb_padding * Vec3d(1,1,1);
+    
+    return true;
+    
+}
+
+
+// --------------------------------------------------------
+///
+/// Carry out a collapse which passed check_collapse, unless an observer vetoes it
+///
+// --------------------------------------------------------
+
+bool EdgeCollapser::apply_collapse( const CollapsePlan& plan )
+{
+    size_t edge = plan.m_edge;
+    size_t vertex_to_keep = plan.m_vertex_to_keep;
+    size_t vertex_to_delete = plan.m_vertex_to_delete;
+    const Vec3d& vertex_new_position = plan.m_vertex_new_position;
+    
+    std::vector<size_t> edges_incident_to_deleted_vertex( m_surf.m_mesh.m_vertex_to_edge_map[vertex_to_delete].begin(), m_surf.m_mesh.m_vertex_to_edge_map[vertex_to_delete].end() );
     
     PreEdgeCollapseInfo pre_info( edge, vertex_to_keep, vertex_to_delete, vertex_new_position );
     
@@ -726,12 +743,14 @@ bool EdgeCollapser::collapse_edge( size_t edge )
     
     // move the vertex we decided to keep
     
+    m_surf.begin_broad_phase_updates();
     m_surf.set_position( vertex_to_keep, vertex_new_position );
     m_surf.set_newposition( vertex_to_keep, vertex_new_position );
+    m_surf.commit_broad_phase_updates();
     
     
     // Copy this vector, don't take a reference, as deleting will change the original
-    std::vector< size_t > triangles_incident_to_edge = m_surf.m_mesh.m_edge_to_triangle_map[edge];
+    std::vector< size_t > triangles_incident_to_edge( m_surf.m_mesh.m_edge_to_triangle_map[edge].begin(), m_surf.m_mesh.m_edge_to_triangle_map[edge].end() );
     
     // Delete triangles incident on the edge
     
@@ -748,7 +767,7 @@ bool EdgeCollapser::collapse_edge( size_t edge )
     // Find anything pointing to the doomed vertex and change it
     
     // copy the list of triangles, don't take a refence to it
-    std::vector< size_t > triangles_incident_to_vertex = m_surf.m_mesh.m_vertex_to_triangle_map[vertex_to_delete];    
+    std::vector< size_t > triangles_incident_to_vertex( m_surf.m_mesh.m_vertex_to_triangle_map[vertex_to_delete].begin(), m_surf.m_mesh.m_vertex_to_triangle_map[vertex_to_delete].end() );    
     std::vector< size_t > new_triangles;
     
     for ( size_t i=0; i < triangles_incident_to_vertex.size(); ++i )
@@ -826,134 +845,328 @@ bool EdgeCollapser::edge_is_collapsible( size_t edge_index ) const
 
 // --------------------------------------------------------
 ///
-/// Collapse all short edges
+/// Get the length of the edge used to decide whether to collapse it
 ///
 // --------------------------------------------------------
 
-void EdgeCollapser::process_mesh()
+double EdgeCollapser::get_collapse_length( size_t edge ) const
 {
-    
-    if ( m_surf.m_verbose )
+    if ( m_use_curvature )
     {
-        std::cout << "\n\n\n---------------------- EdgeCollapser: collapsing ----------------------" << std::endl;
-        std::cout << "m_min_edge_length: " << m_min_edge_length;
-        std::cout << ", m_use_curvature: " << m_use_curvature;
-        std::cout << ", m_min_curvature_multiplier: " << m_min_curvature_multiplier << std::endl;
-        std::cout << "m_surf.m_collision_safety: " << m_surf.m_collision_safety << std::endl;
+        return get_curvature_scaled_length( m_surf, m_surf.m_mesh.m_edges[edge][0], m_surf.m_mesh.m_edges[edge][1], m_min_curvature_multiplier, 1e+30 );
     }
     
-    bool collapse_occurred = true;
-   
-    while ( collapse_occurred )
-    {
-        collapse_occurred = false;
+    return m_surf.get_edge_length(edge);
+}
+
+
+// --------------------------------------------------------
+///
+/// Collapse edges in rounds.  Each round takes, shortest first, the remaining edges whose collapses don't interfere with
+/// each other, checks them concurrently, then applies them shortest first.  Collapses which couldn't join the round, or 
+/// whose checked region overlaps a collapse applied earlier in the round, wait for the next round.
+///
+// --------------------------------------------------------
+
+bool EdgeCollapser::collapse_edges_in_parallel( const std::vector<size_t>& edges )
+{
+    NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
     
-        assert( m_surf.m_dirty_triangles.size() == 0 );
-        
-        std::vector<SortableEdge> sortable_edges_to_try;
+    MeshOperationScheduler scheduler;
+    bool collapse_occurred = false;
+    
+    std::vector<size_t> pending( edges );
+    std::vector<size_t> round_edges, round_slots, stencil, adjacent_vertices;
+    std::vector<CollapsePlan> plans;
+    std::vector<Vec3d> region_lows, region_highs;
+    
+    while ( !pending.empty() )
+    {
+        scheduler.begin_round( m_surf.get_num_vertices() );
         
+        // which pending edges to try again next round
+        std::vector<char> retry( pending.size(), 0 );
         
-        //
-        // get set of edges to collapse
-        //
+        round_edges.clear();
+        round_slots.clear();
         
-        for( size_t i = 0; i < m_surf.m_mesh.m_edges.size(); i++ )
-        {    
-            if ( m_surf.m_mesh.edge_is_deleted(i) )   { continue; }  // skip deleted edges
-            if ( m_surf.edge_is_solid(i) ) { continue; }             // skip solids
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            size_t e = pending[i];
             
-            if ( m_surf.m_mesh.m_edge_to_triangle_map[i].size() < 2 )  { continue; }  // skip boundary edges
+            // same filters as the serial loop in process_mesh
+            if ( m_mesh.edge_is_deleted(e) ) { continue; }
+            if ( get_collapse_length(e) >= m_min_edge_length ) { continue; }
+            if ( m_mesh.m_edges[e][0] == m_mesh.m_edges[e][1] )   { continue; }
+            if ( m_mesh.m_edge_to_triangle_map[e].size() < 2 )  { continue; }
+            if ( m_mesh.m_is_boundary_vertex[m_mesh.m_edges[e][0]] || m_mesh.m_is_boundary_vertex[m_mesh.m_edges[e][1]] ) { continue; }
             
-            if( m_surf.m_mesh.m_is_boundary_vertex[m_surf.m_mesh.m_edges[i][0]] || 
-               m_surf.m_mesh.m_is_boundary_vertex[m_surf.m_mesh.m_edges[i][1]] )
+            // the collapse replaces every triangle incident on either vertex
+            stencil.clear();
+            for ( unsigned int j = 0; j < 2; ++j )
             {
-                continue;
+                stencil.push_back( m_mesh.m_edges[e][j] );
+                m_mesh.get_adjacent_vertices( m_mesh.m_edges[e][j], adjacent_vertices );
+                stencil.insert( stencil.end(), adjacent_vertices.begin(), adjacent_vertices.end() );
             }
+            std::sort( stencil.begin(), stencil.end() );
+            stencil.erase( std::unique( stencil.begin(), stencil.end() ), stencil.end() );
             
-            double current_length;
-            
-            if ( m_use_curvature )
+            if ( scheduler.claim_stencil( m_mesh, stencil ) )
             {
-                current_length = get_curvature_scaled_length( m_surf, m_surf.m_mesh.m_edges[i][0], m_surf.m_mesh.m_edges[i][1], m_min_curvature_multiplier, 1e+30 );
+                round_edges.push_back( e );
+                round_slots.push_back( i );
             }
             else
             {
-                current_length = m_surf.get_edge_length(i);
+                retry[i] = 1;
             }
+        }
+        
+        // check the round concurrently
+        
+        plans.resize( round_edges.size() );
+        std::vector<char> plan_ok( round_edges.size(), 0 );
+        
+        #pragma omp parallel for schedule(dynamic) num_threads(m_surf.m_num_threads)
+        for ( int i = 0; i < (int) round_edges.size(); ++i )
+        {
+            plan_ok[i] = check_collapse( round_edges[i], plans[i] );
+        }
+        
+        // apply in order
+        
+        region_lows.clear();
+        region_highs.clear();
+        for ( size_t i = 0; i < plans.size(); ++i )
+        {
+            if ( !plan_ok[i] ) { continue; }
+            region_lows.push_back( plans[i].m_region_low );
+            region_highs.push_back( plans[i].m_region_high );
+        }
+        
+        scheduler.begin_apply( region_lows, region_highs );
+        
+        for ( size_t i = 0; i < plans.size(); ++i )
+        {
+            if ( !plan_ok[i] ) { continue; }
             
-            if ( current_length < m_min_edge_length )
+            if ( !scheduler.claim_region( plans[i].m_region_low, plans[i].m_region_high ) )
             {
-                sortable_edges_to_try.push_back( SortableEdge( i, current_length ) );
+                retry[ round_slots[i] ] = 1;
+                continue;
+            }
+            
+            if ( apply_collapse( plans[i] ) )
+            {
+                // clean up degenerate triangles and tets
+                m_surf.trim_non_manifold( m_surf.m_dirty_triangles );
+                collapse_occurred = true;
             }
         }
         
-        //
-        // sort in ascending order by length (collapse shortest edges first)
-        //
+        std::vector<size_t> next_pending;
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            if ( retry[i] ) { next_pending.push_back( pending[i] ); }
+        }
+        pending.swap( next_pending );
+    }
+    
+    return collapse_occurred;
+}
+
+
+// --------------------------------------------------------
+///
+/// Determine whether an edge is short enough to collapse and not excluded from collapsing, and get its length
+///
+// --------------------------------------------------------
+
+bool EdgeCollapser::edge_is_collapse_candidate( size_t edge, double& edge_length ) const
+{
+    const NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
+    
+    if ( m_mesh.edge_is_deleted(edge) )   { return false; }  // skip deleted edges
+    if ( m_surf.edge_is_solid(edge) ) { return false; }       // skip solids
+    if ( m_mesh.m_edges[edge][0] == m_mesh.m_edges[edge][1] )   { return false; }    // skip degenerate edges
+    if ( m_mesh.m_edge_to_triangle_map[edge].size() < 2 )  { return false; }  // skip boundary edges
+    
+    if ( m_mesh.m_is_boundary_vertex[m_mesh.m_edges[edge][0]] || m_mesh.m_is_boundary_vertex[m_mesh.m_edges[edge][1]] )
+    {
+        return false;
+    }
+    
+    edge_length = get_collapse_length( edge );
+    
+    return ( edge_length < m_min_edge_length );
+}
+
+
+// --------------------------------------------------------
+///
+/// Get all collapse candidates, sorted in ascending order by length (collapse shortest edges first)
+///
+// --------------------------------------------------------
+
+void EdgeCollapser::get_sorted_collapse_candidates( std::vector<SortableEdge>& sortable_edges ) const
+{
+    sortable_edges.clear();
+    
+    for( size_t i = 0; i < m_surf.m_mesh.m_edges.size(); i++ )
+    {    
+        double current_length;
+        if ( edge_is_collapse_candidate( i, current_length ) )
+        {
+            sortable_edges.push_back( SortableEdge( i, current_length ) );
+        }
+    }
+    
+    std::sort( sortable_edges.begin(), sortable_edges.end() );
+    
+    if ( m_surf.m_verbose )
+    {
+        std::cout << sortable_edges.size() << " candidate edges sorted" << std::endl;
+        std::cout << "total edges: " << m_surf.m_mesh.m_edges.size() << std::endl;
+    }
+}
+
+
+// --------------------------------------------------------
+///
+/// Collapse all short edges
+///
+/// The candidates go into a priority queue once.  After each collapse, only the edges touching the one-ring of the 
+/// surviving vertex are re-evaluated: their lengths, curvatures and incident triangles are the only ones which changed.
+///
+// --------------------------------------------------------
+
+void EdgeCollapser::process_mesh()
+{
+    
+    if ( m_surf.m_verbose )
+    {
+        std::cout << "\n\n\n---------------------- EdgeCollapser: collapsing ----------------------" << std::endl;
+        std::cout << "m_min_edge_length: " << m_min_edge_length;
+        std::cout << ", m_use_curvature: " << m_use_curvature;
+        std::cout << ", m_min_curvature_multiplier: " << m_min_curvature_multiplier << std::endl;
+        std::cout << "m_surf.m_collision_safety: " << m_surf.m_collision_safety << std::endl;
+    }
+    
+    assert( m_surf.m_dirty_triangles.size() == 0 );
+    
+    std::vector<SortableEdge> sortable_edges_to_try;
+    
+    if ( m_surf.m_parallel_remeshing )
+    {
+        // rounds of independent collapses are picked from the whole candidate list, so rescan until nothing collapses
+        
+        bool collapse_occurred = true;
+        
+        while ( collapse_occurred )
+        {
+            get_sorted_collapse_candidates( sortable_edges_to_try );
+            
+            std::vector<size_t> edges_to_try( sortable_edges_to_try.size() );
+            for ( size_t si = 0; si < sortable_edges_to_try.size(); ++si )
+            {
+                edges_to_try[si] = sortable_edges_to_try[si].edge_index;
+            }
+            
+            collapse_occurred = collapse_edges_in_parallel( edges_to_try );
+        }
+        
+        return;
+    }
+    
+    //
+    // seed the queue with the current set of edges to collapse
+    //
+    
+    get_sorted_collapse_candidates( sortable_edges_to_try );
+    
+    // stamp of the newest queue entry for each edge
+    std::vector<unsigned int> edge_stamps( m_surf.m_mesh.m_edges.size(), 0 );
+    
+    std::priority_queue<QueuedEdge> queue;
+    for ( size_t si = 0; si < sortable_edges_to_try.size(); ++si )
+    {
+        queue.push( QueuedEdge( sortable_edges_to_try[si].edge_index, sortable_edges_to_try[si].edge_length, 0 ) );
+    }
+    
+    std::vector<size_t> changed_vertices, adjacent_vertices, changed_edges;
+    
+    //
+    // attempt to collapse the shortest edge until none are left
+    //
+    
+    while ( !queue.empty() )
+    {
+        QueuedEdge top = queue.top();
+        queue.pop();
+        
+        size_t e = top.edge_index;
         
-        std::sort( sortable_edges_to_try.begin(), sortable_edges_to_try.end() );
+        assert( e < m_surf.m_mesh.m_edges.size() );
+        
+        if ( top.stamp != edge_stamps[e] ) { continue; }    // superseded by a newer entry
+        
+        double edge_length;
+        if ( !edge_is_collapse_candidate( e, edge_length ) ) { continue; }
         
         if ( m_surf.m_verbose )
         {
-            std::cout << sortable_edges_to_try.size() << " candidate edges sorted" << std::endl;
-            std::cout << "total edges: " << m_surf.m_mesh.m_edges.size() << std::endl;
+            printf( "collapsing edge %d / %d, length = %f\n", (int)e, (int)m_surf.m_mesh.m_edges.size(), edge_length );
+            printf( "edge %d %d... ", (int)m_surf.m_mesh.m_edges[e][0], (int)m_surf.m_mesh.m_edges[e][1] );
         }
         
+        Vec2st edge_vertices = m_surf.m_mesh.m_edges[e];
+        
+        if ( !collapse_edge( e ) ) { continue; }
+        
+        // clean up degenerate triangles and tets
+        m_surf.trim_non_manifold( m_surf.m_dirty_triangles );            
+        
         //
-        // attempt to collapse each edge in the sorted list
+        // re-evaluate the edges touching the one-ring of the surviving vertex
         //
         
-        for ( size_t si = 0; si < sortable_edges_to_try.size(); ++si )
+        changed_vertices.clear();
+        for ( unsigned int i = 0; i < 2; ++i )
         {
-            size_t e = sortable_edges_to_try[si].edge_index;
+            size_t v = edge_vertices[i];
+            if ( m_surf.m_mesh.m_vertex_to_triangle_map[v].empty() ) { continue; }    // deleted
             
-            assert( e < m_surf.m_mesh.m_edges.size() );
-            
-            if ( m_surf.m_mesh.edge_is_deleted(e) ) { continue; }
+            changed_vertices.push_back( v );
+            m_surf.m_mesh.get_adjacent_vertices( v, adjacent_vertices );
+            changed_vertices.insert( changed_vertices.end(), adjacent_vertices.begin(), adjacent_vertices.end() );
+        }
+        
+        changed_edges.clear();
+        for ( size_t i = 0; i < changed_vertices.size(); ++i )
+        {
+            const VertexAdjacencyList& incident_edges = m_surf.m_mesh.m_vertex_to_edge_map[ changed_vertices[i] ];
+            changed_edges.insert( changed_edges.end(), incident_edges.begin(), incident_edges.end() );
+        }
+        
+        std::sort( changed_edges.begin(), changed_edges.end() );
+        changed_edges.erase( std::unique( changed_edges.begin(), changed_edges.end() ), changed_edges.end() );
+        
+        edge_stamps.resize( m_surf.m_mesh.m_edges.size(), 0 );
+        
+        for ( size_t i = 0; i < changed_edges.size(); ++i )
+        {
+            size_t changed_edge = changed_edges[i];
             
-            double edge_length;
+            // invalidate any older entry, whether or not the edge is still a candidate
+            ++edge_stamps[changed_edge];
             
-            if ( m_use_curvature )
-            {
-                edge_length = get_curvature_scaled_length( m_surf, m_surf.m_mesh.m_edges[e][0], m_surf.m_mesh.m_edges[e][1], m_min_curvature_multiplier, 1e+30 );
-            }
-            else
+            if ( edge_is_collapse_candidate( changed_edge, edge_length ) )
             {
-                edge_length = m_surf.get_edge_length(e);
-            }
-            
-            if ( edge_length < m_min_edge_length )
-            {        
-                if ( m_surf.m_verbose )
-                {
-                    printf( "collapsing edge %d / %d, length = %f\n", (int)e, (int)m_surf.m_mesh.m_edges.size(), edge_length );
-                    printf( "edge %d %d... ", (int)m_surf.m_mesh.m_edges[e][0], (int)m_surf.m_mesh.m_edges[e][1] );
-                }
-                
-                if ( m_surf.m_mesh.m_edges[e][0] == m_surf.m_mesh.m_edges[e][1] )   { continue; }     // skip deleted edges         
-                if ( m_surf.m_mesh.m_edge_to_triangle_map[e].size() < 2 )  { continue; }  // skip boundary edges
-                
-                if( m_surf.m_mesh.m_is_boundary_vertex[m_surf.m_mesh.m_edges[e][0]] || 
-                   m_surf.m_mesh.m_is_boundary_vertex[m_surf.m_mesh.m_edges[e][1]] )
-                {
-                    continue;
-                }
-                
-                bool result = collapse_edge( e );
-                
-                if ( result )
-                { 
-                    // clean up degenerate triangles and tets
-                    m_surf.trim_non_manifold( m_surf.m_dirty_triangles );            
-                }
-                
-                collapse_occurred |= result;
-                
+                queue.push( QueuedEdge( changed_edge, edge_length, edge_stamps[changed_edge] ) );
             }
         }
-    
-    
-    }   // while collapse_occurred
+    }
 }
 
 
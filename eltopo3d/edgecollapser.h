@@ -24,6 +24,7 @@
 
 class SurfTrack;
 class EdgeCollapseObserver;
+struct SortableEdge;
 
 // ---------------------------------------------------------
 //  Class definitions
@@ -89,11 +90,6 @@ private:
                               size_t edge_index,
                               std::vector<size_t>& moving_triangles );
     
-    void get_moving_edges( size_t source_vertex, 
-                          size_t destination_vertex, 
-                          size_t edge_index,
-                          std::vector<size_t>& moving_edges );
-    
     bool collapse_edge_pseudo_motion_introduces_collision( size_t source_vertex, 
                                                           size_t destination_vertex, 
                                                           size_t edge_index, 
@@ -113,6 +109,35 @@ private:
                                             size_t edge_index, 
                                             const Vec3d& vertex_new_position );
     
+    /// The result of checking a collapse: which vertex survives, where it goes, and the region of space the checks 
+    /// looked at.  Defined in edgecollapser.cpp.
+    ///
+    struct CollapsePlan;
+    
+    /// Run all checks for collapsing an edge, without changing the surface.  Safe to call from several threads at once.
+    ///
+    bool check_collapse( size_t edge, CollapsePlan& plan );
+    
+    /// Carry out a collapse which passed check_collapse, unless an observer vetoes it
+    ///
+    bool apply_collapse( const CollapsePlan& plan );
+    
+    /// Get the length of the edge used to decide whether to collapse it
+    ///
+    double get_collapse_length( size_t edge ) const;
+    
+    /// Determine whether an edge is short enough to collapse and not excluded from collapsing, and get its length
+    ///
+    bool edge_is_collapse_candidate( size_t edge, double& edge_length ) const;
+    
+    /// Get all collapse candidates, sorted in ascending order by length
+    ///
+    void get_sorted_collapse_candidates( std::vector<SortableEdge>& sortable_edges ) const;
+    
+    /// Collapse the given edges, shortest first, checking independent collapses concurrently
+    ///
+    bool collapse_edges_in_parallel( const std::vector<size_t>& edges );
+    
     
     
     ///
@@ -13,12 +13,32 @@
 #include "../common/ccd_wrapper.h"
 #include "../common/collisionqueries.h"
 #include "collisionpipeline.h"
+#include "meshoperationscheduler.h"
 #include "nondestructivetrimesh.h"
 #include "../common/runstats.h"
 #include "surftrack.h"
 #include "trianglequality.h"
 
 
+// --------------------------------------------------------
+///
+/// A flip which has passed its checks
+///
+// --------------------------------------------------------
+
+struct EdgeFlipper::FlipPlan
+{
+    size_t m_edge;
+    size_t m_tri0, m_tri1;
+    
+    /// Triangles replacing tri0 and tri1
+    Vec3st m_new_triangle0, m_new_triangle1;
+    
+    /// AABB of everything the collision checks looked at
+    Vec3d m_region_low, m_region_high;
+};
+
+
 // --------------------------------------------------------
 ///
 ///
@@ -80,6 +100,7 @@ bool EdgeFlipper::flip_introduces_collision( size_t edge_index,
     minmax( tet_vertex_positions[0], tet_vertex_positions[1], tet_vertex_positions[2], tet_vertex_positions[3], low, high );
     
     std::vector<size_t> overlapping_vertices;
+    
     m_surf.m_broad_phase->get_potential_vertex_collisions( low, high, true, true, overlapping_vertices );
     
     // do point-in-tet tests
@@ -91,7 +112,7 @@ bool EdgeFlipper::flip_introduces_collision( size_t edge_index,
             continue;
         }
         
-        if ( point_tetrahedron_intersection( xs[overlapping_vertices[i]], overlapping_vertices[i],
+        if ( point_tetrahedron_intersection( m_surf.m_ccd_backend, xs[overlapping_vertices[i]], overlapping_vertices[i],
                                             tet_vertex_positions[0], tet_vertex_indices[0],
                                             tet_vertex_positions[1], tet_vertex_indices[1],
                                             tet_vertex_positions[2], tet_vertex_indices[2],
@@ -114,7 +135,7 @@ bool EdgeFlipper::flip_introduces_collision( size_t edge_index,
         size_t overlapping_edge_index = overlapping_edges[i];
         const Vec2st& edge = m_mesh.m_edges[overlapping_edge_index];
         
-        if ( check_edge_triangle_intersection_by_index( edge[0], edge[1], 
+        if ( check_edge_triangle_intersection_by_index( m_surf.m_ccd_backend, edge[0], edge[1], 
                                                        new_triangle_a[0], new_triangle_a[1], new_triangle_a[2], 
                                                        xs, m_surf.m_verbose ) )
         {
@@ -136,7 +157,7 @@ bool EdgeFlipper::flip_introduces_collision( size_t edge_index,
         size_t overlapping_edge_index = overlapping_edges[i];
         const Vec2st& edge = m_mesh.m_edges[overlapping_edge_index];
         
-        if ( check_edge_triangle_intersection_by_index( edge[0], edge[1], 
+        if ( check_edge_triangle_intersection_by_index( m_surf.m_ccd_backend, edge[0], edge[1], 
                                                        new_triangle_b[0], new_triangle_b[1], new_triangle_b[2], 
                                                        xs, m_surf.m_verbose ) )
         {
@@ -156,7 +177,7 @@ bool EdgeFlipper::flip_introduces_collision( size_t edge_index,
     {
         const Vec3st& tri = m_mesh.get_triangle(overlapping_triangles[i]);
         
-        if ( check_edge_triangle_intersection_by_index( new_edge[0], new_edge[1],
+        if ( check_edge_triangle_intersection_by_index( m_surf.m_ccd_backend, new_edge[0], new_edge[1],
                                                        tri[0], tri[1], tri[2],
                                                        xs, m_surf.m_verbose ) )
         {         
@@ -245,6 +266,30 @@ bool EdgeFlipper::flip_edge( size_t edge,
                             size_t tri1, 
                             size_t third_vertex_0, 
                             size_t third_vertex_1 )
+{
+    FlipPlan plan;
+    
+    if ( !check_flip( edge, tri0, tri1, third_vertex_0, third_vertex_1, plan ) )
+    {
+        return false;
+    }
+    
+    return apply_flip( plan );
+}
+
+
+// --------------------------------------------------------
+///
+/// Check whether an edge can be flipped.  Doesn't modify the surface.
+///
+// --------------------------------------------------------
+
+bool EdgeFlipper::check_flip( size_t edge, 
+                             size_t tri0, 
+                             size_t tri1, 
+                             size_t third_vertex_0, 
+                             size_t third_vertex_1,
+                             FlipPlan& plan )
 {     
     NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
     const std::vector<Vec3d>& xs = m_surf.get_positions();
@@ -430,7 +475,38 @@ bool EdgeFlipper::flip_edge( size_t edge,
     
     // --------------
     
-    PreEdgeFlipInfo pre_info( edge, tri0, tri1 );
+    plan.m_edge = edge;
+    plan.m_tri0 = tri0;
+    plan.m_tri1 = tri1;
+    plan.m_new_triangle0 = new_triangle0;
+    plan.m_new_triangle1 = new_triangle1;
+    
+    // the collision checks only look at elements near the tet spanned by the old and new edges
+    minmax( xs[edge_vertices[0]], xs[edge_vertices[1]], xs[new_edge[0]], xs[new_edge[1]], plan.m_region_low, plan.m_region_high );
+    plan.m_region_low -= m_surf.m_aabb_padding * Vec3d(1,1,1);
+    plan.m_region_high += m_surf.m_aabb_padding * Vec3d(1,1,1);
+    
+    return true;
+    
+}
+
+
+// --------------------------------------------------------
+///
+/// Carry out a flip which passed check_flip, unless an observer vetoes it
+///
+// --------------------------------------------------------
+
+bool EdgeFlipper::apply_flip( const FlipPlan& plan )
+{
+    NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
+    
+    size_t tri0 = plan.m_tri0;
+    size_t tri1 = plan.m_tri1;
+    const Vec3st& new_triangle0 = plan.m_new_triangle0;
+    const Vec3st& new_triangle1 = plan.m_new_triangle1;
+    
+    PreEdgeFlipInfo pre_info( plan.m_edge, tri0, tri1 );
 
     for ( size_t i = 0; i < m_observers.size(); ++i )
     {
@@ -488,6 +564,197 @@ bool EdgeFlipper::flip_edge( size_t edge,
 }
 
 
+// --------------------------------------------------------
+///
+/// Determine whether flipping the edge would shorten it enough, and if so, get its incident triangles and the vertices 
+/// opposite it
+///
+// --------------------------------------------------------
+
+bool EdgeFlipper::edge_is_flip_candidate( size_t i, 
+                                         size_t& triangle_a, 
+                                         size_t& triangle_b, 
+                                         size_t& third_vertex_0, 
+                                         size_t& third_vertex_1 ) const
+{
+    const NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
+    const std::vector<Vec3d>& xs = m_surf.get_positions();
+    
+    if ( m_mesh.m_edges[i][0] == m_mesh.m_edges[i][1] )   { return false; }
+    if ( m_mesh.m_edge_to_triangle_map[i].size() > 4 || m_mesh.m_edge_to_triangle_map[i].size() < 2 )   { return false; }
+    if ( m_mesh.m_is_boundary_vertex[ m_mesh.m_edges[i][0] ] || m_mesh.m_is_boundary_vertex[ m_mesh.m_edges[i][1] ] )  { return false; }  // skip boundary vertices
+    
+    triangle_a = (size_t)~0;
+    triangle_b = (size_t)~0;
+    
+    if ( m_mesh.m_edge_to_triangle_map[i].size() == 2 )
+    {    
+        triangle_a = m_mesh.m_edge_to_triangle_map[i][0];
+        triangle_b = m_mesh.m_edge_to_triangle_map[i][1];         
+        assert (    m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_a) ) 
+                != m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_b) ) );
+    }
+    else if ( m_mesh.m_edge_to_triangle_map[i].size() == 4 )
+    {           
+        triangle_a = m_mesh.m_edge_to_triangle_map[i][0];
+        
+        // Find first triangle with orientation opposite triangle_a's orientation
+        unsigned int j = 1;
+        for ( ; j < 4; ++j )
+        {
+            triangle_b = m_mesh.m_edge_to_triangle_map[i][j];
+            if (    m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_a) ) 
+                != m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_b) ) )
+            {
+                break;
+            }
+        }
+        assert ( j < 4 );
+    }
+    else
+    {
+        std::cout << m_mesh.m_edge_to_triangle_map[i].size() << " triangles incident to an edge" << std::endl;
+        assert(0);
+    }
+    
+    // Don't flip edge on a degenerate triangle
+    const Vec3st& tri_a = m_mesh.get_triangle( triangle_a );
+    const Vec3st& tri_b = m_mesh.get_triangle( triangle_b );
+    
+    if (   tri_a[0] == tri_a[1] 
+        || tri_a[1] == tri_a[2] 
+        || tri_a[2] == tri_a[0] 
+        || tri_b[0] == tri_b[1] 
+        || tri_b[1] == tri_b[2] 
+        || tri_b[2] == tri_b[0] )
+    {
+        return false;
+    }
+    
+    third_vertex_0 = m_mesh.get_third_vertex( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], tri_a );
+    third_vertex_1 = m_mesh.get_third_vertex( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], tri_b );
+    
+    if ( third_vertex_0 == third_vertex_1 )
+    {
+        return false;
+    }
+    
+    double current_length = mag( xs[m_mesh.m_edges[i][1]] - xs[m_mesh.m_edges[i][0]] );        
+    double potential_length = mag( xs[third_vertex_1] - xs[third_vertex_0] );     
+    
+    return ( potential_length < current_length - m_edge_flip_min_length_change );
+}
+
+
+// --------------------------------------------------------
+///
+/// Flip edges in rounds.  Each round takes, in order, the remaining edges whose flips don't interfere with each other, 
+/// checks them concurrently, then applies them in order.  Flips which couldn't join the round, or whose checked region
+/// overlaps a flip applied earlier in the round, wait for the next round.
+///
+// --------------------------------------------------------
+
+bool EdgeFlipper::flip_edges_in_parallel( size_t number_of_edges )
+{
+    NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
+    
+    MeshOperationScheduler scheduler;
+    bool flip_occurred = false;
+    
+    std::vector<size_t> pending( number_of_edges );
+    for ( size_t i = 0; i < number_of_edges; ++i ) { pending[i] = i; }
+    
+    std::vector<size_t> round_edges, round_slots, stencil(4);
+    std::vector<Vec4st> round_flips;
+    std::vector<FlipPlan> plans;
+    std::vector<Vec3d> region_lows, region_highs;
+    
+    while ( !pending.empty() )
+    {
+        scheduler.begin_round( m_surf.get_num_vertices() );
+        
+        // which pending edges to try again next round
+        std::vector<char> retry( pending.size(), 0 );
+        
+        round_edges.clear();
+        round_slots.clear();
+        round_flips.clear();
+        
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            size_t e = pending[i];
+            
+            size_t triangle_a, triangle_b, third_vertex_0, third_vertex_1;
+            if ( !edge_is_flip_candidate( e, triangle_a, triangle_b, third_vertex_0, third_vertex_1 ) ) { continue; }
+            
+            // the flip replaces the two triangles
+            stencil[0] = m_mesh.m_edges[e][0];
+            stencil[1] = m_mesh.m_edges[e][1];
+            stencil[2] = third_vertex_0;
+            stencil[3] = third_vertex_1;
+            
+            if ( scheduler.claim_stencil( m_mesh, stencil ) )
+            {
+                round_edges.push_back( e );
+                round_slots.push_back( i );
+                round_flips.push_back( Vec4st( triangle_a, triangle_b, third_vertex_0, third_vertex_1 ) );
+            }
+            else
+            {
+                retry[i] = 1;
+            }
+        }
+        
+        // check the round concurrently
+        
+        plans.resize( round_edges.size() );
+        std::vector<char> plan_ok( round_edges.size(), 0 );
+        
+        #pragma omp parallel for schedule(dynamic) num_threads(m_surf.m_num_threads)
+        for ( int i = 0; i < (int) round_edges.size(); ++i )
+        {
+            const Vec4st& flip = round_flips[i];
+            plan_ok[i] = check_flip( round_edges[i], flip[0], flip[1], flip[2], flip[3], plans[i] );
+        }
+        
+        // apply in order
+        
+        region_lows.clear();
+        region_highs.clear();
+        for ( size_t i = 0; i < plans.size(); ++i )
+        {
+            if ( !plan_ok[i] ) { continue; }
+            region_lows.push_back( plans[i].m_region_low );
+            region_highs.push_back( plans[i].m_region_high );
+        }
+        
+        scheduler.begin_apply( region_lows, region_highs );
+        
+        for ( size_t i = 0; i < plans.size(); ++i )
+        {
+            if ( !plan_ok[i] ) { continue; }
+            
+            if ( !scheduler.claim_region( plans[i].m_region_low, plans[i].m_region_high ) )
+            {
+                retry[ round_slots[i] ] = 1;
+                continue;
+            }
+            
+            flip_occurred |= apply_flip( plans[i] );
+        }
+        
+        std::vector<size_t> next_pending;
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            if ( retry[i] ) { next_pending.push_back( pending[i] ); }
+        }
+        pending.swap( next_pending );
+    }
+    
+    return flip_occurred;
+}
+
+
 // --------------------------------------------------------
 ///
 /// Flip all non-delaunay edges
@@ -511,7 +778,6 @@ void EdgeFlipper::process_mesh( )
     unsigned int num_flip_passes = 0;
     
     NonDestructiveTriMesh& m_mesh = m_surf.m_mesh;
-    const std::vector<Vec3d>& xs = m_surf.get_positions();
     
     //
     // Each "pass" is once over the entire set of edges (ignoring edges created during the current pass)
@@ -530,90 +796,35 @@ void EdgeFlipper::process_mesh( )
         
         size_t number_of_edges = m_mesh.m_edges.size();      // don't work on newly created edges
         
-        for( size_t i = 0; i < number_of_edges; i++ )
+        if ( m_surf.m_parallel_remeshing )
         {
-            if ( m_mesh.m_edges[i][0] == m_mesh.m_edges[i][1] )   { continue; }
-            if ( m_mesh.m_edge_to_triangle_map[i].size() > 4 || m_mesh.m_edge_to_triangle_map[i].size() < 2 )   { continue; }
-            if ( m_mesh.m_is_boundary_vertex[ m_mesh.m_edges[i][0] ] || m_mesh.m_is_boundary_vertex[ m_mesh.m_edges[i][1] ] )  { continue; }  // skip boundary vertices
-            
-            size_t triangle_a = (size_t)~0, triangle_b =(size_t)~0;
-            
-            if ( m_mesh.m_edge_to_triangle_map[i].size() == 2 )
-            {    
-                triangle_a = m_mesh.m_edge_to_triangle_map[i][0];
-                triangle_b = m_mesh.m_edge_to_triangle_map[i][1];         
-                assert (    m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_a) ) 
-                        != m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_b) ) );
-            }
-            else if ( m_mesh.m_edge_to_triangle_map[i].size() == 4 )
-            {           
-                triangle_a = m_mesh.m_edge_to_triangle_map[i][0];
+            flip_occurred = flip_edges_in_parallel( number_of_edges );
+        }
+        else
+        {
+            for( size_t i = 0; i < number_of_edges; i++ )
+            {
+                size_t triangle_a, triangle_b, third_vertex_0, third_vertex_1;
                 
-                // Find first triangle with orientation opposite triangle_a's orientation
-                unsigned int j = 1;
-                for ( ; j < 4; ++j )
+                if ( edge_is_flip_candidate( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 ) )
                 {
-                    triangle_b = m_mesh.m_edge_to_triangle_map[i][j];
-                    if (    m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_a) ) 
-                        != m_mesh.oriented( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], m_mesh.get_triangle(triangle_b) ) )
-                    {
-                        break;
-                    }
+                    bool flipped = flip_edge( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 );
+                    flip_occurred |= flipped;
                 }
-                assert ( j < 4 );
-            }
-            else
-            {
-                std::cout << m_mesh.m_edge_to_triangle_map[i].size() << " triangles incident to an edge" << std::endl;
-                assert(0);
-            }
-            
-            // Don't flip edge on a degenerate triangle
-            const Vec3st& tri_a = m_mesh.get_triangle( triangle_a );
-            const Vec3st& tri_b = m_mesh.get_triangle( triangle_b );
-            
-            if (   tri_a[0] == tri_a[1] 
-                || tri_a[1] == tri_a[2] 
-                || tri_a[2] == tri_a[0] 
-                || tri_b[0] == tri_b[1] 
-                || tri_b[1] == tri_b[2] 
-                || tri_b[2] == tri_b[0] )
-            {
-                continue;
-            }
-            
-            size_t third_vertex_0 = m_mesh.get_third_vertex( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], tri_a );
-            size_t third_vertex_1 = m_mesh.get_third_vertex( m_mesh.m_edges[i][0], m_mesh.m_edges[i][1], tri_b );
-            
-            if ( third_vertex_0 == third_vertex_1 )
-            {
-                continue;
-            }
-            
-            bool flipped = false;
-            
-            double current_length = mag( xs[m_mesh.m_edges[i][1]] - xs[m_mesh.m_edges[i][0]] );        
-            double potential_length = mag( xs[third_vertex_1] - xs[third_vertex_0] );     
-            if ( potential_length < current_length - m_edge_flip_min_length_change )
-            {
-                flipped = flip_edge( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 );            
+                
+                //         else if ( regularity_improves( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 ) )
+                //         {
+                //            
+                //            size_t r_before = total_mesh_regularity();
+                //            
+                //            flipped = flip_edge( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 );
+                //            
+                //            size_t r_after = total_mesh_regularity();
+                //
+                //            assert( !flipped || r_after < r_before );
+                //            
+                //         }
             }
-            
-            //         else if ( regularity_improves( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 ) )
-            //         {
-            //            
-            //            size_t r_before = total_mesh_regularity();
-            //            
-            //            flipped = flip_edge( i, triangle_a, triangle_b, third_vertex_0, third_vertex_1 );
-            //            
-            //            size_t r_after = total_mesh_regularity();
-            //
-            //            assert( !flipped || r_after < r_before );
-            //            
-            //         }
-            
-            
-            flip_occurred |= flipped;
         }
         
         flip_occurred_ever |= flip_occurred;
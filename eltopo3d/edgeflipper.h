@@ -96,6 +96,28 @@ private:
     ///
     bool flip_edge(size_t edge, size_t tri0, size_t tri1, size_t third_vertex_0, size_t third_vertex_1 );
     
+    /// The result of checking a flip: the triangles to remove and add, and the region of space the checks looked at.
+    /// Defined in edgeflipper.cpp.
+    ///
+    struct FlipPlan;
+    
+    /// Run all checks for flipping an edge, without changing the surface.  Safe to call from several threads at once.
+    ///
+    bool check_flip( size_t edge, size_t tri0, size_t tri1, size_t third_vertex_0, size_t third_vertex_1, FlipPlan& plan );
+    
+    /// Carry out a flip which passed check_flip, unless an observer vetoes it
+    ///
+    bool apply_flip( const FlipPlan& plan );
+    
+    /// Determine whether flipping the edge would shorten it enough, and if so, get its incident triangles and the 
+    /// vertices opposite it
+    ///
+    bool edge_is_flip_candidate( size_t edge, size_t& tri0, size_t& tri1, size_t& third_vertex_0, size_t& third_vertex_1 ) const;
+    
+    /// Flip edges in the range [0, number_of_edges), in order, checking independent flips concurrently
+    ///
+    bool flip_edges_in_parallel( size_t number_of_edges );
+    
     size_t vertex_valence( size_t vertex_index );
     
     int total_mesh_regularity();
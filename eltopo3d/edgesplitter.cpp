@@ -12,10 +12,62 @@
 #include "broadphase.h"
 #include "../common/ccd_wrapper.h"
 #include "../common/collisionqueries.h"
+#include "meshoperationscheduler.h"
 #include "../common/runstats.h"
 #include "subdivisionscheme.h"
 #include "surftrack.h"
 #include "trianglequality.h"
+#include <queue>
+
+// --------------------------------------------------------
+///
+/// A split which has passed its checks
+///
+// --------------------------------------------------------
+
+struct EdgeSplitter::SplitPlan
+{
+    size_t m_edge;
+    size_t m_tri0, m_tri1;
+    size_t m_vertex_a, m_vertex_b, m_vertex_c, m_vertex_d;
+    
+    /// Where the new vertex will go
+    Vec3d m_new_vertex_position;
+    
+    /// AABB of everything the collision checks looked at
+    Vec3d m_region_low, m_region_high;
+};
+
+
+namespace {
+
+// --------------------------------------------------------
+///
+/// Entry in the queue of edges to split.  When an edge changes, a new entry with a higher stamp is pushed, and the old 
+/// one is skipped when it comes off the queue.
+///
+// --------------------------------------------------------
+
+struct QueuedSplit
+{
+    size_t edge_index;
+    double edge_length;
+    bool large_angle;
+    unsigned int stamp;
+    
+    QueuedSplit( size_t ei, double el, bool la, unsigned int st ) : edge_index(ei), edge_length(el), large_angle(la), stamp(st) {}
+    
+    /// std::priority_queue pops the largest element: long edges before large angles, then longest first.  Ties go to the
+    /// lower edge index.
+    bool operator<( const QueuedSplit& other ) const
+    {
+        if ( large_angle != other.large_angle ) { return large_angle; }
+        if ( edge_length != other.edge_length ) { return edge_length < other.edge_length; }
+        return edge_index > other.edge_index;
+    }
+};
+
+}
 
 
 
@@ -104,7 +156,7 @@ bool EdgeSplitter::split_edge_edge_collision( size_t neighbour_index,
     
     if ( edge_vertex_1 < edge_vertex_0 ) { swap( edge_vertex_0, edge_vertex_1 ); }
     
-    if ( segment_segment_collision(x[ neighbour_index ], x[ neighbour_index ], neighbour_index,
+    if ( segment_segment_collision(m_surf.m_ccd_backend, x[ neighbour_index ], x[ neighbour_index ], neighbour_index,
                                    new_vertex_position, new_vertex_smooth_position, dummy_index,
                                    x[ edge_vertex_0 ], x[ edge_vertex_0 ], edge_vertex_0,
                                    x[ edge_vertex_1 ], x[ edge_vertex_1 ], edge_vertex_1 ) )
@@ -165,7 +217,7 @@ bool EdgeSplitter::split_triangle_vertex_collision( const Vec3st& triangle_indic
     
     // now check continuous collision
     
-    if ( point_triangle_collision( vert, vert, overlapping_vert_index,
+    if ( point_triangle_collision( m_surf.m_ccd_backend, vert, vert, overlapping_vert_index,
                                   tri_positions[0], tri_smooth_positions[0], sorted_triangle[0],
                                   tri_positions[1], tri_smooth_positions[1], sorted_triangle[1],
                                   tri_positions[2], tri_smooth_positions[2], sorted_triangle[2] ) )
@@ -212,6 +264,7 @@ bool EdgeSplitter::split_edge_pseudo_motion_introduces_intersection( const Vec3d
         aabb_high += m_surf.m_aabb_padding * Vec3d(1,1,1);
         
         std::vector<size_t> overlapping_triangles;
+        
         m_surf.m_broad_phase->get_potential_triangle_collisions( aabb_low, aabb_high, true, true, overlapping_triangles );
         
         for ( size_t i = 0; i < overlapping_triangles.size(); ++i )
@@ -244,7 +297,7 @@ bool EdgeSplitter::split_edge_pseudo_motion_introduces_intersection( const Vec3d
             Vec3st sorted_triangle = sort_triangle( Vec3st( triangle_vertex_0, triangle_vertex_1, triangle_vertex_2 ) );
             
             
-            if ( point_triangle_collision(  new_vertex_position, new_vertex_smooth_position, dummy_index,
+            if ( point_triangle_collision(  m_surf.m_ccd_backend, new_vertex_position, new_vertex_smooth_position, dummy_index,
                                           m_surf.get_position( sorted_triangle[0] ), m_surf.get_position( sorted_triangle[0] ), sorted_triangle[0],
                                           m_surf.get_position( sorted_triangle[1] ), m_surf.get_position( sorted_triangle[1] ), sorted_triangle[1],
                                           m_surf.get_position( sorted_triangle[2] ), m_surf.get_position( sorted_triangle[2] ), sorted_triangle[2] ) )
@@ -360,7 +413,25 @@ bool EdgeSplitter::split_edge_pseudo_motion_introduces_intersection( const Vec3d
 ///
 // --------------------------------------------------------
 
-bool EdgeSplitter::split_edge( size_t edge )
+bool EdgeSplitter::split_edge( size_t edge, size_t* new_vertex )
+{
+    SplitPlan plan;
+    
+    if ( !check_split( edge, plan ) )
+    {
+        return false;
+    }
+    
+    return apply_split( plan, new_vertex );
+}
+
+// --------------------------------------------------------
+///
+/// Check whether an edge can be split, and where the new vertex should go.  Doesn't modify the surface.
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::check_split( size_t edge, SplitPlan& plan )
 {   
     assert( edge_is_splittable(edge) );
     
@@ -418,6 +489,13 @@ bool EdgeSplitter::split_edge( size_t edge )
     // generate the new midpoint according to the subdivision scheme
     m_surf.m_subdivision_scheme->generate_new_midpoint( edge, m_surf, new_vertex_smooth_position );
     
+    // the collision checks below only look at elements near these points
+    minmax( new_vertex_position, new_vertex_smooth_position, 
+           m_surf.get_position( vertex_a ), m_surf.get_position( vertex_b ), m_surf.get_position( vertex_c ), m_surf.get_position( vertex_d ),
+           plan.m_region_low, plan.m_region_high );
+    plan.m_region_low -= m_surf.m_aabb_padding * Vec3d(1,1,1);
+    plan.m_region_high += m_surf.m_aabb_padding * Vec3d(1,1,1);
+    
     // --------------
     
     // check if the generated point introduces an intersection
@@ -540,11 +618,39 @@ bool EdgeSplitter::split_edge( size_t edge )
         }
     }
     
+    plan.m_edge = edge;
+    plan.m_tri0 = tri0;
+    plan.m_tri1 = tri1;
+    plan.m_vertex_a = vertex_a;
+    plan.m_vertex_b = vertex_b;
+    plan.m_vertex_c = vertex_c;
+    plan.m_vertex_d = vertex_d;
+    plan.m_new_vertex_position = new_vertex_smooth_position;
+    
+    return true;
+    
+}
+
+// --------------------------------------------------------
+///
+/// Carry out a split which passed check_split, unless an observer vetoes it
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::apply_split( const SplitPlan& plan, size_t* new_vertex )
+{
+    size_t tri0 = plan.m_tri0;
+    size_t tri1 = plan.m_tri1;
+    size_t vertex_a = plan.m_vertex_a;
+    size_t vertex_b = plan.m_vertex_b;
+    size_t vertex_c = plan.m_vertex_c;
+    size_t vertex_d = plan.m_vertex_d;
+    
     // --------------
     
     // Check with any observers
     
-    PreEdgeSplitInfo pre_info( edge, tri0, tri1, vertex_a, vertex_b, vertex_c, vertex_d );
+    PreEdgeSplitInfo pre_info( plan.m_edge, tri0, tri1, vertex_a, vertex_b, vertex_c, vertex_d );
 
     for ( size_t i = 0; i < m_observers.size(); ++i )
     {
@@ -559,7 +665,7 @@ bool EdgeSplitter::split_edge( size_t edge )
     // Do the actual splitting
     
     double new_vertex_mass = 0.5 * ( m_surf.m_masses[ vertex_a ] + m_surf.m_masses[ vertex_b ] );
-    size_t vertex_e = m_surf.add_vertex( new_vertex_smooth_position, new_vertex_mass );
+    size_t vertex_e = m_surf.add_vertex( plan.m_new_vertex_position, new_vertex_mass );
     
     // Add to change history
     m_surf.m_vertex_change_history.push_back( VertexUpdateEvent( VertexUpdateEvent::VERTEX_ADD, vertex_e, Vec2st( vertex_a, vertex_b) ) );
@@ -573,9 +679,8 @@ bool EdgeSplitter::split_edge( size_t edge )
     size_t new_tri1 = m_surf.add_triangle( Vec3st( vertex_c, vertex_e, vertex_b ) );
     size_t new_tri2 = m_surf.add_triangle( Vec3st( vertex_d, vertex_b, vertex_e ) );
     size_t new_tri3 = m_surf.add_triangle( Vec3st( vertex_d, vertex_e, vertex_a ) );      
-    size_t new_vertex = vertex_e;
 
-    PostEdgeSplitInfo post_info( pre_info, new_vertex, new_tri0, new_tri1, new_tri2, new_tri3 );
+    PostEdgeSplitInfo post_info( pre_info, vertex_e, new_tri0, new_tri1, new_tri2, new_tri3 );
     
     // notify observers
     for ( size_t i = 0; i < m_observers.size(); ++i )
@@ -583,6 +688,8 @@ bool EdgeSplitter::split_edge( size_t edge )
         m_observers[i]->operationOccurred( m_surf, post_info );
     }
     
+    if ( new_vertex != NULL ) { *new_vertex = vertex_e; }
+    
     return true;
     
 }
@@ -609,6 +716,67 @@ bool EdgeSplitter::edge_is_splittable( size_t edge_index ) const
     
 }
 
+// --------------------------------------------------------
+///
+/// Get the length of the edge used to decide whether to split it (scaled by curvature, if enabled)
+///
+// --------------------------------------------------------
+
+double EdgeSplitter::get_split_length( size_t edge_index ) const
+{
+    if ( m_use_curvature )
+    {
+        return get_curvature_scaled_length( m_surf, m_surf.m_mesh.m_edges[edge_index][0], m_surf.m_mesh.m_edges[edge_index][1], 0.0, m_max_curvature_multiplier );
+    }
+    
+    return m_surf.get_edge_length(edge_index);
+}
+
+// --------------------------------------------------------
+///
+/// Determine if edge is longer than the maximum edge length
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::edge_is_too_long( size_t edge_index ) const
+{
+    return get_split_length( edge_index ) > m_max_edge_length;
+}
+
+// --------------------------------------------------------
+///
+/// Determine if either angle opposite a splittable edge is larger than the maximum triangle angle
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::edge_is_opposite_large_angle( size_t e ) const
+{
+    const NonDestructiveTriMesh& mesh = m_surf.m_mesh;
+    
+    // get edge end points
+    const Vec2st& edge = mesh.m_edges[e];      
+    const Vec3d& edge_point0 = m_surf.get_position( edge[0] );
+    const Vec3d& edge_point1 = m_surf.get_position( edge[1] );
+    
+    // get triangles incident to the edge
+    size_t t0 = mesh.m_edge_to_triangle_map[e][0];
+    size_t t1 = mesh.m_edge_to_triangle_map[e][1];
+    const Vec3st& tri0 = mesh.get_triangle(t0);
+    const Vec3st& tri1 = mesh.get_triangle(t1);
+    
+    // get vertex opposite the edge for each triangle
+    size_t opposite0 = mesh.get_third_vertex( e, tri0 );
+    size_t opposite1 = mesh.get_third_vertex( e, tri1 );
+    
+    // compute the angle at each opposite vertex
+    const Vec3d& opposite_point0 = m_surf.get_position(opposite0);
+    const Vec3d& opposite_point1 = m_surf.get_position(opposite1);
+    double angle0 = rad2deg( acos( dot( normalized(edge_point0-opposite_point0), normalized(edge_point1-opposite_point0) ) ) );
+    double angle1 = rad2deg( acos( dot( normalized(edge_point0-opposite_point1), normalized(edge_point1-opposite_point1) ) ) );
+    
+    return angle0 > m_surf.m_max_triangle_angle || angle1 > m_surf.m_max_triangle_angle;
+}
+
 // --------------------------------------------------------
 ///
 /// Split edges opposite large angles
@@ -620,6 +788,17 @@ bool EdgeSplitter::large_angle_split_pass()
     
     NonDestructiveTriMesh& mesh = m_surf.m_mesh;
     
+    if ( m_surf.m_parallel_remeshing )
+    {
+        std::vector<size_t> edges;
+        for ( size_t e = 0; e < mesh.m_edges.size(); ++e )
+        {
+            if ( edge_is_splittable(e) && edge_is_opposite_large_angle(e) ) { edges.push_back(e); }
+        }
+        
+        return split_edges_in_parallel( edges, true );
+    }
+    
     bool split_occurred = false;
     
     for ( size_t e = 0; e < mesh.m_edges.size(); ++e )
@@ -627,45 +806,158 @@ bool EdgeSplitter::large_angle_split_pass()
         
         if ( !edge_is_splittable(e) ) { continue; }
         
-        // get edge end points
-        const Vec2st& edge = m_surf.m_mesh.m_edges[e];      
-        const Vec3d& edge_point0 = m_surf.get_position( edge[0] );
-        const Vec3d& edge_point1 = m_surf.get_position( edge[1] );
+        // if an angle is above the max threshold, split the edge
+        
+        if ( edge_is_opposite_large_angle(e) )
+        {
+            bool result = split_edge( e );
+            split_occurred |= result;
+        }
+    }
+    
+    
+    return split_occurred;
+    
+}
+
+// --------------------------------------------------------
+///
+/// Split the given edges in rounds.  Each round takes, in order, the remaining edges whose splits don't interfere with
+/// each other, checks them concurrently, then applies them in order.  Splits which couldn't join the round, or whose
+/// checked region overlaps a split applied earlier in the round, wait for the next round.
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::split_edges_in_parallel( const std::vector<size_t>& edges, bool large_angles )
+{
+    NonDestructiveTriMesh& mesh = m_surf.m_mesh;
+    
+    MeshOperationScheduler scheduler;
+    bool split_occurred = false;
+    
+    std::vector<size_t> pending( edges );
+    std::vector<size_t> round_edges, round_slots, stencil(4);
+    std::vector<SplitPlan> plans;
+    std::vector<Vec3d> region_lows, region_highs;
+    
+    while ( !pending.empty() )
+    {
+        scheduler.begin_round( m_surf.get_num_vertices() );
+        
+        // which pending edges to try again next round
+        std::vector<char> retry( pending.size(), 0 );
         
-        // get triangles incident to the edge
-        size_t t0 = mesh.m_edge_to_triangle_map[e][0];
-        size_t t1 = mesh.m_edge_to_triangle_map[e][1];
-        const Vec3st& tri0 = mesh.get_triangle(t0);
-        const Vec3st& tri1 = mesh.get_triangle(t1);
+        round_edges.clear();
+        round_slots.clear();
         
-        // get vertex opposite the edge for each triangle
-        size_t opposite0 = mesh.get_third_vertex( e, tri0 );
-        size_t opposite1 = mesh.get_third_vertex( e, tri1 );
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            size_t e = pending[i];
+            
+            // a prior split may have removed this edge or fixed it already
+            if ( !edge_is_splittable(e) ) { continue; }
+            if ( large_angles ? !edge_is_opposite_large_angle(e) : !edge_is_too_long(e) ) { continue; }
+            
+            // the split replaces the two triangles incident on the edge
+            stencil[0] = mesh.m_edges[e][0];
+            stencil[1] = mesh.m_edges[e][1];
+            stencil[2] = mesh.get_third_vertex( e, mesh.get_triangle( mesh.m_edge_to_triangle_map[e][0] ) );
+            stencil[3] = mesh.get_third_vertex( e, mesh.get_triangle( mesh.m_edge_to_triangle_map[e][1] ) );
+            
+            if ( scheduler.claim_stencil( mesh, stencil ) )
+            {
+                round_edges.push_back( e );
+                round_slots.push_back( i );
+            }
+            else
+            {
+                retry[i] = 1;
+            }
+        }
         
-        // compute the angle at each opposite vertex
-        const Vec3d& opposite_point0 = m_surf.get_position(opposite0);
-        const Vec3d& opposite_point1 = m_surf.get_position(opposite1);
-        double angle0 = rad2deg( acos( dot( normalized(edge_point0-opposite_point0), normalized(edge_point1-opposite_point0) ) ) );
-        double angle1 = rad2deg( acos( dot( normalized(edge_point0-opposite_point1), normalized(edge_point1-opposite_point1) ) ) );
+        // check the round concurrently
         
-        // if an angle is above the max threshold, split the edge
+        plans.resize( round_edges.size() );
+        std::vector<char> plan_ok( round_edges.size(), 0 );
+        
+        #pragma omp parallel for schedule(dynamic) num_threads(m_surf.m_num_threads)
+        for ( int i = 0; i < (int) round_edges.size(); ++i )
+        {
+            plan_ok[i] = check_split( round_edges[i], plans[i] );
+        }
+        
+        // apply in order
         
-        if ( angle0 > m_surf.m_max_triangle_angle || angle1 > m_surf.m_max_triangle_angle )
+        region_lows.clear();
+        region_highs.clear();
+        for ( size_t i = 0; i < plans.size(); ++i )
         {
+            if ( !plan_ok[i] ) { continue; }
+            region_lows.push_back( plans[i].m_region_low );
+            region_highs.push_back( plans[i].m_region_high );
+        }
+        
+        scheduler.begin_apply( region_lows, region_highs );
+        
+        for ( size_t i = 0; i < plans.size(); ++i )
+        {
+            if ( !plan_ok[i] ) { continue; }
             
-            bool result = split_edge( e );
-            split_occurred |= result;
+            if ( !scheduler.claim_region( plans[i].m_region_low, plans[i].m_region_high ) )
+            {
+                retry[ round_slots[i] ] = 1;
+                continue;
+            }
+            
+            split_occurred |= apply_split( plans[i] );
+        }
+        
+        std::vector<size_t> next_pending;
+        for ( size_t i = 0; i < pending.size(); ++i )
+        {
+            if ( retry[i] ) { next_pending.push_back( pending[i] ); }
         }
+        pending.swap( next_pending );
     }
     
-    
     return split_occurred;
+}
+
+// --------------------------------------------------------
+///
+/// Determine if a splittable edge should be split because it's too long, or failing that, because it's opposite a large
+/// angle
+///
+// --------------------------------------------------------
+
+bool EdgeSplitter::edge_needs_split( size_t edge_index, bool& large_angle, double& length ) const
+{
+    if ( !edge_is_splittable(edge_index) ) { return false; }
+    
+    length = get_split_length( edge_index );
     
+    if ( length > m_max_edge_length )
+    {
+        large_angle = false;
+        return true;
+    }
+    
+    if ( edge_is_opposite_large_angle(edge_index) )
+    {
+        large_angle = true;
+        return true;
+    }
+    
+    return false;
 }
 
 // --------------------------------------------------------
 ///
-/// Split all long edges
+/// Split all long edges, and edges opposite large angles
+///
+/// The candidates go into a priority queue once, long edges first, longest first.  After each split, only the edges 
+/// touching the one-ring of the new vertex are re-evaluated: their lengths, curvatures and opposite angles are the only
+/// ones which changed.
 ///
 // --------------------------------------------------------
 
@@ -679,89 +971,124 @@ void EdgeSplitter::process_mesh()
     
     assert( m_max_edge_length != UNINITIALIZED_DOUBLE );
 
-    // whether a split operation was successful in this pass
-    bool split_occurred = true;
+    NonDestructiveTriMesh& mesh = m_surf.m_mesh;
     
-    while ( split_occurred )
+    if ( m_surf.m_parallel_remeshing )
     {
-    
-        split_occurred = false;
+        // rounds of independent splits are picked from the whole candidate list, so rescan until nothing splits
         
-        NonDestructiveTriMesh& mesh = m_surf.m_mesh;
-        std::vector<SortableEdge> sortable_edges_to_try;
+        bool split_occurred = true;
         
-        for( size_t i = 0; i < mesh.m_edges.size(); i++ )
-        {    
-            if ( !edge_is_splittable(i) ) { continue; }
+        while ( split_occurred )
+        {
+            std::vector<SortableEdge> sortable_edges_to_try;
             
-            size_t vertex_a = mesh.m_edges[i][0];
-            size_t vertex_b = mesh.m_edges[i][1];
+            for( size_t i = 0; i < mesh.m_edges.size(); i++ )
+            {    
+                if ( !edge_is_splittable(i) ) { continue; }
+                
+                double length = get_split_length(i);
+                
+                if ( length > m_max_edge_length )
+                {
+                    sortable_edges_to_try.push_back( SortableEdge( i, length ) );
+                }
+            }
             
-            assert( vertex_a < m_surf.get_num_vertices() );
-            assert( vertex_b < m_surf.get_num_vertices() );
+            // sort in ascending order, then iterate backwards to go from longest edge to shortest
             
-            double length;
+            std::sort( sortable_edges_to_try.begin(), sortable_edges_to_try.end() );
             
-            if ( m_use_curvature )
-            {
-                length = get_curvature_scaled_length( m_surf, vertex_a, vertex_b, 0.0, m_max_curvature_multiplier );
-            }
-            else
+            std::vector<size_t> edges;
+            for ( size_t i = sortable_edges_to_try.size(); i > 0; --i )
             {
-                length = m_surf.get_edge_length(i);
+                edges.push_back( sortable_edges_to_try[i-1].edge_index );
             }
             
-            if ( length > m_max_edge_length )
-            {
-                sortable_edges_to_try.push_back( SortableEdge( i, length ) );
-            }
+            split_occurred = split_edges_in_parallel( edges, false );
+            
+            // Now split to reduce large angles
+            
+            split_occurred |= large_angle_split_pass();
         }
         
+        return;
+    }
+    
+    //
+    // seed the queue with the current set of edges to split
+    //
+    
+    // stamp of the newest queue entry for each edge
+    std::vector<unsigned int> edge_stamps( mesh.m_edges.size(), 0 );
+    
+    std::priority_queue<QueuedSplit> queue;
+    
+    for( size_t i = 0; i < mesh.m_edges.size(); i++ )
+    {
+        bool large_angle;
+        double length;
+        
+        if ( edge_needs_split( i, large_angle, length ) )
+        {
+            queue.push( QueuedSplit( i, length, large_angle, 0 ) );
+        }
+    }
+    
+    std::vector<size_t> changed_vertices, changed_edges;
+    
+    //
+    // split the top edge until none are left
+    //
+    
+    while ( !queue.empty() )
+    {
+        QueuedSplit top = queue.top();
+        queue.pop();
+        
+        size_t e = top.edge_index;
+        
+        if ( top.stamp != edge_stamps[e] ) { continue; }    // superseded by a newer entry
+        
+        bool large_angle;
+        double length;
+        if ( !edge_needs_split( e, large_angle, length ) ) { continue; }
+        
+        size_t new_vertex;
+        if ( !split_edge( e, &new_vertex ) ) { continue; }
         
         //
-        // sort in ascending order, then iterate backwards to go from longest edge to shortest
+        // re-evaluate the edges touching the one-ring of the new vertex
         //
-            
-        std::sort( sortable_edges_to_try.begin(), sortable_edges_to_try.end() );
         
-        std::vector<SortableEdge>::reverse_iterator iter = sortable_edges_to_try.rbegin();
+        mesh.get_adjacent_vertices( new_vertex, changed_vertices );
+        changed_vertices.push_back( new_vertex );
         
-        for ( ; iter != sortable_edges_to_try.rend(); ++iter )
+        changed_edges.clear();
+        for ( size_t i = 0; i < changed_vertices.size(); ++i )
         {
-            size_t longest_edge = iter->edge_index;
-            
-            if ( !edge_is_splittable(longest_edge) ) { continue; }
-            
-            size_t vertex_a = mesh.m_edges[longest_edge][0];
-            size_t vertex_b = mesh.m_edges[longest_edge][1];
-            
-            // recompute edge length -- a prior split may have somehow fixed this edge already
-            double longest_edge_length;
+            const VertexAdjacencyList& incident_edges = mesh.m_vertex_to_edge_map[ changed_vertices[i] ];
+            changed_edges.insert( changed_edges.end(), incident_edges.begin(), incident_edges.end() );
+        }
+        
+        std::sort( changed_edges.begin(), changed_edges.end() );
+        changed_edges.erase( std::unique( changed_edges.begin(), changed_edges.end() ), changed_edges.end() );
+        
+        edge_stamps.resize( mesh.m_edges.size(), 0 );
+        
+        for ( size_t i = 0; i < changed_edges.size(); ++i )
+        {
+            size_t changed_edge = changed_edges[i];
             
-            if ( m_use_curvature )
-            {
-                longest_edge_length = get_curvature_scaled_length( m_surf, vertex_a, vertex_b, 0.0, m_max_curvature_multiplier );
-            }
-            else
-            {
-                longest_edge_length = m_surf.get_edge_length(longest_edge);
-            }
+            // invalidate any older entry, whether or not the edge still needs splitting
+            ++edge_stamps[changed_edge];
             
-            if ( longest_edge_length > m_max_edge_length )
+            if ( edge_needs_split( changed_edge, large_angle, length ) )
             {
-                // perform the actual edge split
-                bool result = split_edge( longest_edge );         
-                split_occurred |= result;
+                queue.push( QueuedSplit( changed_edge, length, large_angle, edge_stamps[changed_edge] ) );
             }
         }
-        
-        // Now split to reduce large angles
-        
-        bool large_angle_split_occurred = large_angle_split_pass();
-        
-        split_occurred |= large_angle_split_occurred;
-
-    }   // while split_occurred
+    }
     
 }
 
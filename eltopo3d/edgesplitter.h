@@ -111,9 +111,10 @@ public:
     /// Maximum edge length.  Edges longer than this will be subdivided.
     double m_max_edge_length;   
     bool edge_is_splittable( size_t edge_index ) const;
-    /// Split an edge, using subdivision_scheme to determine the new vertex location, if safe to do so.
+    /// Split an edge, using subdivision_scheme to determine the new vertex location, if safe to do so.  If new_vertex 
+    /// is given, it receives the index of the new vertex.
     ///
-    bool split_edge( size_t edge );
+    bool split_edge( size_t edge, size_t* new_vertex = NULL );
     
 private:
     
@@ -142,6 +143,41 @@ private:
     
     
     bool large_angle_split_pass();
+    
+    /// The result of checking a split: the vertices involved, where the new vertex goes, and the region of space the 
+    /// checks looked at.  Defined in edgesplitter.cpp.
+    ///
+    struct SplitPlan;
+    
+    /// Run all checks for splitting an edge, without changing the surface.  Safe to call from several threads at once.
+    ///
+    bool check_split( size_t edge, SplitPlan& plan );
+    
+    /// Carry out a split which passed check_split, unless an observer vetoes it
+    ///
+    bool apply_split( const SplitPlan& plan, size_t* new_vertex = NULL );
+    
+    /// Get the length of the edge used to decide whether to split it (scaled by curvature, if enabled)
+    ///
+    double get_split_length( size_t edge_index ) const;
+    
+    /// Whether the edge is longer than the maximum edge length (scaled by curvature, if enabled)
+    ///
+    bool edge_is_too_long( size_t edge_index ) const;
+    
+    /// Whether a splittable edge should be split because it's too long, or failing that, because it's opposite a large 
+    /// angle.  Also gets the length used to decide which edges to split first.
+    ///
+    bool edge_needs_split( size_t edge_index, bool& large_angle, double& length ) const;
+    
+    /// Whether an angle opposite the edge is larger than the maximum triangle angle
+    ///
+    bool edge_is_opposite_large_angle( size_t edge_index ) const;
+    
+    /// Split the given edges, in order, checking independent splits concurrently.  Edges are split if they are opposite
+    /// a large angle when large_angles is true, or if they are too long otherwise.
+    ///
+    bool split_edges_in_parallel( const std::vector<size_t>& edges, bool large_angles );
 
     ///
     ///
@@ -21,45 +21,54 @@ static int to_int( size_t a )
 
 // ---------------------------------------------------------
 ///
-/// Static operations: edge collapse, edge split, edge flip, null-space smoothing, and topological changes
+/// Copy a C-API mesh into the vectors used to construct a DynamicSurface
 ///
 // ---------------------------------------------------------
 
-void el_topo_static_operations( const ElTopoMesh* inputs,
-                               const struct ElTopoGeneralOptions* general_options,
-                               const struct ElTopoStaticOperationsOptions* options, 
-                               struct ElTopoDefragInformation* defrag_info,  
-                               struct ElTopoMesh* outputs )
+static void read_input_mesh( const ElTopoMesh* inputs, 
+                            std::vector<Vec3d>& vs, 
+                            std::vector<Vec3st>& ts, 
+                            std::vector<double>& masses )
 {
-    //
-    // data wrangling
-    //
-    
-    std::vector<Vec3d> vs;
-    std::vector<double> masses;
+    vs.resize( inputs->num_vertices );
+    masses.resize( inputs->num_vertices );
     
     for ( int i = 0; i < inputs->num_vertices; ++i )
     {
-        vs.push_back( Vec3d( inputs->vertex_locations[3*i], inputs->vertex_locations[3*i + 1], inputs->vertex_locations[3*i + 2] ) );
-        masses.push_back( inputs->vertex_masses[i] );      
+        vs[i] = Vec3d( inputs->vertex_locations[3*i], inputs->vertex_locations[3*i + 1], inputs->vertex_locations[3*i + 2] );
+        masses[i] = inputs->vertex_masses[i];
     }
     
-    std::vector<Vec3st> ts;
+    ts.resize( inputs->num_triangles );
     for ( int i = 0; i < inputs->num_triangles; ++i )
     {
-        ts.push_back( Vec3st( inputs->triangles[3*i], inputs->triangles[3*i + 1], inputs->triangles[3*i + 2] ) );
+        ts[i] = Vec3st( inputs->triangles[3*i], inputs->triangles[3*i + 1], inputs->triangles[3*i + 2] );
     }
-    
-    
-    // =================================================================================
-    
-    //
-    // do the actual operations
-    //
-    
-    // build a SurfTrack
-    SurfTrackInitializationParameters construction_parameters;
-    
+}
+
+// ---------------------------------------------------------
+///
+/// Map the C-API backend option onto the collision query backend
+///
+// ---------------------------------------------------------
+
+static CCDBackendType ccd_backend_from_option( int ccd_backend )
+{
+    assert( ccd_backend == ELTOPO_CCD_CUBIC_SOLVER || ccd_backend == ELTOPO_CCD_ROOT_PARITY );
+    return ( ccd_backend == ELTOPO_CCD_ROOT_PARITY ) ? CCD_BACKEND_ROOT_PARITY : CCD_BACKEND_CUBIC_SOLVER;
+}
+
+// ---------------------------------------------------------
+///
+/// Fill in SurfTrack construction parameters from the C-API option structures
+///
+// ---------------------------------------------------------
+
+static void set_construction_parameters( const struct ElTopoGeneralOptions* general_options,
+                                        const struct ElTopoStaticOperationsOptions* options,
+                                        SurfTrackInitializationParameters& construction_parameters )
+{
+    construction_parameters.m_verbose = ( general_options->m_verbose != 0 );
     construction_parameters.m_proximity_epsilon = general_options->m_proximity_epsilon;
     
     construction_parameters.m_use_fraction = false;
@@ -76,22 +85,20 @@ void el_topo_static_operations( const ElTopoMesh* inputs,
     construction_parameters.m_edge_flip_min_length_change = options->m_edge_flip_min_length_change;   
     construction_parameters.m_merge_proximity_epsilon = options->m_merge_proximity_epsilon;
     construction_parameters.m_collision_safety = general_options->m_collision_safety;
+    construction_parameters.m_ccd_backend = ccd_backend_from_option( general_options->m_ccd_backend );
     construction_parameters.m_allow_topology_changes = options->m_allow_topology_changes;
     construction_parameters.m_perform_improvement = options->m_perform_improvement;
     construction_parameters.m_subdivision_scheme = std::shared_ptr<SubdivisionScheme>((SubdivisionScheme*)options->m_subdivision_scheme);
-    
-    SurfTrack surface_tracker( vs, ts, masses, construction_parameters ); 
-    
-    surface_tracker.improve_mesh();
-    
-    // do merging
-    surface_tracker.topology_changes();
-    
-    surface_tracker.defrag_mesh();
-    
-    
-    // =================================================================================
-    
+}
+
+// ---------------------------------------------------------
+///
+/// Copy the change histories and defrag maps of a SurfTrack into a C-API structure, allocating its arrays
+///
+// ---------------------------------------------------------
+
+static void write_defrag_info( const SurfTrack& surface_tracker, struct ElTopoDefragInformation* defrag_info )
+{
     defrag_info->num_vertex_changes = to_int(surface_tracker.m_vertex_change_history.size());
     defrag_info->vertex_is_remove = (int*) malloc( defrag_info->num_vertex_changes * sizeof(int) );
     defrag_info->vertex_index = (int*) malloc( defrag_info->num_vertex_changes * sizeof(int) );
@@ -119,26 +126,72 @@ void el_topo_static_operations( const ElTopoMesh* inputs,
         defrag_info->new_tri[3*i+2] = to_int(surface_tracker.m_triangle_change_history[i].tri[2]);
     }
     
+    const std::vector<Vec2st>& triangle_map = surface_tracker.m_last_defrag_info.m_defragged_triangle_map;
+    defrag_info->defragged_triangle_map_size = to_int(triangle_map.size());
+    defrag_info->defragged_triangle_map = (int*) malloc( 2 * defrag_info->defragged_triangle_map_size * sizeof(int)  );
+    
+    for ( int i = 0; i < defrag_info->defragged_triangle_map_size; ++i )
+    {
+        defrag_info->defragged_triangle_map[2*i+0] = to_int(triangle_map[i][0]);
+        defrag_info->defragged_triangle_map[2*i+1] = to_int(triangle_map[i][1]);
+    }
+    
+    const std::vector<Vec2st>& vertex_map = surface_tracker.m_last_defrag_info.m_defragged_vertex_map;
+    defrag_info->defragged_vertex_map_size = to_int(vertex_map.size());
+    defrag_info->defragged_vertex_map = (int*) malloc( 2 * defrag_info->defragged_vertex_map_size * sizeof(int) );
+    
+    for ( int i = 0; i < defrag_info->defragged_vertex_map_size; ++i )
+    {
+        defrag_info->defragged_vertex_map[2*i+0] = to_int(vertex_map[i][0]);
+        defrag_info->defragged_vertex_map[2*i+1] = to_int(vertex_map[i][1]);
+    }
+}
 
-    assert( "Mesh defrag info not present in C-API" );
-    
-//    defrag_info->defragged_triangle_map_size = to_int(surface_tracker.m_defragged_triangle_map.size());
-//    defrag_info->defragged_triangle_map = (int*) malloc( 2 * defrag_info->defragged_triangle_map_size * sizeof(int)  );
-//    
-//    for ( int i = 0; i < defrag_info->defragged_triangle_map_size; ++i )
-//    {
-//        defrag_info->defragged_triangle_map[2*i+0] = to_int(surface_tracker.m_defragged_triangle_map[i][0]);
-//        defrag_info->defragged_triangle_map[2*i+1] = to_int(surface_tracker.m_defragged_triangle_map[i][1]);
-//    }
-//    
-//    defrag_info->defragged_vertex_map_size = to_int(surface_tracker.m_defragged_vertex_map.size());
-//    defrag_info->defragged_vertex_map = (int*) malloc( 2 * defrag_info->defragged_vertex_map_size * sizeof(int) );
-//    
-//    for ( int i = 0; i < defrag_info->defragged_vertex_map_size; ++i )
-//    {
-//        defrag_info->defragged_vertex_map[2*i+0] = to_int(surface_tracker.m_defragged_vertex_map[i][0]);
-//        defrag_info->defragged_vertex_map[2*i+1] = to_int(surface_tracker.m_defragged_vertex_map[i][1]);
-//    }
+// ---------------------------------------------------------
+///
+/// Static operations: edge collapse, edge split, edge flip, null-space smoothing, and topological changes
+///
+// ---------------------------------------------------------
+
+void el_topo_static_operations( const ElTopoMesh* inputs,
+                               const struct ElTopoGeneralOptions* general_options,
+                               const struct ElTopoStaticOperationsOptions* options, 
+                               struct ElTopoDefragInformation* defrag_info,  
+                               struct ElTopoMesh* outputs )
+{
+    //
+    // data wrangling
+    //
+    
+    std::vector<Vec3d> vs;
+    std::vector<Vec3st> ts;
+    std::vector<double> masses;
+    read_input_mesh( inputs, vs, ts, masses );
+    
+    
+    // =================================================================================
+    
+    //
+    // do the actual operations
+    //
+    
+    // build a SurfTrack
+    SurfTrackInitializationParameters construction_parameters;
+    set_construction_parameters( general_options, options, construction_parameters );
+    
+    SurfTrack surface_tracker( vs, ts, masses, construction_parameters ); 
+    
+    surface_tracker.improve_mesh();
+    
+    // do merging
+    surface_tracker.topology_changes();
+    
+    surface_tracker.defrag_mesh();
+    
+    
+    // =================================================================================
+    
+    write_defrag_info( surface_tracker, defrag_info );
     
     // =================================================================================
     
@@ -185,6 +238,18 @@ void el_topo_free_static_operations_results( ElTopoMesh* outputs, struct ElTopoD
     free( outputs->vertex_masses );
     free( outputs->triangles );
     
+    el_topo_free_defrag_info( defrag_info );
+}
+
+
+// ---------------------------------------------------------
+///
+/// Free the arrays of a defrag information structure.
+///
+// ---------------------------------------------------------
+
+void el_topo_free_defrag_info( struct ElTopoDefragInformation* defrag_info )
+{
     free( defrag_info->vertex_is_remove );
     free( defrag_info->vertex_index );
     free( defrag_info->split_edge );
@@ -243,6 +308,8 @@ void el_topo_integrate( const ElTopoMesh* inputs,
                                    general_options->m_collision_safety, 
                                    general_options->m_verbose );
     
+    dynamic_surface.m_ccd_backend = ccd_backend_from_option( general_options->m_ccd_backend );
+    
     dynamic_surface.set_all_newpositions( inputs->num_vertices, in_vertex_new_locations );
     
     // advance by dt
@@ -260,13 +327,7 @@ void el_topo_integrate( const ElTopoMesh* inputs,
     //
     
     *out_vertex_locations = (double*) malloc( 3 * inputs->num_vertices * sizeof(double) );
-    for ( int i = 0; i < inputs->num_vertices; ++i )
-    {
-        const Vec3d& pos = dynamic_surface.get_position(i);
-        (*out_vertex_locations)[3*i]     = pos[0];
-        (*out_vertex_locations)[3*i + 1] = pos[1];
-        (*out_vertex_locations)[3*i + 2] = pos[2];
-    }
+    dynamic_surface.get_all_positions( *out_vertex_locations );
     
 }
 
@@ -285,3 +346,169 @@ void el_topo_free_integrate_results( double* out_vertex_locations )
 
 
 
+
+
+// ---------------------------------------------------------
+///
+/// A surface kept resident between calls of the persistent C API.
+///
+// ---------------------------------------------------------
+
+struct ElTopoSurface
+{
+    ElTopoSurface( const std::vector<Vec3d>& vs, 
+                  const std::vector<Vec3st>& ts, 
+                  const std::vector<double>& masses,
+                  const SurfTrackInitializationParameters& construction_parameters ) :
+        m_surface_tracker( vs, ts, masses, construction_parameters ),
+        m_vertex_stride( 3 )
+    {}
+    
+    SurfTrack m_surface_tracker;
+    
+    /// Distance, in doubles, between consecutive vertices in the caller's location arrays
+    size_t m_vertex_stride;
+};
+
+
+// ---------------------------------------------------------
+///
+/// Create a persistent surface.
+///
+// ---------------------------------------------------------
+
+ElTopoSurface* el_topo_create( const struct ElTopoMesh* inputs,
+                              const struct ElTopoGeneralOptions* general_options,
+                              const struct ElTopoStaticOperationsOptions* options )
+{
+    std::vector<Vec3d> vs;
+    std::vector<Vec3st> ts;
+    std::vector<double> masses;
+    read_input_mesh( inputs, vs, ts, masses );
+    
+    SurfTrackInitializationParameters construction_parameters;
+    set_construction_parameters( general_options, options, construction_parameters );
+    
+    return new ElTopoSurface( vs, ts, masses, construction_parameters );
+}
+
+
+// ---------------------------------------------------------
+///
+/// Integrate, then perform static operations, reusing the resident surface.
+///
+// ---------------------------------------------------------
+
+void el_topo_step( ElTopoSurface* surface,
+                  const double* in_vertex_new_locations,
+                  const struct ElTopoIntegrationOptions* options,
+                  double* out_dt,
+                  struct ElTopoDefragInformation* out_defrag_info )
+{
+    assert( surface != NULL );
+    SurfTrack& surface_tracker = surface->m_surface_tracker;
+    
+    // change histories only cover the current step
+    surface_tracker.m_vertex_change_history.clear();
+    surface_tracker.m_triangle_change_history.clear();
+    
+    double actual_dt = 0.0;
+    
+    if ( in_vertex_new_locations != NULL )
+    {
+        surface_tracker.m_collision_pipeline.m_friction_coefficient = options->m_friction_coefficient;
+        surface_tracker.set_all_newpositions( surface_tracker.get_num_vertices(), in_vertex_new_locations, surface->m_vertex_stride );
+        surface_tracker.integrate( options->m_dt, actual_dt );
+    }
+    
+    if ( out_dt != NULL )
+    {
+        *out_dt = actual_dt;
+    }
+    
+    surface_tracker.improve_mesh();
+    surface_tracker.topology_changes();
+    surface_tracker.defrag_mesh();
+    
+    if ( out_defrag_info != NULL )
+    {
+        write_defrag_info( surface_tracker, out_defrag_info );
+    }
+}
+
+
+// ---------------------------------------------------------
+
+int el_topo_get_num_vertices( const ElTopoSurface* surface )
+{
+    return to_int( surface->m_surface_tracker.get_num_vertices() );
+}
+
+
+// ---------------------------------------------------------
+
+int el_topo_get_num_triangles( const ElTopoSurface* surface )
+{
+    return to_int( surface->m_surface_tracker.m_mesh.num_triangles() );
+}
+
+
+// ---------------------------------------------------------
+
+void el_topo_set_vertex_stride( ElTopoSurface* surface, int stride )
+{
+    assert( stride >= 3 );
+    surface->m_vertex_stride = static_cast<size_t>(stride);
+}
+
+
+// ---------------------------------------------------------
+///
+/// Copy the current mesh into caller-provided buffers.
+///
+// ---------------------------------------------------------
+
+void el_topo_get_mesh( const ElTopoSurface* surface,
+                      double* out_vertex_locations,
+                      int* out_triangles,
+                      double* out_vertex_masses )
+{
+    const SurfTrack& surface_tracker = surface->m_surface_tracker;
+    const size_t num_vertices = surface_tracker.get_num_vertices();
+    
+    if ( out_vertex_locations != NULL )
+    {
+        surface_tracker.get_all_positions( out_vertex_locations, surface->m_vertex_stride );
+    }
+    
+    if ( out_vertex_masses != NULL )
+    {
+        for ( size_t i = 0; i < num_vertices; ++i )
+        {
+            out_vertex_masses[i] = surface_tracker.m_masses[i];
+        }
+    }
+    
+    if ( out_triangles != NULL )
+    {
+        const std::vector<Vec3st>& tris = surface_tracker.m_mesh.get_triangles();
+        for ( size_t i = 0; i < tris.size(); ++i )
+        {
+            out_triangles[3*i + 0] = to_int(tris[i][0]);
+            out_triangles[3*i + 1] = to_int(tris[i][1]);
+            out_triangles[3*i + 2] = to_int(tris[i][2]);
+        }
+    }
+}
+
+
+// ---------------------------------------------------------
+///
+/// Release a persistent surface.
+///
+// ---------------------------------------------------------
+
+void el_topo_destroy( ElTopoSurface* surface )
+{
+    delete surface;
+}
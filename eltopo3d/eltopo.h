@@ -35,6 +35,17 @@ extern "C" {
         
         double m_proximity_epsilon;
         
+        int m_ccd_backend;           // collision and intersection queries to use:
+        // ELTOPO_CCD_CUBIC_SOLVER or ELTOPO_CCD_ROOT_PARITY
+        
+    };
+    
+    // Values for ElTopoGeneralOptions::m_ccd_backend
+    
+    enum ElTopoCCDBackend
+    {
+        ELTOPO_CCD_CUBIC_SOLVER = 0,      // fast, uses a small collision tolerance
+        ELTOPO_CCD_ROOT_PARITY = 1        // exact, slower
     };
     
     // ---------------------------------------------------------
@@ -138,7 +149,9 @@ extern "C" {
     
     // ---------------------------------------------------------
     ///
-    /// 
+    /// Vertices and triangles added and removed by static operations, and 
+    /// where the surviving ones ended up when the mesh was defragmented.
+    /// The defragged maps hold (old index, new index) pairs.
     ///
     // ---------------------------------------------------------
     
@@ -261,6 +274,132 @@ extern "C" {
     void el_topo_free_integrate_results( double* out_vertex_locations );
     
     
+    // =========================================================
+    //  PERSISTENT SURFACE API
+    // =========================================================   
+    
+    // ---------------------------------------------------------
+    ///
+    /// Opaque handle to a surface which stays resident between calls, so 
+    /// the mesh connectivity and collision acceleration structures are 
+    /// built once rather than on every step.
+    ///
+    // ---------------------------------------------------------
+    
+    typedef struct ElTopoSurface ElTopoSurface;
+    
+    // ---------------------------------------------------------
+    ///
+    /// Create a persistent surface from the input mesh.  The mesh is not
+    /// modified until the first call to el_topo_step.
+    ///
+    /// Parameters:
+    ///   inputs                     (Input) Initial mesh.  Copied; the caller 
+    ///                                      keeps ownership of the arrays.
+    ///   general_otions             (Input) Structure specifying options common to
+    ///                                      static operations and integration.
+    ///   options                    (Input) Static operations options, used by
+    ///                                      every subsequent step.  As with
+    ///                                      el_topo_static_operations, the 
+    ///                                      surface takes ownership of 
+    ///                                      m_subdivision_scheme.
+    ///
+    /// Returns a handle which must be released with el_topo_destroy.
+    ///
+    // ---------------------------------------------------------
+    
+    ElTopoSurface* el_topo_create( const struct ElTopoMesh* inputs,
+                                  const struct ElTopoGeneralOptions* general_options,
+                                  const struct ElTopoStaticOperationsOptions* options );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Advance the surface by one step: integrate vertex positions toward the
+    /// predicted locations, then perform static operations and defragment.
+    ///
+    /// Parameters:
+    ///   surface                    (Input/Output) Handle from el_topo_create.
+    ///   in_vertex_new_locations:   (Input) Predicted vertex coordinates, one 
+    ///                                      triple for each vertex of the mesh
+    ///                                      as of the previous step.  May be 
+    ///                                      NULL to skip integration.
+    ///   options                    (Input) Structure specifying options specific 
+    ///                                      to integration.
+    ///   out_dt                     (Output) Actual timestep used during 
+    ///                                       integration (0 if skipped).
+    ///   out_defrag_info            (Output, arrays allocated by El Topo) 
+    ///                                       Changes made during this step and 
+    ///                                       the defrag maps, as returned by 
+    ///                                       el_topo_static_operations.  May be 
+    ///                                       NULL.  Release with 
+    ///                                       el_topo_free_defrag_info.
+    ///
+    // ---------------------------------------------------------
+    
+    void el_topo_step( ElTopoSurface* surface,
+                      const double* in_vertex_new_locations,
+                      const struct ElTopoIntegrationOptions* options,
+                      double* out_dt,
+                      struct ElTopoDefragInformation* out_defrag_info );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Free the arrays of defrag information returned by el_topo_step.
+    ///
+    // ---------------------------------------------------------
+    
+    void el_topo_free_defrag_info( struct ElTopoDefragInformation* defrag_info );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Current mesh size, for sizing the buffers passed to el_topo_get_mesh.
+    ///
+    // ---------------------------------------------------------
+    
+    int el_topo_get_num_vertices( const ElTopoSurface* surface );
+    int el_topo_get_num_triangles( const ElTopoSurface* surface );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Set the layout of the caller's vertex location arrays used by 
+    /// el_topo_step and el_topo_get_mesh: vertex i is at elements 
+    /// stride*i, stride*i+1 and stride*i+2.  Lets hosts pass positions 
+    /// that are interleaved with other per-vertex data without repacking 
+    /// them.  Defaults to 3 (tightly packed).
+    ///
+    // ---------------------------------------------------------
+    
+    void el_topo_set_vertex_stride( ElTopoSurface* surface, int stride );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Copy the current mesh into caller-provided buffers.
+    ///
+    /// Parameters:
+    ///   out_vertex_locations       (Output, allocated by caller) at least 
+    ///                                       stride * (num_vertices-1) + 3 
+    ///                                       doubles, or NULL.
+    ///   out_triangles              (Output, allocated by caller) 3 * num_triangles
+    ///                                       ints, or NULL.
+    ///   out_vertex_masses          (Output, allocated by caller) num_vertices 
+    ///                                       doubles, or NULL.
+    ///
+    // ---------------------------------------------------------
+    
+    void el_topo_get_mesh( const ElTopoSurface* surface,
+                          double* out_vertex_locations,
+                          int* out_triangles,
+                          double* out_vertex_masses );
+    
+    // ---------------------------------------------------------
+    ///
+    /// Release a surface created by el_topo_create.
+    ///
+    // ---------------------------------------------------------
+    
+    void el_topo_destroy( ElTopoSurface* surface );
+    
+    
 #ifdef __cplusplus
 }
 #endif
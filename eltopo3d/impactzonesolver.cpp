@@ -12,25 +12,61 @@
 #include "../common/ccd_wrapper.h"
 #include "dynamicsurface.h"
 #include "impactzonesolver.h"
+#include <algorithm>
 #include "../common/newsparse/krylov_solvers.h"
+#include "../common/lapack_wrapper.h"
 #include "../common/mat.h"
+#include "../common/newsparse/preconditioners.h"
 #include "../common/newsparse/sparse_matrix.h"
 #include "../common/runstats.h"
+#include "../common/wallclocktime.h"
 
 namespace 
 {
     
-    /// Combine impact zones which have overlapping vertex stencils
+    // ---------------------------------------------------------
+    ///
+    /// Gradient of the constraints of an impact zone, G.  Row i of G is the gradient of collision i, which has a 3-vector 
+    /// entry for each of the collision's four vertices.  Entry 4*i+v belongs to vertex v of collision i.
     ///
-    void merge_impact_zones( std::vector<ImpactZone>& new_impact_zones, std::vector<ImpactZone>& master_impact_zones );
+    // ---------------------------------------------------------
     
-    /// Helper function: multiply transpose(A) * D * B
+    struct ConstraintGradient
+    {
+        /// Position of each entry's vertex in the zone's vertex list
+        std::vector<size_t> m_local_vertex;
+        
+        /// Barycentric coordinate times collision normal
+        std::vector<Vec3d> m_value;
+        
+        /// The entries of local vertex j are m_vertex_entries[m_vertex_start[j]] to m_vertex_entries[m_vertex_start[j+1]-1]
+        std::vector<size_t> m_vertex_start;
+        std::vector<size_t> m_vertex_entries;
+    };
+    
+    /// Find the representative of a set in a disjoint-set forest
     ///
-    void AtDB(const SparseMatrixDynamicCSR &A, const double* diagD, const SparseMatrixDynamicCSR &B, SparseMatrixDynamicCSR &C);
+    size_t find_set( std::vector<size_t>& parent, size_t i );
     
-    /// Overflow-checked cast to integer
+    /// Join two sets in a disjoint-set forest
     ///
-    int to_int( ptrdiff_t a );
+    void union_sets( std::vector<size_t>& parent, std::vector<size_t>& set_size, size_t i, size_t j );
+    
+    /// Combine existing impact zones and new collisions into zones which don't share vertices
+    ///
+    void merge_impact_zones( const std::vector<Collision>& new_collisions, std::vector<ImpactZone>& impact_zones );
+    
+    /// Assemble the constraint gradient of an impact zone
+    ///
+    void build_constraint_gradient( const ImpactZone& iz, ConstraintGradient& G );
+    
+    /// Form G * M^(-1) * G^T as a dense, column-major matrix
+    ///
+    void form_dense_normal_matrix( const ConstraintGradient& G, const std::vector<double>& inv_masses, size_t k, std::vector<double>& A );
+    
+    /// Form G * M^(-1) * G^T as a sparse matrix
+    ///
+    void form_sparse_normal_matrix( const ConstraintGradient& G, const std::vector<double>& inv_masses, size_t k, SparseMatrixStaticCSR& A );
     
     /// Overflow-checked cast to integer
     ///
@@ -39,133 +75,297 @@ namespace
     
     // ---------------------------------------------------------
     ///
-    /// Combine impact zones which have overlapping vertex stencils
+    /// Find the representative of a set in a disjoint-set forest, halving the path on the way
+    ///
+    // ---------------------------------------------------------
+    
+    size_t find_set( std::vector<size_t>& parent, size_t i )
+    {
+        while ( parent[i] != i )
+        {
+            parent[i] = parent[ parent[i] ];
+            i = parent[i];
+        }
+        return i;
+    }
+    
+    // ---------------------------------------------------------
+    ///
+    /// Join the sets containing i and j, hanging the smaller set off the larger
     ///
     // ---------------------------------------------------------
     
-    void merge_impact_zones( std::vector<ImpactZone>& new_impact_zones, std::vector<ImpactZone>& master_impact_zones )
+    void union_sets( std::vector<size_t>& parent, std::vector<size_t>& set_size, size_t i, size_t j )
     {
+        i = find_set( parent, i );
+        j = find_set( parent, j );
         
-        bool merge_ocurred = true;
+        if ( i == j ) { return; }
         
-        for ( size_t i = 0; i < master_impact_zones.size(); ++i )
+        if ( set_size[i] < set_size[j] ) { std::swap( i, j ); }
+        
+        parent[j] = i;
+        set_size[i] += set_size[j];
+    }
+    
+    // ---------------------------------------------------------
+    ///
+    /// Orders collisions by their sorted vertex indices, then by position in the list of collisions, so that collisions 
+    /// with the same vertices end up next to each other, earliest first.
+    ///
+    // ---------------------------------------------------------
+    
+    struct CollisionVerticesLess
+    {
+        CollisionVerticesLess( const std::vector<Vec4st>& keys ) : m_keys( keys ) {}
+        
+        bool operator()( size_t a, size_t b ) const
         {
-            master_impact_zones[i].m_all_solved = true;
+            for ( unsigned int i = 0; i < 4; ++i )
+            {
+                if ( m_keys[a][i] != m_keys[b][i] ) { return m_keys[a][i] < m_keys[b][i]; }
+            }
+            return a < b;
         }
         
-        for ( size_t i = 0; i < new_impact_zones.size(); ++i )
+        const std::vector<Vec4st>& m_keys;
+    };
+    
+    // ---------------------------------------------------------
+    ///
+    /// Combine the existing impact zones and the new collisions into zones which don't share vertices.  Collisions which 
+    /// share a vertex are joined in a disjoint-set forest over the vertex indices, so this takes near-linear time.  A new 
+    /// collision with the same vertices as a collision already in its zone is dropped.  A zone is marked as solved if 
+    /// every collision in it came from an existing zone.
+    ///
+    // ---------------------------------------------------------
+    
+    void merge_impact_zones( const std::vector<Collision>& new_collisions, std::vector<ImpactZone>& impact_zones )
+    {
+        
+        // existing collisions first, so that they take precedence over new collisions with the same vertices
+        
+        std::vector<Collision> collisions;
+        for ( size_t i = 0; i < impact_zones.size(); ++i )
         {
-            new_impact_zones[i].m_all_solved = false;
+            collisions.insert( collisions.end(), impact_zones[i].m_collisions.begin(), impact_zones[i].m_collisions.end() );
         }
         
-        while ( merge_ocurred )
+        const size_t num_old_collisions = collisions.size();
+        collisions.insert( collisions.end(), new_collisions.begin(), new_collisions.end() );
+        
+        // drop repeated collisions
+        
+        std::vector<Vec4st> keys( collisions.size() );
+        std::vector<size_t> order( collisions.size() );
+        for ( size_t i = 0; i < collisions.size(); ++i )
         {
+            keys[i] = collisions[i].m_vertex_indices;
+            std::sort( keys[i].v, keys[i].v + 4 );
+            order[i] = i;
+        }
+        
+        std::sort( order.begin(), order.end(), CollisionVerticesLess( keys ) );
+        
+        std::vector<char> is_repeated( collisions.size(), false );
+        for ( size_t i = 1; i < order.size(); ++i )
+        {
+            is_repeated[ order[i] ] = ( keys[ order[i] ] == keys[ order[i-1] ] );
+        }
+        
+        // compact the vertex indices
+        
+        std::vector<size_t> vertices;
+        vertices.reserve( 4 * collisions.size() );
+        for ( size_t i = 0; i < collisions.size(); ++i )
+        {
+            vertices.insert( vertices.end(), keys[i].v, keys[i].v + 4 );
+        }
+        
+        std::sort( vertices.begin(), vertices.end() );
+        vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+        
+        std::vector<size_t> collision_first_vertex( collisions.size() );
+        
+        std::vector<size_t> parent( vertices.size() ), set_size( vertices.size(), 1 );
+        for ( size_t i = 0; i < vertices.size(); ++i ) { parent[i] = i; }
+        
+        for ( size_t i = 0; i < collisions.size(); ++i )
+        {
+            size_t local[4];
+            for ( unsigned int v = 0; v < 4; ++v )
+            {
+                local[v] = std::lower_bound( vertices.begin(), vertices.end(), keys[i][v] ) - vertices.begin();
+            }
+            
+            union_sets( parent, set_size, local[0], local[1] );
+            union_sets( parent, set_size, local[0], local[2] );
+            union_sets( parent, set_size, local[0], local[3] );
             
-            merge_ocurred = false;
+            collision_first_vertex[i] = local[0];
+        }
+        
+        // one zone per set, in order of each set's first collision
+        
+        std::vector<size_t> zone_of_set( vertices.size(), static_cast<size_t>(~0) );
+        std::vector<ImpactZone> merged_zones;
+        
+        for ( size_t i = 0; i < collisions.size(); ++i )
+        {
+            size_t set = find_set( parent, collision_first_vertex[i] );
             
-            for ( size_t i = 0; i < new_impact_zones.size(); ++i )
+            if ( zone_of_set[set] == static_cast<size_t>(~0) )
             {
-                bool i_is_disjoint = true;
-                
-                for ( size_t j = 0; j < master_impact_zones.size(); ++j )
-                {
-                    // check if impact zone i and j share any vertices
-                    
-                    if ( master_impact_zones[j].share_vertices( new_impact_zones[i] ) )
-                    {
-                        
-                        bool found_new_collision = false;
-                        
-                        // steal all of j's collisions
-                        for ( size_t c = 0; c < new_impact_zones[i].m_collisions.size(); ++c )
-                        {
-                            
-                            bool same_collision_exists = false;
-                            
-                            for ( size_t m = 0; m < master_impact_zones[j].m_collisions.size(); ++m )
-                            {                 
-                                if ( master_impact_zones[j].m_collisions[m].same_vertices( new_impact_zones[i].m_collisions[c] ) )
-                                {
-                                    
-                                    same_collision_exists = true;
-                                    break;
-                                }
-                                
-                            }
-                            
-                            if ( !same_collision_exists )
-                            {
-                                master_impact_zones[j].m_collisions.push_back( new_impact_zones[i].m_collisions[c] );
-                                found_new_collision = true;
-                            }
-                        }
-                        
-                        // did we find any collisions in zone i that zone j didn't already have?
-                        if ( found_new_collision )
-                        {
-                            master_impact_zones[j].m_all_solved &= new_impact_zones[i].m_all_solved;
-                        }
-                        
-                        merge_ocurred = true;
-                        i_is_disjoint = false;
-                        break;
-                    }
-                    
-                }     // end for(j)
-                
-                if ( i_is_disjoint )
-                {
-                    // copy the impact zone
-                    
-                    ImpactZone new_zone;
-                    for ( size_t c = 0; c < new_impact_zones[i].m_collisions.size(); ++c )
-                    {
-                        new_zone.m_collisions.push_back( new_impact_zones[i].m_collisions[c] );
-                    }
-                    
-                    new_zone.m_all_solved = new_impact_zones[i].m_all_solved;
-                    
-                    master_impact_zones.push_back( new_zone );
-                }
-            }     // end for(i)
+                zone_of_set[set] = merged_zones.size();
+                merged_zones.push_back( ImpactZone() );
+                merged_zones.back().m_all_solved = true;
+            }
             
-            new_impact_zones = master_impact_zones;
-            master_impact_zones.clear();
+            if ( is_repeated[i] ) { continue; }
             
-        }  // while
+            ImpactZone& zone = merged_zones[ zone_of_set[set] ];
+            zone.m_collisions.push_back( collisions[i] );
+            
+            if ( i >= num_old_collisions )
+            {
+                zone.m_all_solved = false;
+            }
+        }
         
-        master_impact_zones = new_impact_zones;
+        // vertices are visited in sorted order, so each zone's vertex list comes out sorted
+        
+        for ( size_t i = 0; i < vertices.size(); ++i )
+        {
+            merged_zones[ zone_of_set[ find_set( parent, i ) ] ].m_vertices.push_back( vertices[i] );
+        }
+        
+        impact_zones.swap( merged_zones );
         
     }
     
     // ---------------------------------------------------------
     ///
-    /// Helper function: multiply transpose(A) * D * B
+    /// Assemble the constraint gradient of an impact zone, and the lists of entries belonging to each zone vertex
     ///
     // ---------------------------------------------------------
     
-    void AtDB(const SparseMatrixDynamicCSR &A, const double* diagD, const SparseMatrixDynamicCSR &B, SparseMatrixDynamicCSR &C)
+    void build_constraint_gradient( const ImpactZone& iz, ConstraintGradient& G )
     {
-        assert(A.m==B.m);
-        C.resize(A.n, B.n);
-        C.set_zero();
-        for(int k=0; k<A.m; ++k)
+        const std::vector<size_t>& zone_vertices = iz.m_vertices;
+        const size_t num_entries = 4 * iz.m_collisions.size();
+        
+        G.m_local_vertex.resize( num_entries );
+        G.m_value.resize( num_entries );
+        G.m_vertex_start.assign( zone_vertices.size() + 1, 0 );
+        
+        for ( size_t i = 0; i < iz.m_collisions.size(); ++i )
         {
-            const DynamicSparseVector& r = A.row[k];
+            const Collision& coll = iz.m_collisions[i];
             
-            for( DynamicSparseVector::const_iterator p=r.begin(); p != r.end(); ++p )
+            for ( unsigned int v = 0; v < 4; ++v )
             {
-                int i = p->index;
-                double multiplier = p->value * diagD[k];
-                C.add_sparse_row( i, B.row[k], multiplier );
+                // zone vertices are sorted, so this is the map from vertex index to position in the zone
+                std::vector<size_t>::const_iterator iter = std::lower_bound( zone_vertices.begin(), zone_vertices.end(), coll.m_vertex_indices[v] );
+                assert( iter != zone_vertices.end() && *iter == coll.m_vertex_indices[v] );
+                
+                size_t local = iter - zone_vertices.begin();
+                G.m_local_vertex[4*i+v] = local;
+                G.m_value[4*i+v] = coll.m_barycentric_coordinates[v] * coll.m_normal;
+                ++G.m_vertex_start[local+1];
             }
         }
+        
+        for ( size_t j = 0; j < zone_vertices.size(); ++j )
+        {
+            G.m_vertex_start[j+1] += G.m_vertex_start[j];
+        }
+        
+        std::vector<size_t> next_entry( G.m_vertex_start.begin(), G.m_vertex_start.end() - 1 );
+        G.m_vertex_entries.resize( num_entries );
+        
+        for ( size_t e = 0; e < num_entries; ++e )
+        {
+            G.m_vertex_entries[ next_entry[ G.m_local_vertex[e] ]++ ] = e;
+        }
     }
     
-    int to_int( ptrdiff_t a )
+    // ---------------------------------------------------------
+    ///
+    /// Form G * M^(-1) * G^T as a dense, column-major matrix.  Two collisions are coupled through each vertex they share.
+    ///
+    // ---------------------------------------------------------
+    
+    void form_dense_normal_matrix( const ConstraintGradient& G, const std::vector<double>& inv_masses, size_t k, std::vector<double>& A )
     {
-        assert( a < INT_MAX );
-        return static_cast<int>(a);
+        A.assign( k * k, 0.0 );
+        
+        for ( size_t j = 0; j + 1 < G.m_vertex_start.size(); ++j )
+        {
+            for ( size_t a = G.m_vertex_start[j]; a < G.m_vertex_start[j+1]; ++a )
+            {
+                size_t ea = G.m_vertex_entries[a];
+                
+                for ( size_t b = G.m_vertex_start[j]; b < G.m_vertex_start[j+1]; ++b )
+                {
+                    size_t eb = G.m_vertex_entries[b];
+                    A[ (eb/4) * k + ea/4 ] += inv_masses[j] * dot( G.m_value[ea], G.m_value[eb] );
+                }
+            }
+        }
+    }
+    
+    // ---------------------------------------------------------
+    ///
+    /// Form G * M^(-1) * G^T as a sparse matrix, one row at a time
+    ///
+    // ---------------------------------------------------------
+    
+    void form_sparse_normal_matrix( const ConstraintGradient& G, const std::vector<double>& inv_masses, size_t k, SparseMatrixStaticCSR& A )
+    {
+        A.resize( to_int(k), to_int(k) );
+        A.colindex.clear();
+        A.value.clear();
+        A.rowstart[0] = 0;
+        
+        std::vector<double> row_values( k, 0.0 );
+        std::vector<size_t> row_marker( k, static_cast<size_t>(~0) );
+        std::vector<int> row_columns;
+        
+        for ( size_t i = 0; i < k; ++i )
+        {
+            row_columns.clear();
+            
+            for ( unsigned int v = 0; v < 4; ++v )
+            {
+                size_t ea = 4*i + v;
+                size_t j = G.m_local_vertex[ea];
+                
+                for ( size_t b = G.m_vertex_start[j]; b < G.m_vertex_start[j+1]; ++b )
+                {
+                    size_t eb = G.m_vertex_entries[b];
+                    size_t column = eb / 4;
+                    
+                    if ( row_marker[column] != i )
+                    {
+                        row_marker[column] = i;
+                        row_values[column] = 0.0;
+                        row_columns.push_back( to_int(column) );
+                    }
+                    
+                    row_values[column] += inv_masses[j] * dot( G.m_value[ea], G.m_value[eb] );
+                }
+            }
+            
+            std::sort( row_columns.begin(), row_columns.end() );
+            
+            for ( size_t c = 0; c < row_columns.size(); ++c )
+            {
+                A.colindex.push_back( row_columns[c] );
+                A.value.push_back( row_values[ row_columns[c] ] );
+            }
+            
+            A.rowstart[i+1] = to_int( A.colindex.size() );
+        }
     }
     
     int to_int( size_t a )
@@ -177,6 +377,55 @@ namespace
 }  // unnamed namespace 
 
 
+// ---------------------------------------------------------
+///
+/// Storage reused by the successive inelastic projections of one impact zone.  The zone's collisions stay the same 
+/// between projections, so the systems have the same size and sparsity.
+///
+// ---------------------------------------------------------
+
+struct InelasticProjectionWorkspace
+{
+    InelasticProjectionWorkspace() :
+    m_gradient(),
+    m_inv_masses(),
+    m_velocities(),
+    m_rhs(),
+    m_dense_matrix(),
+    m_factored_matrix(),
+    m_residual(),
+    m_sparse_matrix(),
+    m_incomplete_cholesky(),
+    m_jacobi(),
+    m_cg_solver(),
+    m_minres_solver(),
+    m_solution(),
+    m_has_previous_solution( false )
+    {}
+    
+    ConstraintGradient m_gradient;
+    std::vector<double> m_inv_masses;
+    std::vector<Vec3d> m_velocities;
+    std::vector<double> m_rhs;
+    
+    /// Dense path
+    std::vector<double> m_dense_matrix;
+    std::vector<double> m_factored_matrix;
+    std::vector<double> m_residual;
+    
+    /// Sparse path
+    SparseMatrixStaticCSR m_sparse_matrix;
+    IncompleteCholeskyPreconditioner m_incomplete_cholesky;
+    JacobiPreconditioner m_jacobi;
+    CG_Solver m_cg_solver;
+    MINRES_CR_Solver m_minres_solver;
+    
+    /// Solution of the last successful projection, used as the starting guess for the next one
+    std::vector<double> m_solution;
+    bool m_has_previous_solution;
+};
+
+
 // ---------------------------------------------------------
 ///
 /// ImpactZoneSolver constructor
@@ -201,9 +450,11 @@ bool ImpactZoneSolver::iterated_inelastic_projection( ImpactZone& iz, double dt
     
     static const unsigned int MAX_PROJECTION_ITERATIONS = 20;
     
+    InelasticProjectionWorkspace workspace;
+    
     for ( unsigned int i = 0; i < MAX_PROJECTION_ITERATIONS; ++i )
     {
-        bool success = inelastic_projection( iz );
+        bool success = inelastic_projection( iz, workspace );
         
         if ( !success )
         {
@@ -221,10 +472,12 @@ bool ImpactZoneSolver::iterated_inelastic_projection( ImpactZone& iz, double dt
             Collision& collision = iz.m_collisions[c];
             const Vec4st& vs = collision.m_vertex_indices;
             
-            m_surface.set_newposition( vs[0], m_surface.get_position(vs[0]) + dt * m_surface.m_velocities[vs[0]]);
-            m_surface.set_newposition( vs[1], m_surface.get_position(vs[1]) + dt * m_surface.m_velocities[vs[1]]);
-            m_surface.set_newposition( vs[2], m_surface.get_position(vs[2]) + dt * m_surface.m_velocities[vs[2]]);
-            m_surface.set_newposition( vs[3], m_surface.get_position(vs[3]) + dt * m_surface.m_velocities[vs[3]]);         
+            // predicted positions are kept locally, as other zones may be solved concurrently; the caller sets the 
+            // surface's predicted positions once the zone is done
+            const Vec3d new_x[4] = { m_surface.get_position(vs[0]) + dt * m_surface.m_velocities[vs[0]],
+                                     m_surface.get_position(vs[1]) + dt * m_surface.m_velocities[vs[1]],
+                                     m_surface.get_position(vs[2]) + dt * m_surface.m_velocities[vs[2]],
+                                     m_surface.get_position(vs[3]) + dt * m_surface.m_velocities[vs[3]] };
             
             if ( m_surface.m_verbose ) { std::cout << "checking collision " << vs << std::endl; }
             
@@ -236,10 +489,10 @@ bool ImpactZoneSolver::iterated_inelastic_projection( ImpactZone& iz, double dt
                 
                 assert( vs[0] < vs[1] && vs[2] < vs[3] );       // should have been sorted by original collision detection
                 
-                if ( segment_segment_collision( m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0],
-                                               m_surface.get_position(vs[1]), m_surface.get_newposition(vs[1]), vs[1],
-                                               m_surface.get_position(vs[2]), m_surface.get_newposition(vs[2]), vs[2],
-                                               m_surface.get_position(vs[3]), m_surface.get_newposition(vs[3]), vs[3],
+                if ( segment_segment_collision( m_surface.m_ccd_backend, m_surface.get_position(vs[0]), new_x[0], vs[0],
+                                               m_surface.get_position(vs[1]), new_x[1], vs[1],
+                                               m_surface.get_position(vs[2]), new_x[2], vs[2],
+                                               m_surface.get_position(vs[3]), new_x[3], vs[3],
                                                s0, s2,
                                                normal,
                                                rel_disp ) )               
@@ -259,10 +512,10 @@ bool ImpactZoneSolver::iterated_inelastic_projection( ImpactZone& iz, double dt
                 
                 assert( vs[1] < vs[2] && vs[2] < vs[3] && vs[1] < vs[3] );    // should have been sorted by original collision detection
                 
-                if ( point_triangle_collision( m_surface.get_position(vs[0]), m_surface.get_newposition(vs[0]), vs[0],
-                                              m_surface.get_position(vs[1]), m_surface.get_newposition(vs[1]), vs[1],
-                                              m_surface.get_position(vs[2]), m_surface.get_newposition(vs[2]), vs[2],
-                                              m_surface.get_position(vs[3]), m_surface.get_newposition(vs[3]), vs[3],
+                if ( point_triangle_collision( m_surface.m_ccd_backend, m_surface.get_position(vs[0]), new_x[0], vs[0],
+                                              m_surface.get_position(vs[1]), new_x[1], vs[1],
+                                              m_surface.get_position(vs[2]), new_x[2], vs[2],
+                                              m_surface.get_position(vs[3]), new_x[3], vs[3],
                                               s1, s2, s3,
                                               normal,
                                               rel_disp ) )                                 
@@ -300,130 +553,211 @@ bool ImpactZoneSolver::iterated_inelastic_projection( ImpactZone& iz, double dt
 ///
 // ---------------------------------------------------------
 
-bool ImpactZoneSolver::inelastic_projection( const ImpactZone& iz )
+bool ImpactZoneSolver::inelastic_projection( const ImpactZone& iz, InelasticProjectionWorkspace& workspace )
 {
     
-    if ( m_surface.m_verbose )
-    {
-        std::cout << " ----- using sparse solver " << std::endl;
-    }
-    
     const size_t k = iz.m_collisions.size();    // notation from [Harmon et al 2008]: k == number of collisions
     
-    std::vector<size_t> zone_vertices;
-    iz.get_all_vertices( zone_vertices );
+    const std::vector<size_t>& zone_vertices = iz.m_vertices;
     
     const size_t n = zone_vertices.size();       // n == number of distinct colliding vertices
     
     if ( m_surface.m_verbose ) { std::cout << "GCT: " << 3*n << "x" << k << std::endl; }
     
-    SparseMatrixDynamicCSR GCT( to_int(3*n), to_int(k) );
-    GCT.set_zero();
+    // Dense Cholesky is used up to this many collisions.  Larger systems are sparse enough that a Krylov solver is faster.
+    static const size_t MAX_DENSE_SOLVE_COLLISIONS = 128;
     
-    // construct matrix grad C transpose
-    for ( int i = 0; i < to_int(k); ++i )
-    {
-        // set col i
-        const Collision& coll = iz.m_collisions[i];
-        
-        for ( unsigned int v = 0; v < 4; ++v )
-        {
-            // block row j ( == block column j of grad C )
-            size_t j = coll.m_vertex_indices[v];
-            
-            std::vector<size_t>::iterator zone_vertex_iter = find( zone_vertices.begin(), zone_vertices.end(), j );
-            
-            assert( zone_vertex_iter != zone_vertices.end() );
-            
-            int mat_j = to_int( zone_vertex_iter - zone_vertices.begin() );
-            
-            GCT(mat_j*3, i) = coll.m_barycentric_coordinates[v] * coll.m_normal[0];
-            GCT(mat_j*3+1, i) = coll.m_barycentric_coordinates[v] * coll.m_normal[1];
-            GCT(mat_j*3+2, i) = coll.m_barycentric_coordinates[v] * coll.m_normal[2];
-            
-        }
-    }
+    static const double IMPULSE_MULTIPLIER = 0.8;
+    
+    double start_time = get_time_in_seconds();
     
-    Array1d inv_masses;
-    inv_masses.reserve(3*n);
-    Array1d column_velocities;
-    column_velocities.reserve(3*n);
+    ConstraintGradient& G = workspace.m_gradient;
+    build_constraint_gradient( iz, G );
+    
+    std::vector<double>& inv_masses = workspace.m_inv_masses;
+    std::vector<Vec3d>& velocities = workspace.m_velocities;
+    inv_masses.resize( n );
+    velocities.resize( n );
     
     for ( size_t i = 0; i < n; ++i )
     {
-        inv_masses.push_back( 1.0 / m_surface.m_masses[zone_vertices[i]] );
-        inv_masses.push_back( 1.0 / m_surface.m_masses[zone_vertices[i]] );
-        inv_masses.push_back( 1.0 / m_surface.m_masses[zone_vertices[i]] );
-        
-        column_velocities.push_back( m_surface.m_velocities[zone_vertices[i]][0] );
-        column_velocities.push_back( m_surface.m_velocities[zone_vertices[i]][1] );
-        column_velocities.push_back( m_surface.m_velocities[zone_vertices[i]][2] );
+        inv_masses[i] = 1.0 / m_surface.m_masses[zone_vertices[i]];
+        velocities[i] = m_surface.m_velocities[zone_vertices[i]];
     }
     
     //
     // minimize | M^(-1/2) * GC^T x - M^(1/2) * v |^2
     //
     
-    // solution vector
-    Array1d x(k);
-    
-    KrylovSolverStatus solver_result;
-    
     // normal equations: GC * M^(-1) GCT * x = GC * v
     //                   A * x = b
     
-    SparseMatrixDynamicCSR A( to_int(k), to_int(k) );
-    A.set_zero();
-    AtDB( GCT, inv_masses.data, GCT, A ); 
-    
-    Array1d b(k);
-    GCT.apply_transpose( column_velocities.data, b.data );   
+    std::vector<double>& b = workspace.m_rhs;
+    b.assign( k, 0.0 );
+    for ( size_t e = 0; e < 4*k; ++e )
+    {
+        b[e/4] += dot( G.m_value[e], velocities[ G.m_local_vertex[e] ] );
+    }
     
-    if ( m_surface.m_verbose )  { std::cout << "system built" << std::endl; }
+    // solution vector
+    std::vector<double>& x = workspace.m_solution;
     
-    MINRES_CR_Solver solver;   
-    SparseMatrixStaticCSR solver_matrix( A );    // convert dynamic to static
-    solver.max_iterations = 1000;
-    solver_result = solver.solve( solver_matrix, b.data, x.data ); 
+    bool solved = false;
+    bool used_dense_solver = false;
+    unsigned int krylov_iterations = 0;
     
-    if ( solver_result != KRYLOV_CONVERGED )
+    if ( k <= MAX_DENSE_SOLVE_COLLISIONS )
     {
-        if ( m_surface.m_verbose )
+        if ( m_surface.m_verbose ) { std::cout << " ----- using dense solver " << std::endl; }
+        
+        std::vector<double>& A = workspace.m_dense_matrix;
+        form_dense_normal_matrix( G, inv_masses, k, A );
+        workspace.m_factored_matrix = A;
+        
+        x = b;
+        int info;
+        LAPACK::solve_positive_definite_system( to_int(k), 1, &workspace.m_factored_matrix[0], to_int(k), &x[0], to_int(k), info );
+        
+        if ( info == 0 )
         {
-            std::cout << "CR solver failed: ";      
-            if ( solver_result == KRYLOV_BREAKDOWN )
+            // A is only positive semi-definite when collisions are redundant, so make sure the factorization was accurate
+            
+            std::vector<double>& residual = workspace.m_residual;
+            residual = b;
+            for ( size_t j = 0; j < k; ++j )
             {
-                std::cout << "KRYLOV_BREAKDOWN" << std::endl;
+                for ( size_t i = 0; i < k; ++i )
+                {
+                    residual[i] -= A[j*k + i] * x[j];
+                }
             }
-            else
-            {
-                std::cout << "KRYLOV_EXCEEDED_MAX_ITERATIONS" << std::endl;
+            
+            double tolerance = 1e-9 * BLAS::abs_max( b );
+            solved = ( BLAS::abs_max( residual ) <= tolerance );     // also false if anything is NaN
+        }
+        
+        used_dense_solver = solved;
+        
+        if ( !solved )
+        {
+            // the failed solve overwrote the previous solution
+            workspace.m_has_previous_solution = false;
+            
+            if ( m_surface.m_verbose ) 
+            { 
+                std::cout << "dense Cholesky solve failed, falling back to sparse solver" << std::endl; 
             }
+        }
+    }
+    
+    if ( !solved )
+    {
+        if ( m_surface.m_verbose ) { std::cout << " ----- using sparse solver " << std::endl; }
+        
+        SparseMatrixStaticCSR& A = workspace.m_sparse_matrix;
+        form_sparse_normal_matrix( G, inv_masses, k, A );
+        
+        if ( m_surface.m_verbose )  { std::cout << "system built" << std::endl; }
+        
+        // IC(0) is the better preconditioner, but can break down on the nearly singular systems of redundant collisions
+        
+        const LinearOperator* preconditioner = &workspace.m_incomplete_cholesky;
+        if ( !workspace.m_incomplete_cholesky.build( A ) )
+        {
+            workspace.m_jacobi.build( A );
+            preconditioner = &workspace.m_jacobi;
+        }
+        
+        // If the collisions haven't changed since the last projection, the last impulse left (1 - IMPULSE_MULTIPLIER) 
+        // of the normal velocities, so that fraction of the last solution solves this system.  Successive systems in a 
+        // zone differ only by the updated collision normals and barycentric coordinates, so it's a good starting guess.
+        
+        bool warm_start = workspace.m_has_previous_solution && x.size() == k;
+        if ( warm_start )
+        {
+            for ( size_t i = 0; i < k; ++i ) { x[i] *= ( 1.0 - IMPULSE_MULTIPLIER ); }
+        }
+        else
+        {
+            x.assign( k, 0.0 );
+        }
+        
+        // the system is consistent, so CG should converge; unpreconditioned MINRES is the backstop if round-off gets in the way
+        
+        CG_Solver& cg_solver = workspace.m_cg_solver;
+        cg_solver.max_iterations = 1000;
+        KrylovSolverStatus solver_result = cg_solver.solve( A, &b[0], &x[0], preconditioner, warm_start );
+        krylov_iterations += cg_solver.iteration;
+        
+        if ( solver_result != KRYLOV_CONVERGED )
+        {
+            MINRES_CR_Solver& solver = workspace.m_minres_solver;
+            solver.max_iterations = 1000;
+            solver_result = solver.solve( A, &b[0], &x[0] ); 
+            krylov_iterations += solver.iteration;
             
-            double residual_norm = BLAS::abs_max(solver.r);
-            std::cout << "residual_norm: " << residual_norm << std::endl;
+            if ( solver_result != KRYLOV_CONVERGED && m_surface.m_verbose )
+            {
+                std::cout << "CR solver failed: ";      
+                if ( solver_result == KRYLOV_BREAKDOWN )
+                {
+                    std::cout << "KRYLOV_BREAKDOWN" << std::endl;
+                }
+                else
+                {
+                    std::cout << "KRYLOV_EXCEEDED_MAX_ITERATIONS" << std::endl;
+                }
+                
+                double residual_norm = BLAS::abs_max(solver.r);
+                std::cout << "residual_norm: " << residual_norm << std::endl;
+            }
+        }
+        
+        solved = ( solver_result == KRYLOV_CONVERGED );
+    }
+    
+    workspace.m_has_previous_solution = solved;
+    
+    double solve_time = get_time_in_seconds() - start_time;
+    
+    // zones may be solved concurrently
+    #pragma omp critical(eltopo_impact_zone_solver_stats)
+    {
+        ImpactZoneSolverStats& stats = m_surface.m_impact_zone_solver_stats;
+        
+        if ( used_dense_solver )
+        {
+            ++stats.m_num_dense_solves;
+            stats.m_dense_solve_time += solve_time;
+        }
+        else
+        {
+            ++stats.m_num_iterative_solves;
+            stats.m_iterative_solve_time += solve_time;
+            stats.m_num_krylov_iterations += krylov_iterations;
             
+            if ( k <= MAX_DENSE_SOLVE_COLLISIONS ) { ++stats.m_num_dense_solve_fallbacks; }
         }
         
+        if ( !solved ) { ++stats.m_num_failed_solves; }
+    }
+    
+    if ( !solved )
+    {
         return false;          
     } 
     
     // apply impulses 
-    Array1d applied_impulses(3*n);
-    GCT.apply( x.data, applied_impulses.data );
     
-    static const double IMPULSE_MULTIPLIER = 0.8;
-    
-    for ( size_t i = 0; i < applied_impulses.size(); ++i )
+    std::vector<Vec3d> applied_impulses( n, Vec3d(0,0,0) );
+    for ( size_t e = 0; e < 4*k; ++e )
     {
-        column_velocities[i] -= IMPULSE_MULTIPLIER * inv_masses[i] * applied_impulses[i];      
+        applied_impulses[ G.m_local_vertex[e] ] += x[e/4] * G.m_value[e];
     }
     
     for ( size_t i = 0; i < n; ++i )
     {
-        m_surface.m_velocities[zone_vertices[i]][0] = column_velocities[3*i];
-        m_surface.m_velocities[zone_vertices[i]][1] = column_velocities[3*i + 1];
-        m_surface.m_velocities[zone_vertices[i]][2] = column_velocities[3*i + 2];      
+        m_surface.m_velocities[zone_vertices[i]] = velocities[i] - IMPULSE_MULTIPLIER * inv_masses[i] * applied_impulses[i];
     }
     
     return true;
@@ -451,20 +785,8 @@ bool ImpactZoneSolver::inelastic_impact_zones(double dt)
     
     while ( false == total_collisions.empty() )
     {      
-        // insert each new collision constraint into its own impact zone
-        std::vector<ImpactZone> new_impact_zones;
-        for ( size_t i = 0; i < total_collisions.size(); ++i )
-        {
-            ImpactZone new_zone;
-            new_zone.m_collisions.push_back( total_collisions[i] );
-            new_impact_zones.push_back( new_zone );
-        }
-        
-        // now we have one zone for each collision
-        assert( new_impact_zones.size() == total_collisions.size() );
-        
-        // merge all impact zones that share vertices
-        merge_impact_zones( new_impact_zones, impact_zones );
+        // merge the new collisions and all impact zones that share vertices
+        merge_impact_zones( total_collisions, impact_zones );
         
         // remove impact zones which have been solved
         for ( int i = 0; i < (int) impact_zones.size(); ++i )
@@ -481,10 +803,13 @@ bool ImpactZoneSolver::inelastic_impact_zones(double dt)
             assert( false == impact_zones[i].m_all_solved );
         }            
         
-        bool all_zones_solved_ok = true;
+        // Zones don't share vertices once merged, so each one reads and writes the velocities of its own vertices only, 
+        // and they can be solved concurrently.
         
-        // for each impact zone
-        for ( size_t i = 0; i < impact_zones.size(); ++i )
+        std::vector<char> zone_solved_ok( impact_zones.size(), true );
+        
+        #pragma omp parallel for schedule(dynamic) num_threads(m_surface.m_num_threads)
+        for ( int i = 0; i < (int) impact_zones.size(); ++i )
         {
             
             // reset impact zone to pre-response m_velocities
@@ -499,9 +824,19 @@ bool ImpactZoneSolver::inelastic_impact_zones(double dt)
             
             // apply inelastic projection
             
-            all_zones_solved_ok &= iterated_inelastic_projection( impact_zones[i], dt );
+            zone_solved_ok[i] = iterated_inelastic_projection( impact_zones[i], dt );
+            
+        }  // for IZs
+        
+        bool all_zones_solved_ok = true;
+        
+        // reset predicted positions, serially as they update the broad phase
+        m_surface.begin_broad_phase_updates();
+        
+        for ( size_t i = 0; i < impact_zones.size(); ++i )
+        {
+            all_zones_solved_ok &= ( zone_solved_ok[i] != 0 );
             
-            // reset predicted positions
             for ( size_t j = 0; j < impact_zones[i].m_collisions.size(); ++j )
             {
                 const Vec4st& vs = impact_zones[i].m_collisions[j].m_vertex_indices;            
@@ -512,8 +847,9 @@ bool ImpactZoneSolver::inelastic_impact_zones(double dt)
                 m_surface.set_newposition( vs[3], m_surface.get_position(vs[3]) + dt * m_surface.m_velocities[vs[3]] );
                 
             } 
-            
-        }  // for IZs
+        }
+        
+        m_surface.commit_broad_phase_updates();
         
         
         if ( false == all_zones_solved_ok )
@@ -570,20 +906,8 @@ bool ImpactZoneSolver::rigid_impact_zones(double dt)
     
     while ( false == total_collisions.empty() )
     {      
-        // insert each new collision constraint into its own impact zone
-        std::vector<ImpactZone> new_impact_zones;
-        for ( size_t i = 0; i < total_collisions.size(); ++i )
-        {
-            ImpactZone new_zone;
-            new_zone.m_collisions.push_back( total_collisions[i] );
-            new_impact_zones.push_back( new_zone );
-            
-        }  // for loop over total_collisions
-        
-        assert( new_impact_zones.size() == total_collisions.size() );
-        
-        // merge all impact zones that share vertices
-        merge_impact_zones( new_impact_zones, impact_zones );
+        // merge the new collisions and all impact zones that share vertices
+        merge_impact_zones( total_collisions, impact_zones );
         
         for ( int i = 0; i < (int) impact_zones.size(); ++i )
         {
@@ -604,9 +928,7 @@ bool ImpactZoneSolver::rigid_impact_zones(double dt)
         for ( size_t i = 0; i < impact_zones.size(); ++i )
         {
             
-            std::vector<size_t> zone_vertices;
-            impact_zones[i].get_all_vertices( zone_vertices );
-            bool rigid_motion_ok = calculate_rigid_motion(dt, zone_vertices);
+            bool rigid_motion_ok = calculate_rigid_motion(dt, impact_zones[i].m_vertices);
             
             if ( !rigid_motion_ok )
             {
@@ -649,7 +971,7 @@ bool ImpactZoneSolver::rigid_impact_zones(double dt)
 ///
 // ---------------------------------------------------------
 
-bool ImpactZoneSolver::calculate_rigid_motion(double dt, std::vector<size_t>& vs)
+bool ImpactZoneSolver::calculate_rigid_motion(double dt, const std::vector<size_t>& vs)
 {
     Vec3d xcm(0,0,0);
     Vec3d vcm(0,0,0);
@@ -760,6 +1082,8 @@ bool ImpactZoneSolver::calculate_rigid_motion(double dt, std::vector<size_t>& vs
     
     double max_velocity_mag = -1.0;
     
+    m_surface.begin_broad_phase_updates();
+    
     for(size_t i = 0; i < vs.size(); i++)
     {
         size_t idx = vs[i];
@@ -776,6 +1100,8 @@ bool ImpactZoneSolver::calculate_rigid_motion(double dt, std::vector<size_t>& vs
         
     }
     
+    m_surface.commit_broad_phase_updates();
+    
     min_dist_t1 = 1e+30;
     for(size_t i = 0; i < vs.size(); i++)
     {
@@ -23,6 +23,7 @@
 // ---------------------------------------------------------
 
 class DynamicSurface;
+struct InelasticProjectionWorkspace;
 
 // ---------------------------------------------------------
 //  Class definitions
@@ -38,24 +39,58 @@ struct ImpactZone
 {
     ImpactZone() :
     m_collisions(),
+    m_vertices(),
     m_all_solved( false )
     {}
     
-    // Get the set of all vertices in this impact zone
-    void get_all_vertices( std::vector<size_t>& vertices ) const;
-    
-    // Whether this ImpactZones shares vertices with other
-    bool share_vertices( const ImpactZone& other ) const;
-    
     // Set of collisions with connected vertices
     std::vector<Collision> m_collisions;  
     
+    // All vertices in all collisions in this zone, sorted.  No other zone contains any of these vertices.
+    std::vector<size_t> m_vertices;
+    
     // Whether all collisions in this zone have been solved (i.e. no longer colliding)
     bool m_all_solved;
     
 };
 
 
+// --------------------------------------------------------
+///
+/// Number of inelastic projection solves of each kind, and the time spent in them (including assembly of the system)
+///
+// --------------------------------------------------------
+
+struct ImpactZoneSolverStats
+{
+    ImpactZoneSolverStats() :
+    m_num_dense_solves( 0 ),
+    m_dense_solve_time( 0.0 ),
+    m_num_iterative_solves( 0 ),
+    m_iterative_solve_time( 0.0 ),
+    m_num_krylov_iterations( 0 ),
+    m_num_dense_solve_fallbacks( 0 ),
+    m_num_failed_solves( 0 )
+    {}
+    
+    // Systems solved by dense Cholesky factorization
+    size_t m_num_dense_solves;
+    double m_dense_solve_time;
+    
+    // Systems solved by a Krylov solver on the sparse system
+    size_t m_num_iterative_solves;
+    double m_iterative_solve_time;
+    size_t m_num_krylov_iterations;
+    
+    // Small systems which weren't numerically positive definite, so were passed on to the iterative solver
+    size_t m_num_dense_solve_fallbacks;
+    
+    // Systems which no solver could solve
+    size_t m_num_failed_solves;
+    
+};
+
+
 // --------------------------------------------------------
 ///
 /// Process collisions using inelastic impact zone solver and rigid impact zone solver.
@@ -75,17 +110,19 @@ public:
     
 protected:
     
-    /// iteratively run collision detection and inelastic projection on an active set of collisions
+    /// iteratively run collision detection and inelastic projection on an active set of collisions.  Only the velocities of 
+    /// the zone's vertices are read and written, so zones which don't share vertices can be solved concurrently.
     ///
     bool iterated_inelastic_projection( ImpactZone& iz, double dt );
     
-    /// attempt to set normal velocity to zero for all collisions in the impact zone
+    /// attempt to set normal velocity to zero for all collisions in the impact zone.  The workspace carries storage and 
+    /// the previous solution from one projection of the zone to the next.
     ///
-    bool inelastic_projection( const ImpactZone& iz );
+    bool inelastic_projection( const ImpactZone& iz, InelasticProjectionWorkspace& workspace );
     
     /// Compute the best-fit single rigid motion for a set of vertices.
     ///
-    bool calculate_rigid_motion(double dt, std::vector<size_t>& vs);
+    bool calculate_rigid_motion(double dt, const std::vector<size_t>& vs);
     
     DynamicSurface& m_surface;
     
@@ -96,52 +133,6 @@ protected:
 };
 
 
-// ---------------------------------------------------------
-//  Inline functions
-// ---------------------------------------------------------
-
-// --------------------------------------------------------
-///
-/// Extract the set of all vertices in all collisions in an ImpactZone
-///
-// --------------------------------------------------------
-
-inline void ImpactZone::get_all_vertices( std::vector<size_t>& vertices ) const
-{
-    vertices.clear();
-    for ( size_t i = 0; i < m_collisions.size(); ++i )
-    {
-        add_unique( vertices, m_collisions[i].m_vertex_indices[0] );
-        add_unique( vertices, m_collisions[i].m_vertex_indices[1] );
-        add_unique( vertices, m_collisions[i].m_vertex_indices[2] );
-        add_unique( vertices, m_collisions[i].m_vertex_indices[3] );
-    }
-}
-
-
-// --------------------------------------------------------
-///
-/// Determine whether another ImpactZone shares any vertices with this ImpactZone
-///
-// --------------------------------------------------------
-
-inline bool ImpactZone::share_vertices( const ImpactZone& other ) const
-{
-    for ( size_t i = 0; i < m_collisions.size(); ++i )
-    {
-        for ( size_t j = 0; j < other.m_collisions.size(); ++j )
-        {
-            if ( m_collisions[i].overlap_vertices( other.m_collisions[j] ) )
-            {
-                return true;
-            }
-        }
-    }
-    
-    return false;
-}
-
-
 #endif
 
 
@@ -13,10 +13,13 @@
 #include "broadphase.h"
 #include "collisionpipeline.h"
 #include "../common/collisionqueries.h"
-#include <queue>
+#include <algorithm>
 #include "../common/runstats.h"
 #include "surftrack.h"
 
+// Number of edges handed to a thread at a time by find_proximal_edge_pairs
+static const size_t PARALLEL_EDGE_BLOCK_SIZE = 256;
+
 
 // --------------------------------------------------------
 ///
@@ -103,7 +106,7 @@ bool MeshMerger::get_zipper_triangles( size_t edge_index_a, size_t edge_index_b,
     zipper_vertices[4] = edge_b[0];
     zipper_vertices[6] = edge_b[1];
     
-    const std::vector<size_t>& incident_triangles_a = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_a];
+    const EdgeAdjacencyList& incident_triangles_a = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_a];
     
     assert( incident_triangles_a.size() == 2 );       // should be checked before calling this function
     
@@ -131,14 +134,14 @@ bool MeshMerger::get_zipper_triangles( size_t edge_index_a, size_t edge_index_b,
         assert( false );
     }
     
-    const std::vector<size_t>& incident_triangles_b = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_b];
+    const EdgeAdjacencyList& incident_triangles_b = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_b];
     
     assert( incident_triangles_b.size() == 2 );       // should be checked before calling this function
     
     assert( edge_index_b < m_surf.m_mesh.m_edges.size() );
     
     const Vec2st& ce = m_surf.m_mesh.m_edges[edge_index_b];
-    const std::vector<size_t>& et = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_b];
+    const EdgeAdjacencyList& et = m_surf.m_mesh.m_edge_to_triangle_map[edge_index_b];
     
     const Vec3st& inc_tri_b0 = m_surf.m_mesh.get_triangle( incident_triangles_b[0] );
     const Vec3st& inc_tri_b1 = m_surf.m_mesh.get_triangle( incident_triangles_b[1] );
@@ -265,7 +268,7 @@ bool MeshMerger::zippering_introduces_collision( const std::vector<Vec3st>& new_
                 continue; 
             }
             
-            if ( check_triangle_triangle_intersection(new_triangles[i], 
+            if ( check_triangle_triangle_intersection(m_surf.m_ccd_backend, new_triangles[i], 
                                                       m_surf.m_mesh.get_triangle(overlapping_triangles[t]), 
                                                       m_surf.get_positions() ) )
             {
@@ -278,7 +281,7 @@ bool MeshMerger::zippering_introduces_collision( const std::vector<Vec3st>& new_
         {
             if ( i == j )  { continue; }
             
-            if ( check_triangle_triangle_intersection(new_triangles[i], 
+            if ( check_triangle_triangle_intersection(m_surf.m_ccd_backend, new_triangles[i], 
                                                       new_triangles[j], 
                                                       m_surf.get_positions() ) )
             {
@@ -397,29 +400,27 @@ bool MeshMerger::zipper_edges( size_t edge_index_a, size_t edge_index_b )
 
 // --------------------------------------------------------
 ///
-/// Perform one pass over the mesh, attempting to merge near edges.
+/// Find all pairs of edges closer than the merge proximity epsilon, sorted by increasing distance.  Edges are handed to 
+/// threads in blocks, and the results gathered in block order, so the list doesn't depend on the number of threads.
 ///
 // --------------------------------------------------------
 
-void MeshMerger::process_mesh( )
+void MeshMerger::find_proximal_edge_pairs( std::vector<SortableEdgeEdgeProximity>& proximities ) const
 {
+    const size_t num_edges = m_surf.m_mesh.m_edges.size();
+    const int num_blocks = (int) ( ( num_edges + PARALLEL_EDGE_BLOCK_SIZE - 1 ) / PARALLEL_EDGE_BLOCK_SIZE );
     
-    std::queue<Vec2st> edge_edge_candidates;
-    
-    //
-    // Check edge-edge proximities for zippering candidates
-    //
-    
-    bool merge_occured = true;
+    std::vector< std::vector<SortableEdgeEdgeProximity> > block_proximities( num_blocks );
     
-    while ( merge_occured )
+    #pragma omp parallel for schedule(dynamic) num_threads(m_surf.m_num_threads)
+    for ( int b = 0; b < num_blocks; ++b )
     {
-        merge_occured = false;
+        const size_t begin = (size_t) b * PARALLEL_EDGE_BLOCK_SIZE;
+        const size_t end = std::min( begin + PARALLEL_EDGE_BLOCK_SIZE, num_edges );
         
-        // sorted by proximity so we merge closest pairs first
-        std::vector<SortableEdgeEdgeProximity> proximities;
+        std::vector<size_t> edge_candidates;
         
-        for(size_t i = 0; i < m_surf.m_mesh.m_edges.size(); i++)
+        for ( size_t i = begin; i < end; ++i )
         {
             const Vec2st& e0 = m_surf.m_mesh.m_edges[i];
             
@@ -433,7 +434,8 @@ void MeshMerger::process_mesh( )
             emin -= m_surf.m_merge_proximity_epsilon * Vec3d(1,1,1);
             emax += m_surf.m_merge_proximity_epsilon * Vec3d(1,1,1);
             
-            std::vector<size_t> edge_candidates;
+            edge_candidates.clear();
+            
             m_surf.m_broad_phase->get_potential_edge_collisions( emin, emax, false, true, edge_candidates );
             
             for(size_t j = 0; j < edge_candidates.size(); j++)
@@ -461,29 +463,86 @@ void MeshMerger::process_mesh( )
                     
                     if (distance < m_surf.m_merge_proximity_epsilon)
                     {
-                        
-                        if ( m_surf.m_verbose ) 
-                        { 
-                            std::cout << "proximity: " << distance << " / " << m_surf.m_merge_proximity_epsilon << std::endl; //proximities[i].distance << std::endl; 
-                        }
-                        
-                        if ( zipper_edges( i, proximal_edge_index ) )
-                        {
-                            
-                            m_surf.trim_non_manifold( m_surf.m_dirty_triangles );
-                            
-                            if ( m_surf.m_verbose ) 
-                            { 
-                                std::cout << "zippered" << std::endl; 
-                            }
-                            
-                            merge_occured = true;
-                        }
-                        
+                        block_proximities[b].push_back( SortableEdgeEdgeProximity( i, proximal_edge_index, distance ) );
                     }
                 }
             }
         }
+    }
+    
+    proximities.clear();
+    for ( int b = 0; b < num_blocks; ++b )
+    {
+        proximities.insert( proximities.end(), block_proximities[b].begin(), block_proximities[b].end() );
+    }
+    
+    std::stable_sort( proximities.begin(), proximities.end() );
+}
+
+
+// --------------------------------------------------------
+///
+/// Merge near edges, closest pairs first.  Each pass gathers every proximal pair once.  A zipper changes the 
+/// neighbourhoods of the vertices of its new triangles, so pairs touching those vertices wait for the next pass, which
+/// re-gathers them from the updated mesh.  Passes repeat until no zipper succeeds.
+///
+// --------------------------------------------------------
+
+void MeshMerger::process_mesh( )
+{
+    
+    bool merge_occured = true;
+    
+    std::vector<SortableEdgeEdgeProximity> proximities;
+    std::vector<char> vertex_is_dirty;
+    
+    while ( merge_occured )
+    {
+        merge_occured = false;
+        
+        // sorted by proximity so we merge closest pairs first
+        find_proximal_edge_pairs( proximities );
+        
+        vertex_is_dirty.assign( m_surf.get_num_vertices(), 0 );
+        
+        for ( size_t p = 0; p < proximities.size(); ++p )
+        {
+            size_t edge_index_a = proximities[p].edge_a;
+            size_t edge_index_b = proximities[p].edge_b;
+            
+            if ( m_surf.m_mesh.edge_is_deleted( edge_index_a ) || m_surf.m_mesh.edge_is_deleted( edge_index_b ) ) { continue; }
+            
+            const Vec2st& e0 = m_surf.m_mesh.m_edges[edge_index_a];
+            const Vec2st& e1 = m_surf.m_mesh.m_edges[edge_index_b];
+            
+            if ( vertex_is_dirty[e0[0]] || vertex_is_dirty[e0[1]] || vertex_is_dirty[e1[0]] || vertex_is_dirty[e1[1]] ) { continue; }
+            
+            if ( m_surf.m_verbose ) 
+            { 
+                std::cout << "proximity: " << proximities[p].distance << " / " << m_surf.m_merge_proximity_epsilon << std::endl;
+            }
+            
+            if ( zipper_edges( edge_index_a, edge_index_b ) )
+            {
+                for ( size_t i = 0; i < m_surf.m_dirty_triangles.size(); ++i )
+                {
+                    const Vec3st& tri = m_surf.m_mesh.get_triangle( m_surf.m_dirty_triangles[i] );
+                    vertex_is_dirty[tri[0]] = vertex_is_dirty[tri[1]] = vertex_is_dirty[tri[2]] = 1;
+                }
+                
+                m_surf.trim_non_manifold( m_surf.m_dirty_triangles );
+                
+                // trimming can split off new vertices
+                vertex_is_dirty.resize( m_surf.get_num_vertices(), 1 );
+                
+                if ( m_surf.m_verbose ) 
+                { 
+                    std::cout << "zippered" << std::endl; 
+                }
+                
+                merge_occured = true;
+            }
+        }
         
         if ( merge_occured )
         {
@@ -494,7 +553,6 @@ void MeshMerger::process_mesh( )
     
 }
 
-
 void MeshMerger::add_observer( MeshMergeObserver* observer )
 {
     m_observers.push_back( observer );
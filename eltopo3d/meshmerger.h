@@ -109,6 +109,10 @@ private:
     
     bool zipper_edges( size_t edge_index_a, size_t edge_index_b );
     
+    /// Find all pairs of edges closer than the merge proximity epsilon, sorted by increasing distance
+    ///
+    void find_proximal_edge_pairs( std::vector<SortableEdgeEdgeProximity>& proximities ) const;
+    
     std::vector<MeshMergeObserver*> m_observers;
     
 };
@@ -0,0 +1,163 @@
+// ---------------------------------------------------------
+//
+//  meshoperationscheduler.cpp
+//
+//  Groups mesh improvement operations into rounds which can be checked concurrently.
+//
+// ---------------------------------------------------------
+
+// ---------------------------------------------------------
+// Includes
+// ---------------------------------------------------------
+
+#include "meshoperationscheduler.h"
+
+#include "../common/commonoptions.h"
+#include "nondestructivetrimesh.h"
+
+// ---------------------------------------------------------
+// Local constants, typedefs, macros
+// ---------------------------------------------------------
+
+// Upper limit on the number of cells along each dimension of the grid of applied regions
+static const size_t MAX_REGION_GRID_DIMENSION = 1024;
+
+// ---------------------------------------------------------
+// Member function definitions
+// ---------------------------------------------------------
+
+MeshOperationScheduler::MeshOperationScheduler() :
+    m_round( 0 ),
+    m_modified_round(),
+    m_read_round(),
+    m_applied_regions(),
+    m_num_applied_regions( 0 ),
+    m_read_vertices(),
+    m_overlapping_regions()
+{}
+
+// ---------------------------------------------------------
+///
+/// Start a new round, on a mesh with the given number of vertices
+///
+// ---------------------------------------------------------
+
+void MeshOperationScheduler::begin_round( size_t num_vertices )
+{
+    ++m_round;
+    m_modified_round.resize( num_vertices, 0 );
+    m_read_round.resize( num_vertices, 0 );
+}
+
+// ---------------------------------------------------------
+///
+/// Add an operation to the current round if its stencil doesn't conflict with an operation already in the round.  The
+/// stencil read by an operation is the closed one-ring of each of its modified vertices.
+///
+// ---------------------------------------------------------
+
+bool MeshOperationScheduler::claim_stencil( const NonDestructiveTriMesh& mesh, const std::vector<size_t>& modified_vertices )
+{
+    m_read_vertices.clear();
+
+    for ( size_t i = 0; i < modified_vertices.size(); ++i )
+    {
+        size_t v = modified_vertices[i];
+
+        // modified vertices are also read, so this catches vertices modified by another operation too
+        if ( m_read_round[v] == m_round ) { return false; }
+
+        m_read_vertices.push_back( v );
+
+        const VertexAdjacencyList& incident_edges = mesh.m_vertex_to_edge_map[v];
+        for ( size_t e = 0; e < incident_edges.size(); ++e )
+        {
+            const Vec2st& edge = mesh.m_edges[ incident_edges[e] ];
+            m_read_vertices.push_back( edge[0] == v ? edge[1] : edge[0] );
+        }
+    }
+
+    for ( size_t i = 0; i < m_read_vertices.size(); ++i )
+    {
+        if ( m_modified_round[ m_read_vertices[i] ] == m_round ) { return false; }
+    }
+
+    for ( size_t i = 0; i < modified_vertices.size(); ++i )
+    {
+        m_modified_round[ modified_vertices[i] ] = m_round;
+    }
+
+    for ( size_t i = 0; i < m_read_vertices.size(); ++i )
+    {
+        m_read_round[ m_read_vertices[i] ] = m_round;
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------
+///
+/// Prepare to apply the round.  Sizes the grid of applied regions so that a cell is about as large as a region.
+///
+// ---------------------------------------------------------
+
+void MeshOperationScheduler::begin_apply( const std::vector<Vec3d>& region_lows, const std::vector<Vec3d>& region_highs )
+{
+    assert( region_lows.size() == region_highs.size() );
+
+    m_num_applied_regions = 0;
+
+    Vec3d xmin( BIG_DOUBLE ), xmax( -BIG_DOUBLE );
+    double total_extent = 0.0;
+
+    for ( size_t i = 0; i < region_lows.size(); ++i )
+    {
+        update_minmax( region_lows[i], xmin, xmax );
+        update_minmax( region_highs[i], xmin, xmax );
+        total_extent += max( region_highs[i] - region_lows[i] );
+    }
+
+    Vec3st dims( 1, 1, 1 );
+
+    if ( !region_lows.empty() && total_extent > 0.0 )
+    {
+        double cell_size = total_extent / region_lows.size();
+
+        for ( unsigned int i = 0; i < 3; ++i )
+        {
+            // keep the cells from being empty along a flat dimension
+            if ( xmax[i] <= xmin[i] ) { xmax[i] = xmin[i] + cell_size; }
+
+            double num_cells = ( xmax[i] - xmin[i] ) / cell_size;
+            dims[i] = (size_t) std::max( 1.0, std::min( (double) MAX_REGION_GRID_DIMENSION, num_cells ) );
+        }
+    }
+    else
+    {
+        xmin = Vec3d( 0.0 );
+        xmax = Vec3d( 1.0 );
+    }
+
+    m_applied_regions.set( dims, xmin, xmax );
+}
+
+// ---------------------------------------------------------
+///
+/// If the region doesn't overlap the region of an operation already applied this round, record it and return true
+///
+// ---------------------------------------------------------
+
+bool MeshOperationScheduler::claim_region( const Vec3d& low, const Vec3d& high )
+{
+    m_overlapping_regions.clear();
+    m_applied_regions.find_overlapping_elements( low, high, m_overlapping_regions );
+
+    if ( !m_overlapping_regions.empty() )
+    {
+        return false;
+    }
+
+    m_applied_regions.add_element( m_num_applied_regions++, low, high );
+
+    return true;
+}
@@ -0,0 +1,91 @@
+// ---------------------------------------------------------
+//
+//  meshoperationscheduler.h
+//
+//  Groups mesh improvement operations into rounds which can be checked concurrently.
+//
+// ---------------------------------------------------------
+
+#ifndef EL_TOPO_MESHOPERATIONSCHEDULER_H
+#define EL_TOPO_MESHOPERATIONSCHEDULER_H
+
+// ---------------------------------------------------------
+// Nested includes
+// ---------------------------------------------------------
+
+#include "accelerationgrid.h"
+#include <vector>
+
+// ---------------------------------------------------------
+//  Forwards and typedefs
+// ---------------------------------------------------------
+
+class NonDestructiveTriMesh;
+
+// ---------------------------------------------------------
+//  Class definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// Picks mesh operations (splits, flips, collapses) which can be checked at the same time, then applied one after
+/// another without invalidating each other's checks.
+///
+/// Each operation replaces the triangles around a set of "modified" vertices, and its checks read the closed one-ring
+/// of every modified vertex.  An operation joins the current round only if it modifies nothing read by an operation
+/// already in the round, and reads nothing modified by one.  Candidates are offered in priority order, so the round
+/// is a greedy independent set, and which operations end up in it doesn't depend on the number of threads.
+///
+/// The checks also look for collisions with any nearby geometry.  Once checked, the operations are applied in
+/// priority order, and an operation whose checked region overlaps the region of an operation already applied this
+/// round is deferred to a later round.
+///
+// --------------------------------------------------------
+
+class MeshOperationScheduler
+{
+
+public:
+
+    MeshOperationScheduler();
+
+    /// Start a new round, on a mesh with the given number of vertices
+    ///
+    void begin_round( size_t num_vertices );
+
+    /// Add an operation to the current round if its stencil doesn't conflict with an operation already in the round
+    ///
+    bool claim_stencil( const NonDestructiveTriMesh& mesh, const std::vector<size_t>& modified_vertices );
+
+    /// Prepare to apply the round, given the checked region of each operation which will be offered to claim_region
+    ///
+    void begin_apply( const std::vector<Vec3d>& region_lows, const std::vector<Vec3d>& region_highs );
+
+    /// If the region doesn't overlap the region of an operation already applied this round, record it and return true
+    ///
+    bool claim_region( const Vec3d& low, const Vec3d& high );
+
+private:
+
+    /// Current round number.  Vertex stamps equal to this belong to the current round.
+    ///
+    unsigned int m_round;
+
+    /// For each vertex, the last round in which an operation modified it or read it
+    ///
+    std::vector<unsigned int> m_modified_round;
+    std::vector<unsigned int> m_read_round;
+
+    /// Regions of the operations applied so far this round
+    ///
+    AccelerationGrid m_applied_regions;
+    size_t m_num_applied_regions;
+
+    /// Scratch space
+    ///
+    std::vector<size_t> m_read_vertices;
+    std::vector<size_t> m_overlapping_regions;
+
+};
+
+#endif
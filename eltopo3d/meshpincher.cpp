@@ -50,7 +50,7 @@ MeshPincher::PostPinchInfo::PostPinchInfo( PrePinchInfo& pre_pinch_info ) :
 void MeshPincher::partition_vertex_neighbourhood( size_t vertex_index, std::vector< TriangleSet >& connected_components )
 {
     // triangles incident to vertex
-	TriangleSet triangles_incident_to_vertex = m_surf.m_mesh.m_vertex_to_triangle_map[vertex_index];
+	TriangleSet triangles_incident_to_vertex( m_surf.m_mesh.m_vertex_to_triangle_map[vertex_index].begin(), m_surf.m_mesh.m_vertex_to_triangle_map[vertex_index].end() );
 	
     // unvisited triangles which are adjacent to some visited ones and incident to vt
     TriangleSet unvisited_triangles, visited_triangles;
@@ -153,8 +153,10 @@ bool MeshPincher::pull_apart_vertex( size_t vertex_index, const std::vector< Tri
         
         Vec3d added_vertex_position = (1.0 - dx) * m_surf.get_position(duplicate_vertex_index) + dx * centroid;
         
+        m_surf.begin_broad_phase_updates();
         m_surf.set_position( duplicate_vertex_index, added_vertex_position );
         m_surf.set_newposition( duplicate_vertex_index, added_vertex_position );
+        m_surf.commit_broad_phase_updates();
         
     }
     
@@ -181,7 +183,7 @@ bool MeshPincher::pull_apart_vertex( size_t vertex_index, const std::vector< Tri
                 
                 assert( tri_j[0] != tri_j[1] );
                 
-                if ( check_triangle_triangle_intersection( current_triangle, tri_j, m_surf.get_positions() ) )
+                if ( check_triangle_triangle_intersection( m_surf.m_ccd_backend, current_triangle, tri_j, m_surf.get_positions() ) )
                 {
                     // collision occurs - abort separation
                     collision_occurs = true;
@@ -195,7 +197,7 @@ bool MeshPincher::pull_apart_vertex( size_t vertex_index, const std::vector< Tri
         {
             for ( size_t j = i+1; j < triangles_to_add.size(); ++j ) 
             {
-                if ( check_triangle_triangle_intersection( triangles_to_add[i], triangles_to_add[j], m_surf.get_positions() ) )
+                if ( check_triangle_triangle_intersection( m_surf.m_ccd_backend, triangles_to_add[i], triangles_to_add[j], m_surf.get_positions() ) )
                 {
                     // collision occurs - abort separation
                     collision_occurs = true;
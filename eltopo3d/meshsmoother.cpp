@@ -208,7 +208,7 @@ void MeshSmoother::null_space_smooth_vertex( size_t v,
         return; 
     }
     
-    const std::vector<size_t>& edges = mesh.m_vertex_to_edge_map[v];
+    const VertexAdjacencyList& edges = mesh.m_vertex_to_edge_map[v];
     for ( size_t j = 0; j < edges.size(); ++j )
     {
         if ( mesh.m_edge_to_triangle_map[ edges[j] ].size() == 1 )
@@ -218,7 +218,7 @@ void MeshSmoother::null_space_smooth_vertex( size_t v,
         }
     }
     
-    const std::vector<size_t>& incident_triangles = mesh.m_vertex_to_triangle_map[v];
+    const VertexAdjacencyList& incident_triangles = mesh.m_vertex_to_triangle_map[v];
     
     std::vector< Vec3d > N;
     std::vector< double > W;
@@ -369,11 +369,13 @@ void MeshSmoother::process_mesh( )
     
     m_surf.m_velocities.resize( m_surf.get_num_vertices() );
     
+    m_surf.begin_broad_phase_updates();
     for ( size_t i = 0; i < m_surf.get_num_vertices(); ++i )
     {
         m_surf.set_newposition( i, m_surf.get_position(i) + (max_beta) * displacements[i] );
         m_surf.m_velocities[i] = (m_surf.get_newposition(i) - m_surf.get_position(i));
     }
+    m_surf.commit_broad_phase_updates();
     
     // repositioned locations stored in m_newpositions, but needs to be collision safe
     if ( m_surf.m_collision_safety )
@@ -403,10 +405,9 @@ void MeshSmoother::process_mesh( )
         // TODO: Replace this with a cut-back and re-integrate
         // Actually, a call to DynamicSurface::integrate(dt) would be even better
         
-        std::vector<Intersection> intersections;
-        m_surf.m_collision_pipeline.get_intersections( false, true, intersections );
+        Intersection intersection( 0, 0 );
         
-        if ( intersections.size() != 0 )
+        if ( m_surf.m_collision_pipeline.get_first_intersection( false, true, intersection ) )
         {
             // couldn't fix collisions!
             std::cerr << "WARNING: Aborting mesh null-space smoothing due to CCD problem" << std::endl;
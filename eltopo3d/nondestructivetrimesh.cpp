@@ -15,6 +15,7 @@
 
 #include "nondestructivetrimesh.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdarg>
 #include <cstdlib>
@@ -36,10 +37,71 @@ const static unsigned int i_plus_one_mod_three[3] = {1,2,0};
 // Static function definitions
 // ---------------------------------------------------------
 
+// --------------------------------------------------------
+///
+/// Hash a sorted vertex pair for the edge hash table
+///
+// --------------------------------------------------------
+
+static inline size_t hash_vertex_pair( size_t vtx0, size_t vtx1 )
+{
+    unsigned long long h = static_cast<unsigned long long>(vtx0) * 0x9E3779B97F4A7C15ULL + static_cast<unsigned long long>(vtx1);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return static_cast<size_t>(h);
+}
+
+// --------------------------------------------------------
+///
+/// Bytes held by an array of adjacency lists, including the lists' own storage
+///
+// --------------------------------------------------------
+
+#ifdef ELTOPO_COMPACT_ADJACENCY
+template<unsigned int N>
+static size_t list_footprint( const SmallIndexList<N>& list )
+{
+    return list.memory_footprint();
+}
+#else
+static size_t list_footprint( const std::vector<size_t>& list )
+{
+    return sizeof(list) + list.capacity() * sizeof(size_t);
+}
+#endif
+
+template<class List>
+static size_t adjacency_footprint( const std::vector<List>& lists )
+{
+    size_t bytes = ( lists.capacity() - lists.size() ) * sizeof(List);
+    for ( size_t i = 0; i < lists.size(); ++i )
+    {
+        bytes += list_footprint( lists[i] );
+    }
+    return bytes;
+}
+
 // ---------------------------------------------------------
 // Member function definitions
 // ---------------------------------------------------------
 
+// --------------------------------------------------------
+
+NonDestructiveTriMesh::NonDestructiveTriMesh() :
+    m_edges(),
+    m_is_boundary_edge(),
+    m_is_boundary_vertex(),
+    m_vertex_to_edge_map(),
+    m_vertex_to_triangle_map(),
+    m_edge_to_triangle_map(),
+    m_triangle_to_edge_map(),
+    m_tris(),
+    m_edge_hash(),
+    m_edge_hash_num_occupied(0)
+{}
+
+
 // --------------------------------------------------------
 ///
 /// Clear all mesh information
@@ -67,7 +129,7 @@ void NonDestructiveTriMesh::add_vertex(size_t tri)
     for(unsigned int i = 0; i < 3; i++)
     {
         // Get the set of triangles incident on vertex t[i]
-        std::vector<size_t>& vt = m_vertex_to_triangle_map[t[i]];
+        VertexAdjacencyList& vt = m_vertex_to_triangle_map[t[i]];
         
         for( int j = 0; j < (int)vt.size(); j++ )
         {
@@ -88,7 +150,7 @@ void NonDestructiveTriMesh::add_vertex(size_t tri)
     {
         size_t inc_edge = te[i];
         
-        std::vector<size_t>& et = m_edge_to_triangle_map[inc_edge];
+        EdgeAdjacencyList& et = m_edge_to_triangle_map[inc_edge];
         
         for( int j = 0; j < (int) et.size(); j++)
         {
@@ -276,13 +338,18 @@ size_t NonDestructiveTriMesh::add_edge(size_t vtx0, size_t vtx1)
     size_t edge_index = m_edges.size();
     m_edges.push_back(Vec2st(vtx0, vtx1));
     
-    m_edge_to_triangle_map.push_back( std::vector<size_t>( 0 ) );
+    m_edge_to_triangle_map.push_back( EdgeAdjacencyList() );
     
     m_is_boundary_edge.push_back( true );
     
     m_vertex_to_edge_map[vtx0].push_back(edge_index);
     m_vertex_to_edge_map[vtx1].push_back(edge_index);
     
+    if ( vtx0 != vtx1 )
+    {
+        edge_hash_insert( vtx0, vtx1, edge_index );
+    }
+    
     return edge_index;
 }
 
@@ -297,7 +364,7 @@ void NonDestructiveTriMesh::remove_edge( size_t edge_index )
 {
     // vertex 0
     {
-        std::vector<size_t>& vertex_to_edge_map = m_vertex_to_edge_map[ m_edges[edge_index][0] ];
+        VertexAdjacencyList& vertex_to_edge_map = m_vertex_to_edge_map[ m_edges[edge_index][0] ];
         for ( int i=0; i < (int)vertex_to_edge_map.size(); ++i)
         {
             if ( vertex_to_edge_map[i] == edge_index )
@@ -310,7 +377,7 @@ void NonDestructiveTriMesh::remove_edge( size_t edge_index )
     
     // vertex 1
     {
-        std::vector<size_t>& vertex_to_edge_map = m_vertex_to_edge_map[ m_edges[edge_index][1] ];
+        VertexAdjacencyList& vertex_to_edge_map = m_vertex_to_edge_map[ m_edges[edge_index][1] ];
         for ( int i=0; i < (int)vertex_to_edge_map.size(); ++i)
         {
             if ( vertex_to_edge_map[i] == edge_index )
@@ -321,12 +388,137 @@ void NonDestructiveTriMesh::remove_edge( size_t edge_index )
         }
     }
     
+    if ( m_edges[edge_index][0] != m_edges[edge_index][1] )
+    {
+        edge_hash_remove( m_edges[edge_index][0], m_edges[edge_index][1] );
+    }
+    
     m_edges[edge_index][0] = 0;
     m_edges[edge_index][1] = 0; 
     
 }
 
 
+// --------------------------------------------------------
+///
+/// Add a live edge to the edge hash table.  The vertex pair must not already be in the table.
+///
+// --------------------------------------------------------
+
+void NonDestructiveTriMesh::edge_hash_insert( size_t vtx0, size_t vtx1, size_t edge_index )
+{
+    // keep the load factor (including removed markers) at or below three quarters
+    if ( 4 * ( m_edge_hash_num_occupied + 1 ) > 3 * m_edge_hash.size() )
+    {
+        edge_hash_rehash( 0 );
+    }
+    
+    if ( vtx1 < vtx0 ) { std::swap( vtx0, vtx1 ); }
+    
+    const size_t mask = m_edge_hash.size() - 1;
+    size_t slot = hash_vertex_pair( vtx0, vtx1 ) & mask;
+    
+    while ( m_edge_hash[slot].m_edge_index != EDGE_HASH_EMPTY && m_edge_hash[slot].m_edge_index != EDGE_HASH_REMOVED )
+    {
+        assert( m_edge_hash[slot].m_vtx0 != vtx0 || m_edge_hash[slot].m_vtx1 != vtx1 );
+        slot = ( slot + 1 ) & mask;
+    }
+    
+    if ( m_edge_hash[slot].m_edge_index == EDGE_HASH_EMPTY )
+    {
+        ++m_edge_hash_num_occupied;
+    }
+    
+    assert( edge_index < EDGE_HASH_REMOVED );
+    
+    m_edge_hash[slot].m_vtx0 = static_cast<EdgeHashIndex>(vtx0);
+    m_edge_hash[slot].m_vtx1 = static_cast<EdgeHashIndex>(vtx1);
+    m_edge_hash[slot].m_edge_index = static_cast<EdgeHashIndex>(edge_index);
+}
+
+
+// --------------------------------------------------------
+///
+/// Remove a live edge from the edge hash table, leaving a removed marker so later probe sequences aren't broken.
+///
+// --------------------------------------------------------
+
+void NonDestructiveTriMesh::edge_hash_remove( size_t vtx0, size_t vtx1 )
+{
+    if ( vtx1 < vtx0 ) { std::swap( vtx0, vtx1 ); }
+    
+    assert( !m_edge_hash.empty() );
+    
+    const size_t mask = m_edge_hash.size() - 1;
+    size_t slot = hash_vertex_pair( vtx0, vtx1 ) & mask;
+    
+    while ( m_edge_hash[slot].m_edge_index != EDGE_HASH_EMPTY )
+    {
+        if ( m_edge_hash[slot].m_edge_index != EDGE_HASH_REMOVED && 
+             m_edge_hash[slot].m_vtx0 == vtx0 && m_edge_hash[slot].m_vtx1 == vtx1 )
+        {
+            m_edge_hash[slot].m_edge_index = EDGE_HASH_REMOVED;
+            return;
+        }
+        slot = ( slot + 1 ) & mask;
+    }
+    
+    assert( !"edge not found in edge hash table" );
+}
+
+
+// --------------------------------------------------------
+///
+/// Reinsert all live edges into a table of at least min_capacity slots, at most half full.  Drops removed markers.
+///
+// --------------------------------------------------------
+
+void NonDestructiveTriMesh::edge_hash_rehash( size_t min_capacity )
+{
+    std::vector<EdgeHashSlot> live;
+    for ( size_t i = 0; i < m_edge_hash.size(); ++i )
+    {
+        if ( m_edge_hash[i].m_edge_index != EDGE_HASH_EMPTY && m_edge_hash[i].m_edge_index != EDGE_HASH_REMOVED )
+        {
+            live.push_back( m_edge_hash[i] );
+        }
+    }
+    
+    size_t capacity = 64;
+    while ( capacity < min_capacity || capacity < 2 * ( live.size() + 1 ) )
+    {
+        capacity *= 2;
+    }
+    
+    EdgeHashSlot empty_slot;
+    empty_slot.m_vtx0 = empty_slot.m_vtx1 = 0;
+    empty_slot.m_edge_index = EDGE_HASH_EMPTY;
+    
+    m_edge_hash.assign( capacity, empty_slot );
+    m_edge_hash_num_occupied = live.size();
+    
+    const size_t mask = capacity - 1;
+    for ( size_t i = 0; i < live.size(); ++i )
+    {
+        size_t slot = hash_vertex_pair( live[i].m_vtx0, live[i].m_vtx1 ) & mask;
+        while ( m_edge_hash[slot].m_edge_index != EDGE_HASH_EMPTY )
+        {
+            slot = ( slot + 1 ) & mask;
+        }
+        m_edge_hash[slot] = live[i];
+    }
+}
+
+
+// --------------------------------------------------------
+
+void NonDestructiveTriMesh::edge_hash_clear()
+{
+    m_edge_hash.clear();
+    m_edge_hash_num_occupied = 0;
+}
+
+
 // --------------------------------------------------------
 
 void NonDestructiveTriMesh::update_is_boundary_vertex( size_t v )
@@ -357,23 +549,29 @@ size_t NonDestructiveTriMesh::get_edge_index(size_t vtx0, size_t vtx1) const
     assert( vtx0 < m_vertex_to_edge_map.size() );
     assert( vtx1 < m_vertex_to_edge_map.size() );
     
-    const std::vector<size_t>& edges0 = m_vertex_to_edge_map[vtx0];
-    const std::vector<size_t>& edges1 = m_vertex_to_edge_map[vtx1];
+    if ( vtx0 == vtx1 || m_edge_hash.empty() )
+    {
+        return m_edges.size();
+    }
+    
+    const size_t lo = min( vtx0, vtx1 );
+    const size_t hi = max( vtx0, vtx1 );
+    
+    const size_t mask = m_edge_hash.size() - 1;
+    size_t slot = hash_vertex_pair( lo, hi ) & mask;
     
-    for(size_t e0 = 0; e0 < edges0.size(); e0++)
+    // the table always has empty slots, so this terminates
+    while ( m_edge_hash[slot].m_edge_index != EDGE_HASH_EMPTY )
     {
-        size_t edge0 = edges0[e0];
-        
-        for(size_t e1 = 0; e1 < edges1.size(); e1++)
+        const EdgeHashSlot& s = m_edge_hash[slot];
+        if ( s.m_edge_index != EDGE_HASH_REMOVED && s.m_vtx0 == lo && s.m_vtx1 == hi )
         {
-            if( edge0 == edges1[e1] && m_edges[edge0][0] != m_edges[edge0][1] )
-            {
-                assert( ( m_edges[edge0][0] == vtx0 && m_edges[edge0][1] == vtx1 ) ||
-                       ( m_edges[edge0][1] == vtx0 && m_edges[edge0][0] == vtx1 ) );
-                
-                return edge0;
-            }
+            assert( ( m_edges[s.m_edge_index][0] == vtx0 && m_edges[s.m_edge_index][1] == vtx1 ) ||
+                   ( m_edges[s.m_edge_index][1] == vtx0 && m_edges[s.m_edge_index][0] == vtx1 ) );
+            
+            return s.m_edge_index;
         }
+        slot = ( slot + 1 ) & mask;
     }
     
     return m_edges.size();
@@ -390,7 +588,7 @@ size_t NonDestructiveTriMesh::get_triangle_index( size_t vtx0, size_t vtx1, size
 {
     Vec3st verts( vtx0, vtx1, vtx2 );
     
-    const std::vector<size_t>& triangles0 = m_vertex_to_triangle_map[vtx0];
+    const VertexAdjacencyList& triangles0 = m_vertex_to_triangle_map[vtx0];
     for ( size_t i = 0; i < triangles0.size(); ++i )
     {
         if ( triangle_has_these_verts( m_tris[triangles0[i]], verts ) )
@@ -405,6 +603,26 @@ size_t NonDestructiveTriMesh::get_triangle_index( size_t vtx0, size_t vtx1, size
 
 
 
+// --------------------------------------------------------
+///
+/// Approximate number of bytes held by the triangles and all connectivity structures (ignores allocator overhead)
+///
+// --------------------------------------------------------
+
+size_t NonDestructiveTriMesh::memory_footprint() const
+{
+    size_t bytes = m_tris.capacity() * sizeof(Vec3st);
+    bytes += m_edges.capacity() * sizeof(Vec2st);
+    bytes += m_triangle_to_edge_map.capacity() * sizeof(Vec3st);
+    bytes += ( m_is_boundary_edge.capacity() + m_is_boundary_vertex.capacity() ) / 8;
+    bytes += adjacency_footprint( m_vertex_to_edge_map );
+    bytes += adjacency_footprint( m_vertex_to_triangle_map );
+    bytes += adjacency_footprint( m_edge_to_triangle_map );
+    bytes += m_edge_hash.capacity() * sizeof(EdgeHashSlot);
+    return bytes;
+}
+
+
 // --------------------------------------------------------
 ///
 /// Remove triangles which have been deleted by add_vertex
@@ -460,6 +678,7 @@ void NonDestructiveTriMesh::clear_auxiliary_structures()
     m_triangle_to_edge_map.clear();
     m_is_boundary_edge.clear();
     m_is_boundary_vertex.clear();
+    edge_hash_clear();
     
 }
 
@@ -488,6 +707,14 @@ void NonDestructiveTriMesh::rebuild_auxiliary_structures( )
     m_vertex_to_edge_map.resize(nv);
     m_triangle_to_edge_map.resize(m_tris.size());
     
+    // A closed mesh has 3/2 edges per triangle; size the edge structures for that up front.  The hash table gets the 
+    // same capacity a rehash would give that many edges (at most half full), so building a closed mesh never regrows it.
+    const size_t expected_num_edges = 3 * m_tris.size() / 2;
+    m_edges.reserve( expected_num_edges );
+    m_edge_to_triangle_map.reserve( expected_num_edges );
+    m_is_boundary_edge.reserve( expected_num_edges );
+    edge_hash_rehash( 2 * expected_num_edges + 2 );
+    
     for(size_t i = 0; i < m_tris.size(); i++)
     {
         Vec3st& t = m_tris[i];
@@ -21,6 +21,29 @@
 #include <vector>
 #include "../common/vec.h"
 
+#ifdef ELTOPO_COMPACT_ADJACENCY
+#include "smallindexlist.h"
+#endif
+
+// ---------------------------------------------------------
+//  Forwards and typedefs
+// ---------------------------------------------------------
+
+#ifdef ELTOPO_COMPACT_ADJACENCY
+
+/// Edges or triangles incident on a vertex.  The inline capacity covers the valence of a regular mesh.
+typedef SmallIndexList<6> VertexAdjacencyList;
+
+/// Triangles incident on an edge.  The inline capacity covers a manifold edge.
+typedef SmallIndexList<2> EdgeAdjacencyList;
+
+#else
+
+typedef std::vector<size_t> VertexAdjacencyList;
+typedef std::vector<size_t> EdgeAdjacencyList;
+
+#endif
+
 // ---------------------------------------------------------
 //  Function declarations
 // ---------------------------------------------------------
@@ -44,6 +67,8 @@ class NonDestructiveTriMesh
     
 public:
     
+    NonDestructiveTriMesh();
+    
     /// accessors
     inline const std::vector<Vec3st>& get_triangles() const;
     inline const Vec3st& get_triangle( size_t index ) const;
@@ -125,6 +150,10 @@ public:
     inline bool edge_is_deleted( size_t edge_index ) const;
     inline bool vertex_is_deleted( size_t vertex_index ) const;
     
+    /// Approximate number of bytes held by the triangles and all connectivity structures
+    ///
+    size_t memory_footprint() const;
+    
     // ---------------------------------------------------------
     // Data members
     
@@ -142,15 +171,15 @@ public:
     
     /// Edges incident on vertices (given a vertex, which edges is it incident on)
     ///
-    std::vector<std::vector<size_t> > m_vertex_to_edge_map; 
+    std::vector<VertexAdjacencyList> m_vertex_to_edge_map; 
     
     /// Triangles incident on vertices (given a vertex, which triangles is it incident on)
     ///
-    std::vector<std::vector<size_t> > m_vertex_to_triangle_map;    
+    std::vector<VertexAdjacencyList> m_vertex_to_triangle_map;    
     
     /// Triangles incident on edges (given an edge, which triangles is it incident on)
     ///
-    std::vector<std::vector<size_t> > m_edge_to_triangle_map;    
+    std::vector<EdgeAdjacencyList> m_edge_to_triangle_map;    
     
     /// Edges around triangles (given a triangle, which 3 edges does it contain)
     ///
@@ -162,10 +191,43 @@ private:
     size_t add_edge(size_t vtx0, size_t vtx1);
     void remove_edge( size_t edge_index );
     
+    /// Edge hash table maintenance, called from add_edge and remove_edge
+    ///
+    void edge_hash_insert( size_t vtx0, size_t vtx1, size_t edge_index );
+    void edge_hash_remove( size_t vtx0, size_t vtx1 );
+    void edge_hash_rehash( size_t min_capacity );
+    void edge_hash_clear();
+    
+#ifdef ELTOPO_COMPACT_ADJACENCY
+    typedef unsigned int EdgeHashIndex;
+#else
+    typedef size_t EdgeHashIndex;
+#endif
+    
+    /// Slot in the edge hash table.  Keyed on the sorted vertex pair of an edge.
+    ///
+    struct EdgeHashSlot
+    {
+        EdgeHashIndex m_vtx0, m_vtx1;      // m_vtx0 < m_vtx1
+        EdgeHashIndex m_edge_index;        // EDGE_HASH_EMPTY or EDGE_HASH_REMOVED if the slot holds no edge
+    };
+    
+    static const EdgeHashIndex EDGE_HASH_EMPTY = ~static_cast<EdgeHashIndex>(0);
+    static const EdgeHashIndex EDGE_HASH_REMOVED = ~static_cast<EdgeHashIndex>(0) - 1;
+    
     /// List of triangles: the fundamental data
     ///
     std::vector<Vec3st> m_tris;
     
+    /// Open-addressing (linear probing) hash table from vertex pairs to live edges, so get_edge_index doesn't have to 
+    /// scan the vertex-to-edge map.  Capacity is zero or a power of two.
+    ///
+    std::vector<EdgeHashSlot> m_edge_hash;
+    
+    /// Number of slots in m_edge_hash holding either a live edge or a removed marker
+    ///
+    size_t m_edge_hash_num_occupied;
+    
 };
 
 // ---------------------------------------------------------
@@ -277,7 +339,7 @@ inline void NonDestructiveTriMesh::get_adjacent_triangles( size_t triangle_index
 inline void NonDestructiveTriMesh::get_adjacent_vertices( size_t vertex_index, std::vector<size_t>& adjacent_vertices ) const
 {
     adjacent_vertices.clear();
-    const std::vector<size_t>& incident_edges = m_vertex_to_edge_map[vertex_index];
+    const VertexAdjacencyList& incident_edges = m_vertex_to_edge_map[vertex_index];
     
     for ( size_t i = 0; i < incident_edges.size(); ++i )
     {
@@ -0,0 +1,189 @@
+// ---------------------------------------------------------
+//
+//  smallindexlist.h
+//
+//  Compact list of 32-bit element indices with inline storage, used for mesh adjacency when
+//  ELTOPO_COMPACT_ADJACENCY is defined.
+//
+// ---------------------------------------------------------
+
+#ifndef EL_TOPO_SMALLINDEXLIST_H
+#define EL_TOPO_SMALLINDEXLIST_H
+
+// ---------------------------------------------------------
+// Nested includes
+// ---------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// ---------------------------------------------------------
+//  Class definitions
+// ---------------------------------------------------------
+
+// --------------------------------------------------------
+///
+/// A list of up to 2^32-1 indices which stores its first N entries inside the object itself, only going to the heap when
+/// it grows past N.  With N chosen to cover the typical valence, an array of these needs no per-element heap blocks and
+/// uses half the index storage of std::vector<size_t>.  Supports the subset of the std::vector interface used to read and
+/// update mesh adjacency.
+///
+// --------------------------------------------------------
+
+template<unsigned int N>
+class SmallIndexList
+{
+
+public:
+
+    typedef unsigned int value_type;
+    typedef unsigned int* iterator;
+    typedef const unsigned int* const_iterator;
+
+    SmallIndexList() :
+        m_size(0),
+        m_capacity(N)
+    {}
+
+    SmallIndexList( const SmallIndexList& other ) :
+        m_size(0),
+        m_capacity(N)
+    {
+        assign( other );
+    }
+
+    SmallIndexList( SmallIndexList&& other ) noexcept :
+        m_size(0),
+        m_capacity(N)
+    {
+        steal( other );
+    }
+
+    ~SmallIndexList()
+    {
+        if ( on_heap() ) { std::free( m_storage.m_heap ); }
+    }
+
+    SmallIndexList& operator=( const SmallIndexList& other )
+    {
+        if ( this != &other ) { assign( other ); }
+        return *this;
+    }
+
+    SmallIndexList& operator=( SmallIndexList&& other ) noexcept
+    {
+        if ( this != &other )
+        {
+            clear();
+            steal( other );
+        }
+        return *this;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    size_t operator[]( size_t i ) const
+    {
+        assert( i < m_size );
+        return data()[i];
+    }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+
+    void push_back( size_t index )
+    {
+        assert( index == static_cast<unsigned int>(index) );
+        if ( m_size == m_capacity ) { grow(); }
+        data()[m_size++] = static_cast<unsigned int>(index);
+    }
+
+    /// Remove the entry at the given position, preserving the order of the rest
+    ///
+    iterator erase( iterator position )
+    {
+        assert( position >= begin() && position < end() );
+        std::memmove( position, position + 1, ( end() - position - 1 ) * sizeof(unsigned int) );
+        --m_size;
+        return position;
+    }
+
+    /// Remove all entries and give back any heap storage
+    ///
+    void clear()
+    {
+        if ( on_heap() ) { std::free( m_storage.m_heap ); }
+        m_size = 0;
+        m_capacity = N;
+    }
+
+    /// Bytes used by this list, including its heap block if it has one
+    ///
+    size_t memory_footprint() const
+    {
+        return sizeof(*this) + ( on_heap() ? m_capacity * sizeof(unsigned int) : 0 );
+    }
+
+private:
+
+    bool on_heap() const { return m_capacity > N; }
+
+    unsigned int* data() { return on_heap() ? m_storage.m_heap : m_storage.m_inline; }
+    const unsigned int* data() const { return on_heap() ? m_storage.m_heap : m_storage.m_inline; }
+
+    void grow()
+    {
+        unsigned int new_capacity = 2 * m_capacity;
+        unsigned int* new_data = static_cast<unsigned int*>( std::malloc( new_capacity * sizeof(unsigned int) ) );
+        if ( new_data == NULL ) { throw std::bad_alloc(); }
+        std::memcpy( new_data, data(), m_size * sizeof(unsigned int) );
+        if ( on_heap() ) { std::free( m_storage.m_heap ); }
+        m_storage.m_heap = new_data;
+        m_capacity = new_capacity;
+    }
+
+    void assign( const SmallIndexList& other )
+    {
+        clear();
+        while ( m_capacity < other.m_size ) { grow(); }
+        std::memcpy( data(), other.data(), other.m_size * sizeof(unsigned int) );
+        m_size = other.m_size;
+    }
+
+    /// Take other's contents, leaving it empty.  This list must be empty and not on the heap.
+    ///
+    void steal( SmallIndexList& other )
+    {
+        if ( other.on_heap() )
+        {
+            m_storage.m_heap = other.m_storage.m_heap;
+        }
+        else
+        {
+            std::memcpy( m_storage.m_inline, other.m_storage.m_inline, other.m_size * sizeof(unsigned int) );
+        }
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_size = 0;
+        other.m_capacity = N;
+    }
+
+    unsigned int m_size;
+    unsigned int m_capacity;
+
+    union Storage
+    {
+        unsigned int m_inline[N];
+        unsigned int* m_heap;
+    } m_storage;
+
+};
+
+
+#endif
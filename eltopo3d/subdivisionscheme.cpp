@@ -78,7 +78,7 @@ void ButterflyScheme::generate_new_midpoint( size_t edge_index, const SurfTrack&
 	
 	for ( size_t i = 0; i < 4; ++i )
 	{
-		const std::vector<size_t>& adj_tris = mesh.m_edge_to_triangle_map[ adj_edges[i] ];
+		const EdgeAdjacencyList& adj_tris = mesh.m_edge_to_triangle_map[ adj_edges[i] ];
 		if ( adj_tris.size() != 2 )
 		{
             // abort
@@ -249,7 +249,7 @@ void ModifiedButterflyScheme::generate_new_midpoint( size_t edge_index, const Su
     size_t p1_index = mesh.m_edges[edge_index][0];
 	size_t p2_index = mesh.m_edges[edge_index][1];
     
-    const std::vector<size_t>& p1_edges = mesh.m_vertex_to_edge_map[p1_index];
+    const VertexAdjacencyList& p1_edges = mesh.m_vertex_to_edge_map[p1_index];
     size_t p1_degree = p1_edges.size();
     std::vector<size_t> p1_adjacent_vertices;
     bool locally_manifold = get_adjacent_vertices_ordered( p1_index, edge_index, mesh, p1_adjacent_vertices );      
@@ -260,7 +260,7 @@ void ModifiedButterflyScheme::generate_new_midpoint( size_t edge_index, const Su
     }
     assert( p1_adjacent_vertices.size() == p1_degree );
     
-    const std::vector<size_t>& p2_edges = mesh.m_vertex_to_edge_map[p2_index];
+    const VertexAdjacencyList& p2_edges = mesh.m_vertex_to_edge_map[p2_index];
     size_t p2_degree = p2_edges.size();
     std::vector<size_t> p2_adjacent_vertices;
     locally_manifold = get_adjacent_vertices_ordered( p2_index, edge_index, mesh, p2_adjacent_vertices );      
@@ -61,6 +61,7 @@ const double G_EIGENVALUE_RANK_RATIO = 0.03;
 // ---------------------------------------------------------
 
 SurfTrackInitializationParameters::SurfTrackInitializationParameters() :
+    m_verbose( false ),
     m_proximity_epsilon( 1e-4 ),
     m_friction_coefficient( 0.0 ),
     m_min_triangle_area( 1e-7 ),
@@ -82,10 +83,161 @@ SurfTrackInitializationParameters::SurfTrackInitializationParameters() :
     m_collision_safety(true),
     m_allow_topology_changes(true),
     m_allow_non_manifold(true),
-    m_perform_improvement(true)
+    m_perform_improvement(true),
+    m_num_threads(1),
+    m_parallel_remeshing(false),
+    m_ccd_backend( default_ccd_backend() )
 {}
 
 
+// ---------------------------------------------------------
+///
+/// Start out disabled
+///
+// ---------------------------------------------------------
+
+VertexCurvatureCache::VertexCurvatureCache() :
+    m_enabled( false ),
+    m_curvatures(),
+    m_is_valid(),
+    m_adjacent_vertices()
+{}
+
+// ---------------------------------------------------------
+///
+/// Compute the curvature of every vertex, in parallel, and keep it up to date until disabled
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::enable( const SurfTrack& surf )
+{
+    m_enabled = true;
+    
+    m_curvatures.resize( surf.get_num_vertices() );
+    m_is_valid.assign( surf.get_num_vertices(), 1 );
+    
+    #pragma omp parallel for schedule(static) num_threads(surf.m_num_threads)
+    for ( int i = 0; i < (int) surf.get_num_vertices(); ++i )
+    {
+        m_curvatures[i] = inv_min_radius_curvature( surf, i );
+    }
+}
+
+// ---------------------------------------------------------
+///
+/// Stop caching
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::disable()
+{
+    m_enabled = false;
+    m_curvatures.clear();
+    m_is_valid.clear();
+}
+
+// ---------------------------------------------------------
+///
+/// Get the curvature of a vertex, from the cache if possible
+///
+// ---------------------------------------------------------
+
+double VertexCurvatureCache::get_curvature( const SurfTrack& surf, size_t vertex ) const
+{
+    if ( !m_enabled )
+    {
+        return inv_min_radius_curvature( surf, vertex );
+    }
+    
+    if ( vertex >= m_is_valid.size() )
+    {
+        // added by a split
+        m_curvatures.resize( vertex + 1 );
+        m_is_valid.resize( vertex + 1, 0 );
+    }
+    
+    if ( !m_is_valid[vertex] )
+    {
+        m_curvatures[vertex] = inv_min_radius_curvature( surf, vertex );
+        m_is_valid[vertex] = 1;
+    }
+    
+    return m_curvatures[vertex];
+}
+
+// ---------------------------------------------------------
+///
+/// Forget the curvature of the given vertex and its neighbours
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::invalidate_one_ring( const SurfTrack& surf, size_t vertex )
+{
+    surf.m_mesh.get_adjacent_vertices( vertex, m_adjacent_vertices );
+    m_adjacent_vertices.push_back( vertex );
+    
+    for ( size_t i = 0; i < m_adjacent_vertices.size(); ++i )
+    {
+        if ( m_adjacent_vertices[i] < m_is_valid.size() )
+        {
+            m_is_valid[ m_adjacent_vertices[i] ] = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------
+///
+/// A split changes the neighbourhoods of the new vertex and its neighbours
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::operationOccurred( const SurfTrack& surf, const EdgeSplitter::PostEdgeSplitInfo& info )
+{
+    if ( !m_enabled ) { return; }
+    invalidate_one_ring( surf, info.m_new_vertex );
+}
+
+// ---------------------------------------------------------
+///
+/// A flip changes the neighbourhoods of the four vertices of the two new triangles
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::operationOccurred( const SurfTrack& surf, const EdgeFlipper::PostEdgeFlipInfo& info )
+{
+    if ( !m_enabled ) { return; }
+    
+    const size_t new_triangles[2] = { info.m_new_triangle_index_0, info.m_new_triangle_index_1 };
+    
+    for ( unsigned int i = 0; i < 2; ++i )
+    {
+        const Vec3st& tri = surf.m_mesh.get_triangle( new_triangles[i] );
+        for ( unsigned int j = 0; j < 3; ++j )
+        {
+            if ( tri[j] < m_is_valid.size() ) { m_is_valid[ tri[j] ] = 0; }
+        }
+    }
+}
+
+// ---------------------------------------------------------
+///
+/// A collapse moves the vertex it keeps, which changes the neighbourhoods of that vertex and its neighbours
+///
+// ---------------------------------------------------------
+
+void VertexCurvatureCache::operationOccurred( const SurfTrack& surf, const EdgeCollapser::PostEdgeCollapseInfo& info )
+{
+    if ( !m_enabled ) { return; }
+    
+    invalidate_one_ring( surf, info.m_pre_collapse_info.m_vertex_to_keep );
+    
+    if ( info.m_pre_collapse_info.m_vertex_to_delete < m_is_valid.size() )
+    {
+        m_is_valid[ info.m_pre_collapse_info.m_vertex_to_delete ] = 0;
+    }
+}
+
+
 // ---------------------------------------------------------
 ///
 /// Create a SurfTrack object from a set of vertices and triangles using the specified paramaters
@@ -101,7 +253,8 @@ SurfTrack::SurfTrack( const std::vector<Vec3d>& vs,
                    masses,
                    initial_parameters.m_proximity_epsilon, 
                    initial_parameters.m_friction_coefficient,
-                   initial_parameters.m_collision_safety ),
+                   initial_parameters.m_collision_safety,
+                   initial_parameters.m_verbose ),
     m_collapser( *this, initial_parameters.m_use_curvature_when_collapsing, initial_parameters.m_min_curvature_multiplier ),
     m_splitter( *this, initial_parameters.m_use_curvature_when_splitting, initial_parameters.m_max_curvature_multiplier ),
     m_flipper( *this, initial_parameters.m_edge_flip_min_length_change ),
@@ -123,8 +276,11 @@ SurfTrack::SurfTrack( const std::vector<Vec3d>& vs,
     m_allow_non_manifold( initial_parameters.m_allow_non_manifold ),
     m_perform_improvement( initial_parameters.m_perform_improvement ),
     m_allow_vertex_movement( initial_parameters.m_allow_vertex_movement ),
+    m_parallel_remeshing( initial_parameters.m_parallel_remeshing ),
+    m_curvature_cache(),
     m_vertex_change_history(),
-    m_triangle_change_history()
+    m_triangle_change_history(),
+    m_last_defrag_info()
 {
     
     if ( m_verbose )
@@ -136,6 +292,13 @@ SurfTrack::SurfTrack( const std::vector<Vec3d>& vs,
         std::cout << "initial_parameters.m_use_fraction: " << initial_parameters.m_use_fraction << std::endl;
     }
     
+    m_num_threads = initial_parameters.m_num_threads;
+    m_ccd_backend = initial_parameters.m_ccd_backend;
+    
+    m_splitter.add_observer( &m_curvature_cache );
+    m_flipper.add_observer( &m_curvature_cache );
+    m_collapser.add_observer( &m_curvature_cache );
+    
     if ( m_collision_safety )
     {
         rebuild_static_broad_phase();
@@ -313,85 +476,61 @@ void SurfTrack::defrag_mesh( )
     
     std::vector<Vec2st> old_edges = m_mesh.m_edges;
     
-    PostDefragInfo info;
+    PostDefragInfo& info = m_last_defrag_info;
     info.m_defragged_vertex_map.clear();
+    info.m_defragged_triangle_map.clear();
     
     //
-    // First clear deleted vertices from the data stuctures
-    // 
-    
-    // do a quick pass through to see if any vertices have been deleted
-    bool any_deleted = false;
-    for ( size_t i = 0; i < get_num_vertices(); ++i )
-    {  
-        if ( m_mesh.vertex_is_deleted(i) )
-        {
-            any_deleted = true;
-            break;
-        }
-    }    
+    // Compact the vertex data, recording where each surviving vertex goes
+    //
     
-    if ( !any_deleted )
-    {
-        for ( size_t i = 0; i < get_num_vertices(); ++i )
-        {
-            info.m_defragged_vertex_map.push_back( Vec2st(i,i) );
-        }
-    }
-    else
-    {
-        
-        // Note: We could rebuild the mesh from scratch, rather than adding/removing 
-        // triangles, however this function is not a major computational bottleneck.
-        
-        size_t j = 0;
-        
-        std::vector<Vec3st> new_tris = m_mesh.get_triangles();
+    const size_t old_num_vertices = get_num_vertices();
+    std::vector<size_t> new_vertex_index( old_num_vertices, UNINITIALIZED_SIZE_T );
+    info.m_defragged_vertex_map.reserve( old_num_vertices );
+    
+    size_t j = 0;
+    for ( size_t i = 0; i < old_num_vertices; ++i )
+    {      
+        if ( m_mesh.vertex_is_deleted(i) ) { continue; }
         
-        for ( size_t i = 0; i < get_num_vertices(); ++i )
-        {      
-            if ( !m_mesh.vertex_is_deleted(i) )
-            {
-                pm_positions[j] = pm_positions[i];
-                pm_newpositions[j] = pm_newpositions[i];
-                m_masses[j] = m_masses[i];
-                
-                info.m_defragged_vertex_map.push_back( Vec2st(i,j) );
-                
-                // Now rewire the triangles containting vertex i
-                
-                // copy this, since we'll be changing the original as we go
-                std::vector<size_t> inc_tris = m_mesh.m_vertex_to_triangle_map[i];
-                
-                for ( size_t t = 0; t < inc_tris.size(); ++t )
-                {
-                    Vec3st triangle = m_mesh.get_triangle( inc_tris[t] );
-                    
-                    assert( triangle[0] == i || triangle[1] == i || triangle[2] == i );
-                    if ( triangle[0] == i ) { triangle[0] = j; }
-                    if ( triangle[1] == i ) { triangle[1] = j; }
-                    if ( triangle[2] == i ) { triangle[2] = j; }        
-                    
-                    remove_triangle(inc_tris[t]);       // mark the triangle deleted
-                    add_triangle(triangle);             // add the updated triangle
-                }
-                
-                ++j;
-            }
-        }
+        pm_positions[j] = pm_positions[i];
+        pm_newpositions[j] = pm_newpositions[i];
+        m_masses[j] = m_masses[i];
         
-        pm_positions.resize(j);
-        pm_newpositions.resize(j);
-        m_masses.resize(j);
+        new_vertex_index[i] = j;
+        info.m_defragged_vertex_map.push_back( Vec2st(i,j) );
+        ++j;
     }
     
+    pm_positions.resize(j);
+    pm_newpositions.resize(j);
+    m_masses.resize(j);
+    
+    //
+    // Compact the triangles, rewriting their vertex indices, then rebuild the connectivity once
     //
-    // Now clear deleted triangles from the mesh
-    // 
     
-    m_mesh.set_num_vertices( get_num_vertices() );    
-    m_mesh.clear_deleted_triangles( &info.m_defragged_triangle_map );
+    const std::vector<Vec3st>& old_tris = m_mesh.get_triangles();
+    
+    std::vector<Vec3st> new_tris;
+    new_tris.reserve( old_tris.size() );
+    info.m_defragged_triangle_map.reserve( old_tris.size() );
+    
+    for ( size_t i = 0; i < old_tris.size(); ++i )
+    {
+        if ( m_mesh.triangle_is_deleted(i) ) { continue; }
         
+        const Vec3st& t = old_tris[i];
+        assert( new_vertex_index[t[0]] != UNINITIALIZED_SIZE_T );
+        assert( new_vertex_index[t[1]] != UNINITIALIZED_SIZE_T );
+        assert( new_vertex_index[t[2]] != UNINITIALIZED_SIZE_T );
+        
+        info.m_defragged_triangle_map.push_back( Vec2st(i, new_tris.size()) );
+        new_tris.push_back( Vec3st( new_vertex_index[t[0]], new_vertex_index[t[1]], new_vertex_index[t[2]] ) );
+    }
+    
+    m_mesh.replace_all_triangles( new_tris );
+    m_mesh.set_num_vertices( j );
     
     //
     // Update data carried on the edges
@@ -400,39 +539,18 @@ void SurfTrack::defrag_mesh( )
     info.m_defragged_edge_map.clear();
     info.m_defragged_edge_map.resize( old_edges.size(), UNINITIALIZED_SIZE_T );
     
-    // First update the set of edges to point to new vertex indices
-    
     for ( size_t i = 0; i < old_edges.size(); ++i )
-    {
-        for ( int v = 0; v < 2; ++v )
-        {
-            const size_t old_v = old_edges[i][v];
-            size_t new_v = old_v;
-            
-            for ( size_t j = 0; j < info.m_defragged_vertex_map.size(); ++j )
-            {
-                if ( info.m_defragged_vertex_map[j][0] == old_v )
-                {
-                    new_v = info.m_defragged_vertex_map[j][1];
-                    assert( !m_mesh.vertex_is_deleted(new_v) );
-                    break;
-                }
-            }
-            
-            old_edges[i][v] = new_v;
-        }      
-    }
-    
-    // Now use this modified set of edges to find where the edge data maps to
-    
-    for ( unsigned int i = 0; i < old_edges.size(); ++i )
     {
         if ( old_edges[i][0] == old_edges[i][1] ) 
         { 
             continue; 
         }
         
-        size_t new_edge_index = m_mesh.get_edge_index( old_edges[i][0], old_edges[i][1] );
+        const size_t new_v0 = new_vertex_index[ old_edges[i][0] ];
+        const size_t new_v1 = new_vertex_index[ old_edges[i][1] ];
+        assert( new_v0 != UNINITIALIZED_SIZE_T && new_v1 != UNINITIALIZED_SIZE_T );
+        
+        size_t new_edge_index = m_mesh.get_edge_index( new_v0, new_v1 );
         
         // This edge has disappeared from the mesh.  This can occur when trimming non-manifold flaps.
         if ( new_edge_index == m_mesh.m_edges.size() )
@@ -442,19 +560,14 @@ void SurfTrack::defrag_mesh( )
          
         info.m_defragged_edge_map[i] = new_edge_index;
         
-        assert( new_edge_index < m_mesh.m_edges.size() );         
-        
         // If the internal storage of the edge flipped, flip it back to original
         
-        if ( old_edges[i][0] != m_mesh.m_edges[new_edge_index][0] )
+        if ( new_v0 != m_mesh.m_edges[new_edge_index][0] )
         {
-            assert( old_edges[i][1] == m_mesh.m_edges[new_edge_index][0] );
-            assert( old_edges[i][0] == m_mesh.m_edges[new_edge_index][1] );
+            assert( new_v1 == m_mesh.m_edges[new_edge_index][0] );
+            assert( new_v0 == m_mesh.m_edges[new_edge_index][1] );
             
             swap( m_mesh.m_edges[new_edge_index][0], m_mesh.m_edges[new_edge_index][1] ); 
-            
-            assert( old_edges[i][0] == m_mesh.m_edges[new_edge_index][0] );
-            assert( old_edges[i][1] == m_mesh.m_edges[new_edge_index][1] );
         }
     }
     
@@ -514,7 +627,7 @@ void SurfTrack::assert_no_degenerate_triangles( )
         
         for ( unsigned int e = 0; e < 3 && flap_found == false; ++e )
         {
-            const std::vector<size_t>& edge_tris = m_mesh.m_edge_to_triangle_map[ tri_edges[e] ];
+            const EdgeAdjacencyList& edge_tris = m_mesh.m_edge_to_triangle_map[ tri_edges[e] ];
             
             for ( size_t t = 0; t < edge_tris.size(); ++t )
             {
@@ -619,7 +732,7 @@ void SurfTrack::trim_non_manifold( std::vector<size_t>& triangle_indices )
         
         for ( unsigned int e = 0; e < 3 && flap_found == false; ++e )
         {
-            const std::vector<size_t>& edge_tris = m_mesh.m_edge_to_triangle_map[ tri_edges[e] ];
+            const EdgeAdjacencyList& edge_tris = m_mesh.m_edge_to_triangle_map[ tri_edges[e] ];
             
             for ( size_t t = 0; t < edge_tris.size(); ++t )
             {
@@ -700,6 +813,12 @@ void SurfTrack::improve_mesh( )
     if ( m_perform_improvement )
     {
         
+        // curvature-scaled edge lengths look up the curvature of each endpoint many times
+        if ( m_splitter.m_use_curvature || m_collapser.m_use_curvature )
+        {
+            m_curvature_cache.enable( *this );
+        }
+        
         // edge splitting
         m_splitter.process_mesh();
         
@@ -709,6 +828,9 @@ void SurfTrack::improve_mesh( )
         // edge collapsing
         m_collapser.process_mesh();
         
+        // smoothing moves vertices without telling the cache
+        m_curvature_cache.disable();
+        
         // null-space smoothing
         if ( m_allow_vertex_movement )
         {
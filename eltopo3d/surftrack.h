@@ -44,6 +44,9 @@ struct SurfTrackInitializationParameters
     /// Set default values for parameters which are not likely to be specified
     SurfTrackInitializationParameters();
     
+    /// Whether to output a lot of information to the console
+    bool m_verbose;
+    
     /// Elements closer than this are considered "near" (or proximate)
     double m_proximity_epsilon;
     
@@ -100,6 +103,17 @@ struct SurfTrackInitializationParameters
     /// Whether to allow mesh improvement
     bool m_perform_improvement;
     
+    /// Number of threads to use for parallelizable operations (1 = serial)
+    unsigned int m_num_threads;
+    
+    /// Whether to split, flip and collapse edges in rounds of operations which don't interfere with each other, checking
+    /// each round on m_num_threads threads.  The result doesn't depend on the number of threads, but differs from the
+    /// default mode, which checks and applies one operation at a time.
+    bool m_parallel_remeshing;
+    
+    /// Collision and intersection query implementation (cubic solver or root parity)
+    CCDBackendType m_ccd_backend;
+    
 };
 
 // ---------------------------------------------------------
@@ -170,6 +184,56 @@ struct TriangleUpdateEvent
 };
 
 
+// ---------------------------------------------------------
+///
+/// Curvature of each vertex (as computed by inv_min_radius_curvature), for curvature-scaled edge lengths.  While 
+/// enabled, the cache observes edge splits, flips and collapses, and forgets the curvature of every vertex whose 
+/// neighbourhood they change.  Forgotten curvatures are recomputed the next time they are asked for.
+///
+// ---------------------------------------------------------
+
+class VertexCurvatureCache : public EdgeSplitObserver, public EdgeFlipObserver, public EdgeCollapseObserver
+{
+    
+public:
+    
+    VertexCurvatureCache();
+    
+    /// Compute the curvature of every vertex, in parallel, and keep it up to date until disable() is called.  Only
+    /// splits, flips and collapses are tracked, so the surface must not be changed any other way while enabled.
+    ///
+    void enable( const SurfTrack& surf );
+    
+    /// Stop caching
+    ///
+    void disable();
+    
+    /// Get the curvature of a vertex.  Not thread-safe while enabled, as it may fill in a missing cache entry.
+    ///
+    double get_curvature( const SurfTrack& surf, size_t vertex ) const;
+    
+    void operationOccurred( const SurfTrack& surf, const EdgeSplitter::PostEdgeSplitInfo& info );
+    void operationOccurred( const SurfTrack& surf, const EdgeFlipper::PostEdgeFlipInfo& info );
+    void operationOccurred( const SurfTrack& surf, const EdgeCollapser::PostEdgeCollapseInfo& info );
+    
+private:
+    
+    /// Forget the curvature of the given vertex and its neighbours
+    ///
+    void invalidate_one_ring( const SurfTrack& surf, size_t vertex );
+    
+    bool m_enabled;
+    
+    mutable std::vector<double> m_curvatures;
+    mutable std::vector<char> m_is_valid;
+    
+    /// Scratch space
+    ///
+    std::vector<size_t> m_adjacent_vertices;
+    
+};
+
+
 // ---------------------------------------------------------
 ///
 /// A DynamicSurface with topological and mesh maintenance operations.
@@ -318,8 +382,18 @@ public:
     /// as well as allowing a collapsed edge to collapse down to some point other than an endpoint.
     bool m_allow_vertex_movement;
     
+    /// Check independent edge splits, flips and collapses concurrently, in rounds.  See 
+    /// SurfTrackInitializationParameters::m_parallel_remeshing.
+    bool m_parallel_remeshing;
+    
+    /// Vertex curvatures for curvature-scaled edge lengths, enabled during improve_mesh
+    VertexCurvatureCache m_curvature_cache;
+    
     std::vector<VertexUpdateEvent> m_vertex_change_history;
     std::vector<TriangleUpdateEvent> m_triangle_change_history;
+    
+    /// Where each surviving vertex and triangle went in the most recent defrag_mesh
+    PostDefragInfo m_last_defrag_info;
         
     std::vector<DefragObserver*> m_observers;
     
@@ -212,7 +212,8 @@ void compute_vertex_curvatures( const SurfTrack& surf, std::vector<double>& vert
     
     vertex_curvatures.resize( surf.get_num_vertices() );
     
-    for ( size_t i = 0; i < surf.get_num_vertices(); ++i )
+    #pragma omp parallel for schedule(static) num_threads(surf.m_num_threads)
+    for ( int i = 0; i < (int) surf.get_num_vertices(); ++i )
     {
         
         if ( surf.m_mesh.m_is_boundary_vertex[i] ) 
@@ -245,7 +246,7 @@ double get_curvature_scaled_length(const SurfTrack& surf,
     
     
 #ifdef USE_INV_MIN_RADIUS
-    double curv_a = std::fabs( inv_min_radius_curvature( surf, vertex_a ) );
+    double curv_a = std::fabs( surf.m_curvature_cache.get_curvature( surf, vertex_a ) );
 #else
     double curv_a = unsigned_vertex_mean_curvature( vertex_a, surf );
 #endif
@@ -255,7 +256,7 @@ double get_curvature_scaled_length(const SurfTrack& surf,
     curv_a = std::min( max_curvature_multiplier, curv_a );
     
 #ifdef USE_INV_MIN_RADIUS
-    double curv_b = std::fabs( inv_min_radius_curvature( surf, vertex_b ) );
+    double curv_b = std::fabs( surf.m_curvature_cache.get_curvature( surf, vertex_b ) );
 #else
     double curv_b = unsigned_vertex_mean_curvature( vertex_b, m_surf );
 #endif
@@ -85,7 +85,7 @@ void FaceOffDriver::initialize( const SurfTrack& )
 
 void FaceOffDriver::compute_quadric_metric_tensor( const std::vector<Vec3d>& triangle_normals, 
                                                   const std::vector<double>& triangle_areas, 
-                                                  const std::vector<size_t>& incident_triangles,
+                                                  const VertexAdjacencyList& incident_triangles,
                                                   Mat33d& quadric_metric_tensor ) 
 {
     std::vector< Vec3d > N;
@@ -139,7 +139,7 @@ void FaceOffDriver::compute_quadric_metric_tensor( const std::vector<Vec3d>& tri
 void FaceOffDriver::intersection_point( const std::vector<Vec3d>& triangle_normals, 
                                        const std::vector<double>& triangle_plane_distances,
                                        const std::vector<double>& triangle_areas, 
-                                       const std::vector<size_t>& incident_triangles,
+                                       const VertexAdjacencyList& incident_triangles,
                                        Vec3d& out )
 {
     
@@ -272,7 +272,7 @@ void FaceOffDriver::set_predicted_vertex_positions( const SurfTrack& surf,
         
         double sum_mu_l = 0, sum_mu = 0;
         
-        const std::vector<size_t>& incident_triangles = mesh.m_vertex_to_triangle_map[p];
+        const VertexAdjacencyList& incident_triangles = mesh.m_vertex_to_triangle_map[p];
         
         for ( size_t j = 0; j < incident_triangles.size(); ++j )
         {
@@ -15,6 +15,7 @@
 // ---------------------------------------------------------
 
 #include <meshdriver.h>
+#include <nondestructivetrimesh.h>
 #include <mat.h>
 #include <vec.h> 
 #include <vector>
@@ -62,7 +63,7 @@ public:
     ///   
     void compute_quadric_metric_tensor( const std::vector<Vec3d>& triangle_normals, 
                                        const std::vector<double>& triangle_areas, 
-                                       const std::vector<size_t>& incident_triangles,
+                                       const VertexAdjacencyList& incident_triangles,
                                        Mat33d& quadric_metric_tensor );
     
     /// Return intersection point between a set of planes in the least-squares sense
@@ -70,7 +71,7 @@ public:
     void intersection_point( const std::vector<Vec3d>& triangle_normals, 
                             const std::vector<double>& triangle_plane_distances,
                             const std::vector<double>& triangle_areas, 
-                            const std::vector<size_t>& incident_triangles,
+                            const VertexAdjacencyList& incident_triangles,
                             Vec3d& out);
     
     /// Assign a velocity vector to each mesh vertex
@@ -247,6 +247,7 @@ namespace {
         general_options.m_verbose = g_surf->m_verbose;
         general_options.m_collision_safety = g_surf->m_collision_safety;
         general_options.m_proximity_epsilon = g_surf->m_proximity_epsilon;
+        general_options.m_ccd_backend = ( g_surf->m_ccd_backend == CCD_BACKEND_ROOT_PARITY ) ? ELTOPO_CCD_ROOT_PARITY : ELTOPO_CCD_CUBIC_SOLVER;
         
         ElTopoStaticOperationsOptions options;
         options.m_perform_improvement = g_surf->m_perform_improvement;
@@ -394,6 +395,7 @@ namespace {
         general_options.m_verbose = g_surf->m_verbose;
         general_options.m_collision_safety = g_surf->m_collision_safety;
         general_options.m_proximity_epsilon = g_surf->m_proximity_epsilon;
+        general_options.m_ccd_backend = ( g_surf->m_ccd_backend == CCD_BACKEND_ROOT_PARITY ) ? ELTOPO_CCD_ROOT_PARITY : ELTOPO_CCD_CUBIC_SOLVER;
         
         ElTopoIntegrationOptions options;
         options.m_dt = dt;